@@ -6,15 +6,20 @@
 //
 #include "td/actor/actor.h"
 #include "td/actor/ConcurrentScheduler.h"
+#include "td/actor/impl/TimeoutQueue.h"
 #include "td/actor/PromiseFuture.h"
 
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
+#include "td/utils/Heap.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
+#include "td/utils/Random.h"
 #include "td/utils/SliceBuilder.h"
 
+#include <atomic>
+
 #if TD_MSVC
 #pragma comment(linker, "/STACK:16777216")
 #endif
@@ -169,6 +174,264 @@ class RingBench final : public td::Benchmark {
   }
 };
 
+class BusyActorBench final : public td::Benchmark {
+ public:
+  td::string get_description() const final {
+    return "Send to busy actor";
+  }
+
+  struct ReceiverActor final : public td::Actor {
+    int left_n = 0;
+
+    void receive(int x) {
+      if (--left_n == 0) {
+        td::Scheduler::instance()->finish();
+      }
+    }
+  };
+
+  struct SenderActor final : public td::Actor {
+    td::ActorId<ReceiverActor> receiver;
+
+    void send(int n) {
+      // all events are added to the receiver's mailbox
+      for (int i = 0; i < n; i++) {
+        send_closure_later(receiver, &ReceiverActor::receive, i);
+      }
+    }
+  };
+
+  void start_up() final {
+    scheduler_ = td::make_unique<td::ConcurrentScheduler>(0, 0);
+    receiver_ = scheduler_->create_actor_unsafe<ReceiverActor>(0, "Receiver").release();
+    sender_ = scheduler_->create_actor_unsafe<SenderActor>(0, "Sender").release();
+    sender_.get_actor_unsafe()->receiver = receiver_;
+    scheduler_->start();
+  }
+
+  void run(int n) final {
+    receiver_.get_actor_unsafe()->left_n = n;
+    {
+      auto guard = scheduler_->get_main_guard();
+      send_closure_later(sender_, &SenderActor::send, n);
+    }
+    while (scheduler_->run_main(10)) {
+      // empty
+    }
+  }
+
+  void tear_down() final {
+    scheduler_->finish();
+    scheduler_.reset();
+  }
+
+ private:
+  td::unique_ptr<td::ConcurrentScheduler> scheduler_;
+  td::ActorId<ReceiverActor> receiver_;
+  td::ActorId<SenderActor> sender_;
+};
+
+class PingPongBench final : public td::Benchmark {
+ public:
+  struct PingPongActor;
+
+ private:
+  int pair_n_ = -1;
+  td::vector<td::ActorId<PingPongActor>> actor_array_;
+  td::unique_ptr<td::ConcurrentScheduler> scheduler_;
+  static std::atomic<int> left_pair_count_;
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "PingPong between schedulers (pairs_n = " << pair_n_ << ")";
+  }
+
+  struct PingPongActor final : public td::Actor {
+    td::ActorId<PingPongActor> other;
+
+    void ping(int n) {
+      if (n == 0) {
+        if (--left_pair_count_ == 0) {
+          td::Scheduler::instance()->finish();
+        }
+        return;
+      }
+      send_closure(other, &PingPongActor::ping, n - 1);
+    }
+  };
+
+  explicit PingPongBench(int pair_n) : pair_n_(pair_n) {
+  }
+
+  void start_up() final {
+    scheduler_ = td::make_unique<td::ConcurrentScheduler>(2, 0);
+
+    actor_array_ = td::vector<td::ActorId<PingPongActor>>(2 * pair_n_);
+    for (int i = 0; i < 2 * pair_n_; i++) {
+      actor_array_[i] = scheduler_->create_actor_unsafe<PingPongActor>(i % 2 + 1, "PingPongActor").release();
+    }
+    for (int i = 0; i < 2 * pair_n_; i++) {
+      actor_array_[i].get_actor_unsafe()->other = actor_array_[i ^ 1];
+    }
+    scheduler_->start();
+  }
+
+  void run(int n) final {
+    left_pair_count_ = pair_n_;
+    {
+      auto guard = scheduler_->get_main_guard();
+      for (int i = 0; i < pair_n_; i++) {
+        send_closure(actor_array_[2 * i], &PingPongActor::ping, td::max(n / pair_n_, 1));
+      }
+    }
+    while (scheduler_->run_main(10)) {
+      // empty
+    }
+  }
+
+  void tear_down() final {
+    LOG(DEBUG) << "Saved publications: " << scheduler_->get_saved_publication_count();
+    scheduler_->finish();
+    scheduler_.reset();
+  }
+};
+
+std::atomic<int> PingPongBench::left_pair_count_;
+
+template <bool use_work_stealing>
+class WorkStealingBench final : public td::Benchmark {
+ public:
+  struct WorkActor;
+
+ private:
+  int actor_n_ = -1;
+  int thread_n_ = -1;
+  td::vector<td::ActorId<WorkActor>> actor_array_;
+  td::unique_ptr<td::ConcurrentScheduler> scheduler_;
+  static std::atomic<int> left_actor_count_;
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "WorkStealing (enabled = " << use_work_stealing << ") (actors_n = " << actor_n_
+                     << ") (threads_n = " << thread_n_ << ")";
+  }
+
+  struct WorkActor final : public td::Actor {
+    int left_n = 0;
+    td::uint32 state = 0;
+
+    void start_up() final {
+      set_migratable(use_work_stealing);
+    }
+
+    void wakeup() final {
+      for (int i = 0; i < 10000; i++) {
+        state = state * 1103515245 + 12345;
+      }
+      if (--left_n > 0) {
+        return yield();
+      }
+      if (--left_actor_count_ == 0) {
+        td::Scheduler::instance()->finish();
+      }
+    }
+
+    void run(int n) {
+      left_n = n;
+      yield();
+    }
+  };
+
+  WorkStealingBench(int actor_n, int thread_n) : actor_n_(actor_n), thread_n_(thread_n) {
+  }
+
+  void start_up() final {
+    scheduler_ = td::make_unique<td::ConcurrentScheduler>(thread_n_, 0);
+    if (use_work_stealing) {
+      scheduler_->enable_work_stealing();
+    }
+
+    // all actors are created on the same scheduler, which becomes overloaded
+    actor_array_ = td::vector<td::ActorId<WorkActor>>(actor_n_);
+    for (int i = 0; i < actor_n_; i++) {
+      actor_array_[i] = scheduler_->create_actor_unsafe<WorkActor>(thread_n_ ? 1 : 0, "WorkActor").release();
+    }
+    scheduler_->start();
+  }
+
+  void run(int n) final {
+    left_actor_count_ = actor_n_;
+    {
+      auto guard = scheduler_->get_main_guard();
+      for (auto &actor_id : actor_array_) {
+        send_closure(actor_id, &WorkActor::run, td::max(n / actor_n_, 1));
+      }
+    }
+    while (scheduler_->run_main(10)) {
+      // empty
+    }
+  }
+
+  void tear_down() final {
+    LOG(DEBUG) << "Stolen actors: " << scheduler_->get_stolen_actor_count();
+    scheduler_->finish();
+    scheduler_.reset();
+  }
+};
+
+template <bool use_work_stealing>
+std::atomic<int> WorkStealingBench<use_work_stealing>::left_actor_count_;
+
+template <bool use_timer_wheel>
+class TimeoutQueueBench final : public td::Benchmark {
+  int timer_n_ = -1;
+  td::vector<td::HeapNode> nodes_;
+  td::TimeoutQueue timeout_queue_;
+  td::Random::Xorshift128plus rnd_{123};
+  double now_ = 1000.0;
+
+  double get_timeout_at() {
+    // timeouts are uniformly distributed over the next 100 seconds
+    return now_ + rnd_.fast(0, 99999) * 0.001;
+  }
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "TimeoutQueue (timer_wheel = " << use_timer_wheel << ") (timers_n = " << timer_n_ << ")";
+  }
+
+  explicit TimeoutQueueBench(int timer_n) : timer_n_(timer_n) {
+  }
+
+  void start_up() final {
+    timeout_queue_.set_use_timer_wheel(use_timer_wheel);
+    nodes_ = td::vector<td::HeapNode>(timer_n_);
+    for (auto &node : nodes_) {
+      timeout_queue_.set_timeout_at(get_timeout_at(), &node);
+    }
+  }
+
+  void run(int n) final {
+    // each iteration reschedules a random timer; time advances by 1 millisecond every 16 iterations
+    for (int i = 0; i < n; i++) {
+      timeout_queue_.set_timeout_at(get_timeout_at(), &nodes_[rnd_.fast(0, timer_n_ - 1)]);
+      if (i % 16 == 15) {
+        now_ += 0.001;
+        while (td::HeapNode *node = timeout_queue_.pop_expired(now_)) {
+          timeout_queue_.set_timeout_at(get_timeout_at(), node);
+        }
+      }
+    }
+  }
+
+  void tear_down() final {
+    while (!timeout_queue_.empty()) {
+      timeout_queue_.pop();
+    }
+    nodes_.clear();
+  }
+};
+
 template <int type>
 class QueryBench final : public td::Benchmark {
  public:
@@ -339,6 +602,7 @@ int main() {
   bench(QueryBench<2>());
   bench(QueryBench<1>());
   bench(QueryBench<0>());
+  bench(BusyActorBench());
   bench(RingBench<3>(504, 0));
   bench(RingBench<0>(504, 10));
   bench(RingBench<1>(504, 10));
@@ -346,4 +610,12 @@ int main() {
   bench(RingBench<0>(504, 2));
   bench(RingBench<1>(504, 2));
   bench(RingBench<2>(504, 2));
+  bench(PingPongBench(1));
+  bench(PingPongBench(100));
+  bench(WorkStealingBench<false>(100, 4));
+  bench(WorkStealingBench<true>(100, 4));
+  bench(WorkStealingBench<false>(100, 8));
+  bench(WorkStealingBench<true>(100, 8));
+  bench(TimeoutQueueBench<false>(1000000));
+  bench(TimeoutQueueBench<true>(1000000));
 }
@@ -0,0 +1,353 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/Client.h"
+#include "td/telegram/ClientBinary.h"
+#include "td/telegram/ClientJson.h"
+#include "td/telegram/td_api.h"
+#include "td/telegram/td_api_json.h"
+
+#include "td/utils/benchmark.h"
+#include "td/utils/common.h"
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/misc.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <cstddef>
+
+class ClientManagerBench final : public td::Benchmark {
+  int client_n_ = -1;
+  int instance_n_ = -1;
+  int thread_n_ = -1;
+  td::unique_ptr<td::ClientManager> client_manager_;
+  td::vector<td::ClientManager::ClientId> client_ids_;
+  td::uint64 last_request_id_ = 0;
+
+  // receives responses and updates until the specified number of responses to requests and closed clients is received
+  void wait_responses(int response_n, int closed_client_n) {
+    while (response_n > 0 || closed_client_n > 0) {
+      auto response = client_manager_->receive(10.0);
+      if (response.object == nullptr) {
+        continue;
+      }
+      if (response.request_id != 0) {
+        response_n--;
+      } else if (response.object->get_id() == td::td_api::updateAuthorizationState::ID &&
+                 static_cast<const td::td_api::updateAuthorizationState *>(response.object.get())
+                         ->authorization_state_->get_id() == td::td_api::authorizationStateClosed::ID) {
+        closed_client_n--;
+      }
+    }
+  }
+
+ public:
+  ClientManagerBench(int client_n, int instance_n, int thread_n)
+      : client_n_(client_n), instance_n_(instance_n), thread_n_(thread_n) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "ClientManager (clients_n = " << client_n_ << ") (instances_n = " << instance_n_
+                     << ") (threads_n = " << thread_n_ << ")";
+  }
+
+  void start_up() final {
+    td::ClientManager::ThreadOptions thread_options;
+    thread_options.instance_count = instance_n_;
+    thread_options.additional_thread_count = thread_n_;
+    td::ClientManager::set_thread_options(thread_options);
+
+    client_manager_ = td::make_unique<td::ClientManager>();
+    for (int i = 0; i < client_n_; i++) {
+      auto client_id = client_manager_->create_client_id();
+      client_ids_.push_back(client_id);
+      client_manager_->send(client_id, ++last_request_id_, td::td_api::make_object<td::td_api::getOption>("version"));
+    }
+    wait_responses(client_n_, 0);
+  }
+
+  void run(int n) final {
+    // keep several requests in flight for every client, so all threads are loaded
+    int max_in_flight_n = client_n_ * 4;
+    int sent_n = 0;
+    while (sent_n < n) {
+      int batch_n = td::min(n - sent_n, max_in_flight_n);
+      for (int i = 0; i < batch_n; i++) {
+        auto client_id = client_ids_[static_cast<size_t>(sent_n + i) % client_ids_.size()];
+        client_manager_->send(client_id, ++last_request_id_, td::td_api::make_object<td::td_api::testSquareInt>(i));
+      }
+      sent_n += batch_n;
+      wait_responses(batch_n, 0);
+    }
+  }
+
+  void tear_down() final {
+    for (auto client_id : client_ids_) {
+      client_manager_->send(client_id, ++last_request_id_, td::td_api::make_object<td::td_api::close>());
+    }
+    wait_responses(0, client_n_);
+    client_ids_.clear();
+    client_manager_.reset();
+  }
+};
+
+template <bool use_batch>
+class ClientManagerReceiveBench final : public td::Benchmark {
+  static constexpr int CLIENT_COUNT = 4;
+  static constexpr std::size_t MAX_BATCH_SIZE = 1000;
+
+  td::unique_ptr<td::ClientManager> client_manager_;
+  td::vector<td::ClientManager::ClientId> client_ids_;
+  td::uint64 last_request_id_ = 0;
+
+  // returns the number of received responses to requests
+  int receive_responses() {
+    int response_n = 0;
+    if (use_batch) {
+      for (auto &response : client_manager_->receive_batch(MAX_BATCH_SIZE, 10.0)) {
+        if (response.request_id != 0) {
+          response_n++;
+        }
+      }
+    } else {
+      auto response = client_manager_->receive(10.0);
+      if (response.object != nullptr && response.request_id != 0) {
+        response_n++;
+      }
+    }
+    return response_n;
+  }
+
+  void wait_closed_clients() {
+    int closed_client_n = 0;
+    while (closed_client_n < CLIENT_COUNT) {
+      auto response = client_manager_->receive(10.0);
+      if (response.object != nullptr && response.request_id == 0 &&
+          response.object->get_id() == td::td_api::updateAuthorizationState::ID &&
+          static_cast<const td::td_api::updateAuthorizationState *>(response.object.get())
+                  ->authorization_state_->get_id() == td::td_api::authorizationStateClosed::ID) {
+        closed_client_n++;
+      }
+    }
+  }
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "ClientManager " << (use_batch ? "receive_batch" : "receive");
+  }
+
+  void start_up() final {
+    client_manager_ = td::make_unique<td::ClientManager>();
+    for (int i = 0; i < CLIENT_COUNT; i++) {
+      auto client_id = client_manager_->create_client_id();
+      client_ids_.push_back(client_id);
+      client_manager_->send(client_id, ++last_request_id_, td::td_api::make_object<td::td_api::getOption>("version"));
+    }
+    int response_n = 0;
+    while (response_n < CLIENT_COUNT) {
+      response_n += receive_responses();
+    }
+  }
+
+  void run(int n) final {
+    // all responses are sent at once, so there are many of them available simultaneously like updates in a busy bot
+    for (int i = 0; i < n; i++) {
+      auto client_id = client_ids_[static_cast<std::size_t>(i) % client_ids_.size()];
+      client_manager_->send(client_id, ++last_request_id_, td::td_api::make_object<td::td_api::testSquareInt>(i));
+    }
+    int response_n = 0;
+    while (response_n < n) {
+      response_n += receive_responses();
+    }
+  }
+
+  void tear_down() final {
+    for (auto client_id : client_ids_) {
+      client_manager_->send(client_id, ++last_request_id_, td::td_api::make_object<td::td_api::close>());
+    }
+    wait_closed_clients();
+    client_ids_.clear();
+    client_manager_.reset();
+  }
+};
+
+template <bool use_binary>
+class ClientInterfaceBench final : public td::Benchmark {
+  int client_id_ = 0;
+  td::uint64 last_request_id_ = 0;
+
+  void send_request(td::int32 constructor_id, td::int32 x) {
+    if (use_binary) {
+      td::int32 request[] = {constructor_id, x};
+      auto request_size = constructor_id == td::td_api::testSquareInt::ID ? sizeof(request) : sizeof(td::int32);
+      td::binary_send(client_id_, ++last_request_id_, td::Slice(reinterpret_cast<const char *>(request), request_size));
+    } else if (constructor_id == td::td_api::testSquareInt::ID) {
+      td::json_send(client_id_, PSLICE() << "{\"@type\":\"testSquareInt\",\"x\":" << x << ",\"@extra\":" << x << '}');
+    } else {
+      td::json_send(client_id_, "{\"@type\":\"close\"}");
+    }
+  }
+
+  // returns true, if a response to a request was received
+  bool receive_response(bool &is_closed) {
+    if (use_binary) {
+      int client_id = 0;
+      td::uint64 request_id = 0;
+      auto response = td::binary_receive(10.0, client_id, request_id);
+      if (response.size() >= 2 * sizeof(td::int32) && request_id == 0) {
+        auto ids = reinterpret_cast<const td::int32 *>(response.data());
+        is_closed =
+            ids[0] == td::td_api::updateAuthorizationState::ID && ids[1] == td::td_api::authorizationStateClosed::ID;
+      }
+      return !response.empty() && request_id != 0;
+    }
+    auto response = td::Slice(td::json_receive(10.0));
+    if (response.empty()) {
+      return false;
+    }
+    is_closed = td::begins_with(response, "{\"@type\":\"updateAuthorizationState\",\"authorization_state\":{\"@type\":"
+                                          "\"authorizationStateClosed\"");
+    return td::begins_with(response, "{\"@type\":\"testInt\"");
+  }
+
+  void wait_responses(int response_n) {
+    bool is_closed = false;
+    while (response_n > 0) {
+      if (receive_response(is_closed)) {
+        response_n--;
+      }
+    }
+  }
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << (use_binary ? "Binary" : "JSON") << " client interface";
+  }
+
+  void start_up() final {
+    client_id_ = use_binary ? td::binary_create_client_id() : td::json_create_client_id();
+    send_request(td::td_api::testSquareInt::ID, 1);
+    wait_responses(1);
+  }
+
+  void run(int n) final {
+    int sent_n = 0;
+    while (sent_n < n) {
+      int batch_n = td::min(n - sent_n, 1000);
+      for (int i = 0; i < batch_n; i++) {
+        send_request(td::td_api::testSquareInt::ID, i);
+      }
+      sent_n += batch_n;
+      wait_responses(batch_n);
+    }
+  }
+
+  void tear_down() final {
+    send_request(td::td_api::close::ID, 0);
+    bool is_closed = false;
+    while (!is_closed) {
+      receive_response(is_closed);
+    }
+  }
+};
+
+static td::td_api::object_ptr<td::td_api::file> get_file_object() {
+  return td::td_api::make_object<td::td_api::file>(
+      12345, 123456, 123456,
+      td::td_api::make_object<td::td_api::localFile>(
+          "/android/data/0/data/org.telegram.data/files/photos/12345678901234567890_123.jpg", true, true, false, true,
+          0, 123456, 123456),
+      td::td_api::make_object<td::td_api::remoteFile>("abacabadabacabaeabacabadabacabafabacabadabacabaeabacabadabacaba",
+                                                      "abacabadabacabaeabacabadabacaba", false, true, 123456));
+}
+
+static td::td_api::object_ptr<td::td_api::message> get_message_object(td::int64 message_id) {
+  auto message = td::td_api::make_object<td::td_api::message>();
+  message->id_ = message_id;
+  message->sender_id_ = td::td_api::make_object<td::td_api::messageSenderUser>(123456000112);
+  message->chat_id_ = 123456000112;
+  message->date_ = 1699999999;
+  auto photo = td::td_api::make_object<td::td_api::photo>();
+  for (int i = 0; i < 4; i++) {
+    photo->sizes_.push_back(td::td_api::make_object<td::td_api::photoSize>(
+        "a", get_file_object(), 160, 160,
+        td::vector<td::int32>{10000, 20000, 30000, 50000, 70000, 90000, 120000, 150000, 180000, 220000}));
+  }
+  message->content_ = td::td_api::make_object<td::td_api::messagePhoto>(
+      std::move(photo), td::td_api::make_object<td::td_api::formattedText>(), false, false, false);
+  return message;
+}
+
+enum class ResponseEncoding : td::int32 { JsonEncode, JsonBuffer, Binary };
+
+template <ResponseEncoding encoding>
+class ResponseEncodingBench final : public td::Benchmark {
+  int message_n_ = 0;
+  td::td_api::object_ptr<td::td_api::messages> messages_;
+
+ public:
+  explicit ResponseEncodingBench(int message_n) : message_n_(message_n) {
+  }
+
+  td::string get_description() const final {
+    const char *names[] = {"JSON response json_encode", "JSON response reused buffer", "Binary response"};
+    return PSTRING() << names[static_cast<td::int32>(encoding)] << " (messages_n = " << message_n_ << ")";
+  }
+
+  void start_up() final {
+    messages_ = td::td_api::make_object<td::td_api::messages>();
+    messages_->total_count_ = message_n_;
+    for (int i = 0; i < message_n_; i++) {
+      messages_->messages_.push_back(get_message_object(123456000111 + i));
+    }
+  }
+
+  void run(int n) final {
+    std::size_t res = 0;
+    for (int i = 0; i < n; i++) {
+      switch (encoding) {
+        case ResponseEncoding::JsonEncode:
+          res += td::json_encode<td::string>(td::ToJson(*messages_)).size();
+          break;
+        case ResponseEncoding::JsonBuffer:
+          res += td::json_encode_response(*messages_, "\"extra\"", 1).size();
+          break;
+        case ResponseEncoding::Binary:
+          res += td::binary_encode_object(*messages_).size();
+          break;
+      }
+    }
+    td::do_not_optimize_away(res);
+  }
+
+  void tear_down() final {
+    messages_ = nullptr;
+  }
+};
+
+int main() {
+  td::ClientManager::execute(td::td_api::make_object<td::td_api::setLogVerbosityLevel>(1));
+
+  td::bench(ClientInterfaceBench<false>());
+  td::bench(ClientInterfaceBench<true>());
+
+  td::bench(ClientManagerReceiveBench<false>());
+  td::bench(ClientManagerReceiveBench<true>());
+
+  for (int message_n : {1, 100, 1000}) {
+    td::bench(ResponseEncodingBench<ResponseEncoding::JsonEncode>(message_n));
+    td::bench(ResponseEncodingBench<ResponseEncoding::JsonBuffer>(message_n));
+    td::bench(ResponseEncodingBench<ResponseEncoding::Binary>(message_n));
+  }
+
+  for (int client_n : {100, 1000}) {
+    td::bench(ClientManagerBench(client_n, 1, 0));
+    td::bench(ClientManagerBench(client_n, 1, 3));
+    td::bench(ClientManagerBench(client_n, 4, 0));
+    td::bench(ClientManagerBench(client_n, 4, 3));
+    td::bench(ClientManagerBench(client_n, 0, 3));
+  }
+}
@@ -0,0 +1,151 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/mtproto/ContainerPacker.h"
+#include "td/mtproto/MessageId.h"
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/Slice.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+// replays the packing loop of SessionConnection over a simulated link with the given RTT and bandwidth;
+// a stand-in for the MTProto server immediately acknowledges every received packet
+class ContainerPackerSimulation {
+ public:
+  struct Link {
+    td::Slice name;
+    double rtt;
+    double bandwidth;  // bytes per second
+  };
+
+  ContainerPackerSimulation(Link link, bool is_adaptive)
+      : link_(link), is_adaptive_(is_adaptive), packer_(is_adaptive) {
+  }
+
+  void run(size_t query_count, double load) {
+    td::Random::Xorshift128plus rnd(123);
+    // most queries are small, but some of them are big
+    auto get_query_size = [&rnd] {
+      return static_cast<size_t>(rnd.fast(0, 9) == 0 ? rnd.fast(2000, 8000) : rnd.fast(100, 400));
+    };
+    static constexpr double AVERAGE_QUERY_SIZE = 0.9 * 250 + 0.1 * 5000;
+    auto mean_interval = AVERAGE_QUERY_SIZE / (link_.bandwidth * load);
+
+    double next_query_at = 0.0;
+    size_t created_query_count = 0;
+    while (created_query_count < query_count || !pending_queries_.empty() || !acks_.empty()) {
+      double now = 1e100;
+      if (created_query_count < query_count) {
+        now = next_query_at;
+      }
+      if (!pending_queries_.empty()) {
+        now = td::min(now, flush_at_);
+      }
+      if (!acks_.empty()) {
+        now = td::min(now, acks_.begin()->first);
+      }
+
+      if (!acks_.empty() && acks_.begin()->first == now) {
+        packer_.on_message_ack(acks_.begin()->second, now);
+        acks_.erase(acks_.begin());
+        continue;
+      }
+      if (!pending_queries_.empty() && flush_at_ == now) {
+        flush(now);
+        continue;
+      }
+
+      auto size = get_query_size();
+      pending_queries_.emplace_back(now, size);
+      pending_size_ += size;
+      created_query_count++;
+      auto flush_at = now + packer_.get_flush_delay(pending_size_, now);
+      if (pending_queries_.size() == 1 || flush_at < flush_at_) {
+        flush_at_ = flush_at;
+      }
+      next_query_at = now - std::log(1.0 - rnd.fast(0, 999999) * 1e-6) * mean_interval;
+    }
+  }
+
+  void print_results() const {
+    auto latencies = latencies_;
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0.0;
+    for (auto latency : latencies) {
+      sum += latency;
+    }
+    LOG(PLAIN) << link_.name << (is_adaptive_ ? " adaptive" : " fixed   ")
+               << ": average latency = " << sum / static_cast<double>(latencies.size()) * 1000
+               << "ms, 99% latency = " << latencies[latencies.size() * 99 / 100] * 1000 << "ms, "
+               << packer_.get_stats();
+  }
+
+ private:
+  static constexpr size_t PACKET_OVERHEAD = 100;  // MTProto header, padding, transport and TCP/IP headers
+  static constexpr size_t MAX_QUERY_COUNT = 1000;
+
+  Link link_;
+  bool is_adaptive_;
+  td::mtproto::ContainerPacker packer_;
+
+  td::vector<std::pair<double, size_t>> pending_queries_;
+  size_t pending_size_ = 0;
+  double flush_at_ = 0.0;
+  double link_free_at_ = 0.0;
+  td::uint64 next_message_id_ = 1;
+  std::multimap<double, td::mtproto::MessageId> acks_;
+  td::vector<double> latencies_;
+
+  void flush(double now) {
+    auto max_container_size = packer_.get_max_container_size();
+    size_t send_till = 0;
+    size_t send_size = 0;
+    while (send_till < pending_queries_.size() && send_till < MAX_QUERY_COUNT && send_size < max_container_size) {
+      send_size += pending_queries_[send_till].second;
+      send_till++;
+    }
+
+    auto packet_size = send_size + PACKET_OVERHEAD;
+    link_free_at_ = td::max(link_free_at_, now) + static_cast<double>(packet_size) / link_.bandwidth;
+    auto received_at = link_free_at_ + link_.rtt * 0.5;
+    for (size_t i = 0; i < send_till; i++) {
+      latencies_.push_back(received_at - pending_queries_[i].first);
+    }
+    pending_queries_.erase(pending_queries_.begin(), pending_queries_.begin() + send_till);
+    pending_size_ -= send_size;
+
+    td::mtproto::MessageId message_id(next_message_id_++);
+    acks_.emplace(received_at + link_.rtt * 0.5, message_id);
+    packer_.on_packet_sent({message_id}, packet_size, send_size, send_till, !pending_queries_.empty(), now);
+
+    if (!pending_queries_.empty()) {
+      flush_at_ = now;
+    }
+  }
+};
+
+int main() {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  for (auto link : {ContainerPackerSimulation::Link{"LAN      ", 0.001, 100e6},
+                    ContainerPackerSimulation::Link{"mobile   ", 0.15, 1e6},
+                    ContainerPackerSimulation::Link{"satellite", 0.6, 2e5}}) {
+    for (auto load : {0.3, 0.8}) {
+      LOG(PLAIN) << "Load " << load;
+      for (auto is_adaptive : {false, true}) {
+        ContainerPackerSimulation simulation(link, is_adaptive);
+        simulation.run(100000, load);
+        simulation.print_results();
+      }
+    }
+  }
+}
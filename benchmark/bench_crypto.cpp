@@ -373,6 +373,50 @@ class AesIgeShortBench final : public td::Benchmark {
   }
 };
 
+template <bool use_batch>
+class AesIgeBatchDecryptBench final : public td::Benchmark {
+ public:
+  static constexpr size_t MESSAGE_COUNT = 8;
+
+  explicit AesIgeBatchDecryptBench(size_t message_size) : message_size_(message_size) {
+  }
+
+  std::string get_description() const final {
+    return PSTRING() << "AES IGE OpenSSL decrypt " << (use_batch ? "batch" : "one by one") << " [" << MESSAGE_COUNT
+                     << "x" << message_size_ << "B]";
+  }
+
+  void start_up() final {
+    for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+      messages_[i] = std::string(message_size_, static_cast<char>(123));
+      td::Random::secure_bytes(as_mutable_slice(keys_[i]));
+      td::Random::secure_bytes(as_mutable_slice(ivs_[i]));
+    }
+  }
+
+  void run(int n) final {
+    for (int i = 0; i < n; i++) {
+      if (use_batch) {
+        td::AesIgeBatchItem items[MESSAGE_COUNT];
+        for (size_t j = 0; j < MESSAGE_COUNT; j++) {
+          items[j] = {as_slice(keys_[j]), as_mutable_slice(ivs_[j]), messages_[j], messages_[j]};
+        }
+        td::aes_ige_decrypt_batch(items);
+      } else {
+        for (size_t j = 0; j < MESSAGE_COUNT; j++) {
+          td::aes_ige_decrypt(as_slice(keys_[j]), as_mutable_slice(ivs_[j]), messages_[j], messages_[j]);
+        }
+      }
+    }
+  }
+
+ private:
+  size_t message_size_;
+  std::string messages_[MESSAGE_COUNT];
+  td::UInt256 keys_[MESSAGE_COUNT];
+  td::UInt256 ivs_[MESSAGE_COUNT];
+};
+
 BENCH(Rand, "std_rand") {
   int res = 0;
   for (int i = 0; i < n; i++) {
@@ -501,6 +545,10 @@ int main() {
   td::bench(AesIgeShortBench<false>());
   td::bench(AesIgeEncryptBench());
   td::bench(AesIgeDecryptBench());
+  td::bench(AesIgeBatchDecryptBench<false>(1 << 10));
+  td::bench(AesIgeBatchDecryptBench<true>(1 << 10));
+  td::bench(AesIgeBatchDecryptBench<false>(DATA_SIZE));
+  td::bench(AesIgeBatchDecryptBench<true>(DATA_SIZE));
   td::bench(AesEcbBench());
 
   td::bench(Pbkdf2Bench());
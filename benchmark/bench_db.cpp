@@ -21,11 +21,16 @@
 #include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Random.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 
+#include <atomic>
 #include <memory>
+#include <utility>
 
 template <class KeyValueT>
 class TdKvBench final : public td::Benchmark {
@@ -142,25 +147,130 @@ static td::Status init_db(td::SqliteDb &db) {
   return td::Status::OK();
 }
 
+// repeated execution of a simple query, which is either prepared every time or taken from the statement cache
+template <bool use_cache>
+class SqliteStatementCacheBench final : public td::Benchmark {
+  td::SqliteDb db;
+  td::string get_description() const final {
+    return PSTRING() << "SqliteStatement " << td::tag("use_cache", use_cache);
+  }
+  void start_up() final {
+    td::string path = "testdb.sqlite";
+    td::SqliteDb::destroy(path).ignore();
+    db = td::SqliteDb::open_with_key(path, true, td::DbKey::empty()).move_as_ok();
+    init_db(db).ensure();
+    db.exec("CREATE TABLE IF NOT EXISTS KV (k INT PRIMARY KEY, v BLOB)").ensure();
+    for (int i = 0; i < 10; i++) {
+      db.exec(PSLICE() << "INSERT INTO KV (k, v) VALUES(" << i << ", '" << i << "')").ensure();
+    }
+  }
+  void run(int n) final {
+    td::CSlice query = "SELECT v FROM KV WHERE k = ?1";
+    td::SqliteStatement uncached_stmt;
+    for (int i = 0; i < n; i++) {
+      td::SqliteStatement *stmt = nullptr;
+      if (use_cache) {
+        stmt = db.get_cached_statement(query).move_as_ok();
+      } else {
+        uncached_stmt = db.get_statement(query).move_as_ok();
+        stmt = &uncached_stmt;
+      }
+      stmt->bind_int32(1, i % 10).ensure();
+      stmt->step().ensure();
+      CHECK(stmt->has_row());
+      stmt->reset();
+    }
+  }
+  void tear_down() final {
+    db.close();
+  }
+};
+
+// insertion of rows in transactions of 100 rows, using either a statement prepared for every row or a batch execution
+template <bool use_batch>
+class SqliteBatchInsertBench final : public td::Benchmark {
+  td::SqliteDb db;
+  td::string get_description() const final {
+    return PSTRING() << "SqliteBatchInsert " << td::tag("use_batch", use_batch);
+  }
+  void start_up() final {
+    td::string path = "testdb.sqlite";
+    td::SqliteDb::destroy(path).ignore();
+    db = td::SqliteDb::open_with_key(path, true, td::DbKey::empty()).move_as_ok();
+    init_db(db).ensure();
+    db.exec("CREATE TABLE IF NOT EXISTS KV (k INT PRIMARY KEY, v BLOB)").ensure();
+  }
+  void run(int n) final {
+    td::CSlice query = "REPLACE INTO KV (k, v) VALUES(?1, ?2)";
+    auto bind_row = [](td::SqliteStatement &stmt, const std::pair<int, td::string> &row) {
+      TRY_STATUS(stmt.bind_int32(1, row.first));
+      return stmt.bind_blob(2, row.second);
+    };
+    td::vector<std::pair<int, td::string>> rows;
+    for (int i = 0; i < n; i += 100) {
+      rows.clear();
+      for (int j = i; j < n && j < i + 100; j++) {
+        rows.emplace_back(j % 10000, td::string(100, 'a'));
+      }
+      db.begin_write_transaction().ensure();
+      if (use_batch) {
+        db.get_cached_statement(query).move_as_ok()->execute_batch(td::as_span(rows), bind_row).ensure();
+      } else {
+        for (auto &row : rows) {
+          auto stmt = db.get_statement(query).move_as_ok();
+          bind_row(stmt, row).ensure();
+          stmt.step().ensure();
+        }
+      }
+      db.commit_transaction().ensure();
+    }
+  }
+  void tear_down() final {
+    db.close();
+  }
+};
+
+// mixed load of PMC-like objects, half of queries are reads; some objects are much more popular than the others
 class SqliteKeyValueAsyncBench final : public td::Benchmark {
  public:
+  explicit SqliteKeyValueAsyncBench(bool is_adaptive) : is_adaptive_(is_adaptive) {
+  }
+
   td::string get_description() const final {
-    return "SqliteKeyValueAsync";
+    return PSTRING() << "SqliteKeyValueAsync " << td::tag("is_adaptive", is_adaptive_);
   }
   void start_up() final {
     do_start_up().ensure();
     scheduler_->start();
   }
   void run(int n) final {
-    auto guard = scheduler_->get_main_guard();
+    std::atomic<int> left_count{n};
+    {
+      auto guard = scheduler_->get_main_guard();
 
-    for (int i = 0; i < n; i++) {
-      auto key = td::to_string(i % 10);
-      auto value = td::to_string(i);
-      sqlite_kv_async_->set(key, value, td::Auto());
+      for (int i = 0; i < n; i++) {
+        auto key_id = td::Random::fast(0, 1) == 0 ? td::Random::fast(0, 99) : td::Random::fast(0, 99999);
+        auto key = PSTRING() << "us" << key_id;
+        if (td::Random::fast(0, 1) == 0) {
+          sqlite_kv_async_->get(key, td::PromiseCreator::lambda([&left_count](td::string value) { left_count--; }));
+        } else {
+          sqlite_kv_async_->set(key, td::string(td::Random::fast(100, 300), 'a'),
+                                td::PromiseCreator::lambda([&left_count](td::Unit) { left_count--; }));
+        }
+      }
+    }
+    while (left_count.load() != 0) {
+      scheduler_->run_main(0.01);
     }
   }
   void tear_down() final {
+    {
+      auto guard = scheduler_->get_main_guard();
+      sqlite_kv_async_->get_stats(td::PromiseCreator::lambda([description = get_description()](
+                                                                 td::SqliteKeyValueAsyncInterface::Stats stats) {
+        LOG(ERROR) << description << ": " << stats;
+      }));
+    }
     scheduler_->run_main(0.1);
     {
       auto guard = scheduler_->get_main_guard();
@@ -178,6 +288,7 @@ class SqliteKeyValueAsyncBench final : public td::Benchmark {
   std::shared_ptr<td::SqliteConnectionSafe> sql_connection_;
   std::shared_ptr<td::SqliteKeyValueSafe> sqlite_kv_safe_;
   td::unique_ptr<td::SqliteKeyValueAsyncInterface> sqlite_kv_async_;
+  bool is_adaptive_;
 
   td::Status do_start_up() {
     scheduler_ = td::make_unique<td::ConcurrentScheduler>(1, 0);
@@ -193,7 +304,7 @@ class SqliteKeyValueAsyncBench final : public td::Benchmark {
     TRY_STATUS(init_db(db));
 
     sqlite_kv_safe_ = std::make_shared<td::SqliteKeyValueSafe>("common", sql_connection_);
-    sqlite_kv_async_ = create_sqlite_key_value_async(sqlite_kv_safe_, 0);
+    sqlite_kv_async_ = create_sqlite_key_value_async(sqlite_kv_safe_, 0, is_adaptive_);
 
     return td::Status::OK();
   }
@@ -239,6 +350,11 @@ int main() {
   bench(BinlogKeyValueBench<false>());
   bench(SqliteKVBench<false>());
   bench(SqliteKVBench<true>());
-  bench(SqliteKeyValueAsyncBench());
+  bench(SqliteStatementCacheBench<false>());
+  bench(SqliteStatementCacheBench<true>());
+  bench(SqliteBatchInsertBench<false>());
+  bench(SqliteBatchInsertBench<true>());
+  bench(SqliteKeyValueAsyncBench(false));
+  bench(SqliteKeyValueAsyncBench(true));
   bench(SeqKvBench());
 }
@@ -14,46 +14,146 @@
 
 #include "td/utils/buffer.h"
 #include "td/utils/BufferedFd.h"
+#include "td/utils/common.h"
+#include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/IPAddress.h"
 #include "td/utils/port/SocketFd.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+#include "td/utils/Time.h"
 
 static int cnt = 0;
 
+static td::string response;
+
+static td::string create_response(td::Slice content) {
+  td::HttpHeaderCreator hc;
+  hc.init_ok();
+  hc.set_keep_alive();
+  hc.set_content_size(content.size());
+  hc.add_header("Server", "TDLib/test");
+  hc.add_header("Date", "Thu Dec 14 01:41:50 2017");
+  hc.add_header("Content-Type:", "text/html");
+
+  // the content can be bigger than the header buffer
+  auto res = hc.finish();
+  LOG_IF(FATAL, res.is_error()) << res.error();
+  return res.ok().str() + content.str();
+}
+
 class HelloWorld final : public td::HttpInboundConnection::Callback {
  public:
   void handle(td::unique_ptr<td::HttpQuery> query, td::ActorOwn<td::HttpInboundConnection> connection) final {
     // LOG(ERROR) << *query;
-    td::HttpHeaderCreator hc;
-    td::Slice content = "hello world";
-    //auto content = td::BufferSlice("hello world");
-    hc.init_ok();
-    hc.set_keep_alive();
-    hc.set_content_size(content.size());
-    hc.add_header("Server", "TDLib/test");
-    hc.add_header("Date", "Thu Dec 14 01:41:50 2017");
-    hc.add_header("Content-Type:", "text/html");
-
-    auto res = hc.finish(content);
-    LOG_IF(FATAL, res.is_error()) << res.error();
-    send_closure(connection, &td::HttpInboundConnection::write_next, td::BufferSlice(res.ok()));
+    send_closure(connection, &td::HttpInboundConnection::write_next, td::BufferSlice(response));
     send_closure(connection.release(), &td::HttpInboundConnection::write_ok);
   }
   void hangup() final {
-    LOG(ERROR) << "CLOSE " << cnt--;
+    LOG(INFO) << "CLOSE " << cnt--;
     stop();
   }
 };
 
+// sends queries through one keep-alive connection, keeping several queries in flight
+class HttpClient final : public td::Actor {
+ public:
+  HttpClient(td::SocketFd fd, int query_count, td::ActorShared<> parent)
+      : fd_(std::move(fd)), query_count_(query_count), parent_(std::move(parent)) {
+  }
+
+ private:
+  static constexpr int MAX_PENDING_QUERY_COUNT = 16;
+
+  td::BufferedFd<td::SocketFd> fd_;
+  int query_count_;
+  int sent_query_count_ = 0;
+  size_t received_size_ = 0;
+  size_t response_size_ = response.size();
+  td::ActorShared<> parent_;
+
+  void start_up() final {
+    td::Scheduler::subscribe(fd_.get_poll_info().extract_pollable_fd(this));
+    loop();
+  }
+  void tear_down() final {
+    td::Scheduler::unsubscribe_before_close(fd_.get_poll_info().get_pollable_fd_ref());
+    fd_.close();
+  }
+
+  void loop() final {
+    sync_with_poll(fd_);
+    auto status = [&] {
+      TRY_STATUS(fd_.flush_read());
+      auto &input = fd_.input_buffer();
+      received_size_ += input.size();
+      input.advance(input.size());
+
+      auto answered_query_count = static_cast<int>(received_size_ / response_size_);
+      if (answered_query_count == query_count_) {
+        return td::Status::OK();
+      }
+      while (sent_query_count_ < query_count_ && sent_query_count_ - answered_query_count < MAX_PENDING_QUERY_COUNT) {
+        fd_.output_buffer().append("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        sent_query_count_++;
+      }
+      TRY_STATUS(fd_.flush_write());
+      return td::Status::OK();
+    }();
+    if (status.is_error()) {
+      LOG(ERROR) << "Receive " << status;
+      return stop();
+    }
+    if (received_size_ == response_size_ * query_count_) {
+      return stop();
+    }
+    if (can_close_local(fd_)) {
+      LOG(ERROR) << "Connection was closed after " << received_size_ / response_size_ << " answers";
+      stop();
+    }
+  }
+};
+
 const int N = 0;
 class Server final : public td::TcpListener::Callback {
  public:
+  Server(int client_count, int query_count) : client_count_(client_count), query_count_(query_count) {
+  }
+
   void start_up() final {
     listener_ =
         td::create_actor<td::TcpListener>("Listener", 8082, td::ActorOwn<td::TcpListener::Callback>(actor_id(this)));
+    if (client_count_ > 0) {
+      set_timeout_in(0.1);
+    }
+  }
+  void timeout_expired() final {
+    td::IPAddress address;
+    address.init_ipv4_port("127.0.0.1", 8082).ensure();
+    start_time_ = td::Time::now();
+    for (int i = 0; i < client_count_; i++) {
+      auto r_socket_fd = td::SocketFd::open(address);
+      LOG_IF(FATAL, r_socket_fd.is_error()) << r_socket_fd.error();
+      td::create_actor<HttpClient>("HttpClient", r_socket_fd.move_as_ok(), query_count_, actor_shared(this)).release();
+    }
+    left_client_count_ = client_count_;
+  }
+  void hangup_shared() final {
+    CHECK(left_client_count_ > 0);
+    if (--left_client_count_ == 0) {
+      auto elapsed_time = td::Time::now() - start_time_;
+      auto total_query_count = static_cast<td::int64>(client_count_) * query_count_;
+      LOG(PLAIN) << client_count_ << " connections answered " << total_query_count << " queries with "
+                 << td::format::as_size(response.size()) << " responses in " << td::format::as_time(elapsed_time)
+                 << ": " << static_cast<td::int64>(static_cast<double>(total_query_count) / elapsed_time)
+                 << " queries per second";
+      td::Scheduler::instance()->finish();
+    }
   }
   void accept(td::SocketFd fd) final {
-    LOG(ERROR) << "ACCEPT " << cnt++;
+    LOG(INFO) << "ACCEPT " << cnt++;
     pos_++;
     auto scheduler_id = pos_ % (N != 0 ? N : 1) + (N != 0);
     td::create_actor_on_scheduler<td::HttpInboundConnection>(
@@ -70,12 +170,26 @@ class Server final : public td::TcpListener::Callback {
  private:
   td::ActorOwn<td::TcpListener> listener_;
   int pos_{0};
+  int client_count_;
+  int query_count_;
+  int left_client_count_{0};
+  double start_time_{0.0};
 };
 
-int main() {
+// usage: bench_http_server [connection_count [query_count [content_size]]]
+// without arguments works as a server, which can be benchmarked by an external tool like wrk;
+// otherwise, sends query_count queries through each of connection_count connections and measures the throughput
+int main(int argc, char *argv[]) {
+  int client_count = argc > 1 ? td::to_integer<int>(td::Slice(argv[1])) : 0;
+  int query_count = argc > 2 ? td::to_integer<int>(td::Slice(argv[2])) : 100000;
+  if (argc > 3) {
+    response = create_response(td::string(td::to_integer<size_t>(td::Slice(argv[3])), 'a'));
+  } else {
+    response = create_response("hello world");
+  }
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
   auto scheduler = td::make_unique<td::ConcurrentScheduler>(N, 0);
-  scheduler->create_actor_unsafe<Server>(0, "Server").release();
+  scheduler->create_actor_unsafe<Server>(0, "Server", client_count, query_count).release();
   scheduler->start();
   while (scheduler->run_main(10)) {
     // empty
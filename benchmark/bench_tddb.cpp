@@ -11,6 +11,7 @@
 #include "td/telegram/ServerMessageId.h"
 #include "td/telegram/UserId.h"
 
+#include "td/db/binlog/Binlog.h"
 #include "td/db/DbKey.h"
 #include "td/db/SqliteConnectionSafe.h"
 #include "td/db/SqliteDb.h"
@@ -20,11 +21,19 @@
 #include "td/utils/benchmark.h"
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
+#include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/Clocks.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/Stat.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Random.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
+#include "td/utils/Storer.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 
 static td::Status init_db(td::SqliteDb &db) {
@@ -107,7 +116,292 @@ class MessageDbBench final : public td::Benchmark {
   }
 };
 
+// measures MessageDb throughput and read latency under mixed load of history reads and message additions
+class MessageDbReadWriteBench final : public td::Benchmark {
+ public:
+  MessageDbReadWriteBench(int read_thread_count, int read_percent)
+      : read_thread_count_(read_thread_count), read_percent_(read_percent) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "MessageDb load with " << read_percent_ << "% of reads and " << read_thread_count_
+                     << " read threads";
+  }
+
+  void start_up() final {
+    scheduler_ = td::make_unique<td::ConcurrentScheduler>(1 + read_thread_count_, 0);
+    {
+      auto guard = scheduler_->get_main_guard();
+      sql_connection_ = std::make_shared<td::SqliteConnectionSafe>(sql_db_name_, td::DbKey::empty());
+      sql_connection_->set(td::SqliteDb::open_with_key(sql_db_name_, true, td::DbKey::empty()).move_as_ok());
+      auto &db = sql_connection_->get();
+      init_db(db).ensure();
+      db.exec("BEGIN TRANSACTION").ensure();
+      // version == 0 ==> all messages will be deleted
+      init_message_db(db, 0).ensure();
+      db.exec("COMMIT TRANSACTION").ensure();
+
+      message_db_sync_safe_ = td::create_message_db_sync(sql_connection_);
+      td::vector<td::int32> read_scheduler_ids;
+      for (int i = 0; i < read_thread_count_; i++) {
+        read_scheduler_ids.push_back(i + 2);
+      }
+      message_db_async_ = td::create_message_db_async(message_db_sync_safe_, 1, std::move(read_scheduler_ids));
+    }
+    scheduler_->start();
+
+    // fill history of all chats before measurements
+    run_queries(DIALOG_COUNT * 200, 0);
+    latencies_.clear();
+  }
+
+  void run(int n) final {
+    run_queries(n, read_percent_);
+  }
+
+  void tear_down() final {
+    {
+      auto guard = scheduler_->get_main_guard();
+      message_db_sync_safe_.reset();
+      message_db_async_->close(td::PromiseCreator::lambda([sql_connection = std::move(sql_connection_)](td::Unit) {
+        sql_connection->close();
+        td::Scheduler::instance()->finish();
+      }));
+      message_db_async_.reset();
+    }
+    while (scheduler_->run_main(10)) {
+      // empty
+    }
+    scheduler_->finish();
+    scheduler_.reset();
+
+    if (latencies_.size() < 1000) {
+      return;
+    }
+    std::sort(latencies_.begin(), latencies_.end());
+    auto get_percentile = [&](size_t percent) {
+      return td::format::as_time(latencies_[latencies_.size() * percent / 100]);
+    };
+    LOG(ERROR) << get_description() << ": read latency" << td::tag("p50", get_percentile(50))
+               << td::tag("p99", get_percentile(99));
+  }
+
+ private:
+  static constexpr int DIALOG_COUNT = 100;
+
+  int read_thread_count_;
+  int read_percent_;
+  td::string sql_db_name_ = "testdb.sqlite";
+  td::unique_ptr<td::ConcurrentScheduler> scheduler_;
+  std::shared_ptr<td::SqliteConnectionSafe> sql_connection_;
+  std::shared_ptr<td::MessageDbSyncSafeInterface> message_db_sync_safe_;
+  std::shared_ptr<td::MessageDbAsyncInterface> message_db_async_;
+  td::int32 next_message_id_ = 1;
+  td::vector<double> latencies_;
+
+  void run_queries(int n, int read_percent) {
+    std::atomic<int> left_count{n};
+    td::vector<double> read_latencies(n);
+    int read_count = 0;
+    {
+      auto guard = scheduler_->get_main_guard();
+      for (int i = 0; i < n; i++) {
+        auto dialog_id = td::DialogId(td::UserId(static_cast<td::int64>(td::Random::fast(1, DIALOG_COUNT))));
+        if (td::Random::fast(0, 99) < read_percent) {
+          td::MessageDbMessagesQuery query;
+          query.dialog_id = dialog_id;
+          query.from_message_id = td::MessageId::max();
+          query.limit = 50;
+          auto latency = &read_latencies[read_count++];
+          message_db_async_->get_messages(
+              std::move(query), td::PromiseCreator::lambda([&left_count, latency, begin_time = td::Clocks::monotonic()](
+                                                               td::vector<td::MessageDbDialogMessage> messages) {
+                *latency = td::Clocks::monotonic() - begin_time;
+                left_count--;
+              }));
+        } else {
+          auto server_message_id = td::ServerMessageId(next_message_id_++);
+          message_db_async_->add_message({dialog_id, td::MessageId(server_message_id)}, server_message_id,
+                                         td::DialogId(), server_message_id.get(), 0, 0, 0, "", td::NotificationId(),
+                                         td::MessageId(), td::BufferSlice(td::Random::fast(100, 299)),
+                                         td::PromiseCreator::lambda([&left_count](td::Unit) { left_count--; }));
+        }
+      }
+      message_db_async_->force_flush();
+    }
+    while (left_count.load() != 0) {
+      scheduler_->run_main(0.01);
+    }
+    latencies_.insert(latencies_.end(), read_latencies.begin(), read_latencies.begin() + read_count);
+  }
+};
+
+// measures latency of Binlog::add_event, including latency spikes caused by binlog reindex
+class BinlogAddLatencyBench final : public td::Benchmark {
+ public:
+  explicit BinlogAddLatencyBench(bool is_encrypted) : is_encrypted_(is_encrypted) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "Binlog add latency" << (is_encrypted_ ? " encrypted" : "");
+  }
+
+  void start_up() final {
+    td::Binlog::destroy(binlog_name_).ignore();
+    auto db_key = is_encrypted_ ? td::DbKey::raw_key(td::string(32, 'A')) : td::DbKey::empty();
+    // a closed Binlog can't be reopened, so a new instance is used for each run
+    binlog_ = td::make_unique<td::Binlog>();
+    binlog_->init(binlog_name_, [](const td::BinlogEvent &event) {}, std::move(db_key)).ensure();
+    event_ids_.clear();
+    for (int i = 0; i < LIVE_EVENT_COUNT; i++) {
+      event_ids_.push_back(binlog_->add(1, td::create_storer(data_)));
+    }
+    latencies_.clear();
+  }
+
+  void run(int n) final {
+    for (int i = 0; i < n; i++) {
+      auto event_id = event_ids_[td::Random::fast(0, LIVE_EVENT_COUNT - 1)];
+      auto begin_time = td::Clocks::monotonic();
+      binlog_->rewrite(event_id, 1, td::create_storer(data_));
+      latencies_.push_back(td::Clocks::monotonic() - begin_time);
+    }
+  }
+
+  void tear_down() final {
+    binlog_->close_and_destroy().ensure();
+    binlog_ = nullptr;
+    if (latencies_.size() < 100000) {
+      return;
+    }
+    std::sort(latencies_.begin(), latencies_.end());
+    auto get_percentile = [&](size_t percent) {
+      return td::format::as_time(latencies_[latencies_.size() * percent / 100]);
+    };
+    LOG(ERROR) << get_description() << ": " << td::tag("p50", get_percentile(50))
+               << td::tag("p99", get_percentile(99)) << td::tag("max", td::format::as_time(latencies_.back()));
+  }
+
+ private:
+  static constexpr int LIVE_EVENT_COUNT = 20000;
+
+  bool is_encrypted_;
+  td::string binlog_name_ = "test_binlog";
+  td::string data_ = td::string(256, 'a');
+  td::unique_ptr<td::Binlog> binlog_;
+  td::vector<td::uint64> event_ids_;
+  td::vector<double> latencies_;
+};
+
+// measures replay speed of a binlog and growth of resident memory size during replay
+class BinlogReplayBench final : public td::Benchmark {
+ public:
+  td::string get_description() const final {
+    return "Binlog replay";
+  }
+
+  void start_up() final {
+    // the binlog is written directly to the file to not affect resident size by the writing
+    td::Binlog::destroy(binlog_name_).ignore();
+    auto fd = td::FileFd::open(binlog_name_, td::FileFd::Flags::Write | td::FileFd::Flags::Create).move_as_ok();
+    auto data = td::string(1000, 'a');
+    for (int i = 1; i <= EVENT_COUNT; i++) {
+      auto raw_event = td::BinlogEvent::create_raw(i, 1, 0, td::create_storer(data));
+      fd.write(raw_event.as_slice()).ensure();
+    }
+    fd.close();
+  }
+
+  void run(int n) final {
+    for (int i = 0; i < n; i++) {
+      auto begin_resident_size = get_resident_size();
+      int event_count = 0;
+      td::Binlog binlog;
+      binlog.init(binlog_name_, [&](const td::BinlogEvent &event) { event_count++; }).ensure();
+      CHECK(event_count == EVENT_COUNT);
+      auto resident_size = get_resident_size();
+      if (resident_size > begin_resident_size) {
+        max_resident_size_growth_ = td::max(max_resident_size_growth_, resident_size - begin_resident_size);
+      }
+      binlog.close().ensure();
+    }
+  }
+
+  void tear_down() final {
+    td::Binlog::destroy(binlog_name_).ignore();
+    LOG(ERROR) << get_description() << ": "
+               << td::tag("resident size growth", td::format::as_size(max_resident_size_growth_));
+  }
+
+ private:
+  static constexpr int EVENT_COUNT = 50000;
+
+  td::string binlog_name_ = "test_binlog";
+  td::uint64 max_resident_size_growth_ = 0;
+
+  static td::uint64 get_resident_size() {
+    auto r_mem_stat = td::mem_stat();
+    return r_mem_stat.is_ok() ? r_mem_stat.ok().resident_size_ : 0;
+  }
+};
+
+// measures the time needed to load a 100 MB binlog and to copy its events like TdDb does during startup
+class BinlogStartupBench final : public td::Benchmark {
+ public:
+  explicit BinlogStartupBench(bool is_encrypted) : is_encrypted_(is_encrypted) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "Binlog startup 100MB" << (is_encrypted_ ? " encrypted" : "");
+  }
+
+  void start_up() final {
+    td::Binlog::destroy(binlog_name_).ignore();
+    td::Binlog binlog;
+    binlog.init(binlog_name_, [](const td::BinlogEvent &event) {}, get_db_key()).ensure();
+    auto data = td::string(EVENT_SIZE - td::BinlogEvent::MIN_SIZE, 'a');
+    for (int i = 0; i < EVENT_COUNT; i++) {
+      binlog.add(1, td::create_storer(data));
+    }
+    binlog.close().ensure();
+  }
+
+  void run(int n) final {
+    for (int i = 0; i < n; i++) {
+      td::vector<td::BinlogEvent> events;
+      td::Binlog binlog;
+      binlog.init(binlog_name_, [&](const td::BinlogEvent &event) { events.push_back(event.clone()); }, get_db_key())
+          .ensure();
+      CHECK(events.size() == static_cast<size_t>(EVENT_COUNT));
+      binlog.close().ensure();
+    }
+  }
+
+  void tear_down() final {
+    td::Binlog::destroy(binlog_name_).ignore();
+  }
+
+ private:
+  static constexpr int EVENT_COUNT = 100000;
+  static constexpr size_t EVENT_SIZE = 1000;
+
+  bool is_encrypted_;
+  td::string binlog_name_ = "test_binlog";
+
+  td::DbKey get_db_key() const {
+    return is_encrypted_ ? td::DbKey::raw_key(td::string(32, 'A')) : td::DbKey::empty();
+  }
+};
+
 int main() {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
+  td::bench(BinlogAddLatencyBench(false));
+  td::bench(BinlogAddLatencyBench(true));
+  td::bench(BinlogReplayBench());
+  td::bench(BinlogStartupBench(false));
+  td::bench(BinlogStartupBench(true));
   td::bench(MessageDbBench());
+  td::bench(MessageDbReadWriteBench(0, 0));
+  td::bench(MessageDbReadWriteBench(0, 80));
+  td::bench(MessageDbReadWriteBench(2, 80));
 }
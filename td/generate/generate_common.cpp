@@ -43,6 +43,7 @@ int main() {
   generate_cpp<false, td::TD_TL_writer_jni_cpp, td::TD_TL_writer_jni_h>(
       "td/telegram", "td_api", "std::string", "std::string", {"\"td/tl/tl_jni_object.h\""}, {"<string>"});
 #else
-  generate_cpp<>("td/telegram", "td_api", "std::string", "std::string", {}, {"<string>"});
+  generate_cpp<>("td/telegram", "td_api", "std::string", "std::string",
+                 {"\"td/tl/tl_object_parse.h\"", "\"td/tl/tl_object_store.h\""}, {"<string>"});
 #endif
 }
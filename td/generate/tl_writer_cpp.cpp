@@ -137,6 +137,10 @@ std::string TD_TL_writer_cpp::gen_constructor_id_store(std::int32_t id, int stor
   return "  " + gen_constructor_id_store_raw(int_to_string(id)) + "\n";
 }
 
+bool TD_TL_writer_cpp::is_nullable_object_type(const tl::tl_type *t) const {
+  return tl_name == "td_api" && !is_built_in_simple_type(t->name) && !is_built_in_complex_type(t->name);
+}
+
 std::string TD_TL_writer_cpp::gen_fetch_class_name(const tl::tl_tree_type *tree_type) const {
   const tl::tl_type *t = tree_type->type;
   const std::string &name = t->name;
@@ -183,6 +187,23 @@ std::string TD_TL_writer_cpp::gen_full_fetch_class_name(const tl::tl_tree_type *
   assert(!(t->flags & tl::FLAG_DEFAULT_CONSTRUCTOR));  // Not supported yet
 
   std::int32_t expected_constructor_id = 0;
+  if (is_nullable_object_type(t)) {
+    // td_api objects can be null, so they are always stored boxed with constructor identifier 0 used for null objects
+    if (is_type_bare(t)) {
+      for (std::size_t i = 0; i < t->constructors_num; i++) {
+        if (is_combinator_supported(t->constructors[i])) {
+          assert(expected_constructor_id == 0);
+          expected_constructor_id = t->constructors[i]->id;
+          assert(expected_constructor_id != 0);
+        }
+      }
+    }
+    if (expected_constructor_id == 0) {
+      return "TlFetchNullable<" + gen_fetch_class_name(tree_type) + ">";
+    }
+    return "TlFetchNullable<TlFetchBoxed<" + gen_fetch_class_name(tree_type) + ", " +
+           int_to_string(expected_constructor_id) + ">>";
+  }
   if (tree_type->flags & tl::FLAG_BARE) {
     assert(is_type_bare(t));
   } else {
@@ -375,6 +396,10 @@ std::string TD_TL_writer_cpp::gen_full_store_class_name(const tl::tl_tree_type *
 
   assert(!(t->flags & tl::FLAG_DEFAULT_CONSTRUCTOR));  // Not supported yet
 
+  if (is_nullable_object_type(t)) {
+    return "TlStoreNullableBoxedUnknown<" + gen_store_class_name(tree_type) + ">";
+  }
+
   if ((tree_type->flags & tl::FLAG_BARE) != 0 || t->name == "#" || t->name == "Bool") {
     return gen_store_class_name(tree_type);
   }
@@ -17,6 +17,8 @@ namespace td {
 class TD_TL_writer_cpp : public TD_TL_writer {
   std::string gen_constructor_id_store_raw(const std::string &id) const;
 
+  bool is_nullable_object_type(const tl::tl_type *t) const;
+
   std::string gen_fetch_class_name(const tl::tl_tree_type *tree_type) const;
 
   std::string gen_full_fetch_class_name(const tl::tl_tree_type *tree_type) const;
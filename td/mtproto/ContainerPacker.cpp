@@ -0,0 +1,184 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/mtproto/ContainerPacker.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+
+#include <utility>
+
+namespace td {
+namespace mtproto {
+
+static constexpr size_t DEFAULT_MAX_CONTAINER_SIZE = 1 << 15;
+static constexpr size_t MIN_CONTAINER_SIZE = 1 << 13;
+static constexpr size_t MAX_CONTAINER_SIZE = 1 << 18;
+static constexpr double DEFAULT_QUERY_DELAY = 0.001;  // 0.001s
+static constexpr double MIN_QUERY_DELAY = 0.0001;     // 0.0001s
+static constexpr double MAX_QUERY_DELAY = 0.05;       // 0.05s
+static constexpr double FILTER_WINDOW = 10.0;         // estimates are replaced with fresher ones after 10s
+static constexpr double MIN_ACK_TIMEOUT = 1.0;        // packets aren't waited for acknowledgement longer
+
+double ContainerPacker::get_bdp() const {
+  CHECK(has_estimates());
+  return bandwidth_ * min_rtt_;
+}
+
+size_t ContainerPacker::get_max_container_size() const {
+  if (!is_adaptive_ || !has_estimates()) {
+    return DEFAULT_MAX_CONTAINER_SIZE;
+  }
+  // a container must not occupy the connection for more than a half of the round trip
+  auto size = static_cast<size_t>(get_bdp() / 2);
+  return clamp(size, MIN_CONTAINER_SIZE, MAX_CONTAINER_SIZE);
+}
+
+double ContainerPacker::get_flush_delay(size_t pending_size, double now) const {
+  if (!is_adaptive_ || !has_estimates()) {
+    return DEFAULT_QUERY_DELAY;
+  }
+  if (pending_size >= get_max_container_size()) {
+    return 0.0;
+  }
+
+  // if the network isn't saturated, wait only for queries sent almost simultaneously, but no longer than
+  // a negligible part of the round trip
+  auto min_delay = clamp(rtt_ / 16, MIN_QUERY_DELAY, DEFAULT_QUERY_DELAY);
+  auto bdp = get_bdp();
+  auto queued_size = static_cast<double>(outstanding_bytes_ + pending_size);
+  if (queued_size <= bdp) {
+    return min_delay;
+  }
+
+  // the queries wouldn't be delivered earlier than the network drains, so wait for more queries in the meantime
+  auto drain_time = (queued_size - bdp) / bandwidth_;
+  return clamp(drain_time, min_delay, max(min_delay, min(MAX_QUERY_DELAY, rtt_ * 0.125)));
+}
+
+void ContainerPacker::on_packet_sent(vector<MessageId> message_ids, size_t packet_size, size_t query_size,
+                                     size_t query_count, bool has_pending_queries, double now) {
+  stats_.packet_count++;
+  stats_.query_count += query_count;
+  stats_.sent_bytes += packet_size;
+  stats_.fill_ratio_sum += static_cast<double>(query_size) / static_cast<double>(get_max_container_size());
+
+  drop_old_packets(now);
+
+  auto packet_id = first_packet_id_ + sent_packets_.size();
+  for (auto message_id : message_ids) {
+    message_id_to_packet_id_[message_id] = packet_id;
+  }
+
+  SentPacket packet;
+  packet.message_ids = std::move(message_ids);
+  packet.sent_at = now;
+  packet.first_sent_at = delivered_packet_sent_at_ == 0.0 ? now : delivered_packet_sent_at_;
+  packet.delivered_at = delivered_at_ == 0.0 ? now : delivered_at_;
+  packet.delivered_bytes = delivered_bytes_;
+  packet.size = packet_size;
+  // the delivery rate is limited by the application, if there were not enough queries to saturate the network
+  packet.is_app_limited =
+      !has_pending_queries && (!has_estimates() || static_cast<double>(outstanding_bytes_ + packet_size) < get_bdp());
+  sent_packets_.push_back(std::move(packet));
+  outstanding_bytes_ += packet_size;
+}
+
+void ContainerPacker::on_message_ack(MessageId message_id, double now) {
+  auto it = message_id_to_packet_id_.find(message_id);
+  if (it == message_id_to_packet_id_.end()) {
+    return;
+  }
+  auto packet_id = it->second;
+  message_id_to_packet_id_.erase(it);
+  if (packet_id < first_packet_id_) {
+    return;
+  }
+
+  auto &packet = sent_packets_[static_cast<size_t>(packet_id - first_packet_id_)];
+  if (packet.is_acked) {
+    return;
+  }
+  packet.is_acked = true;
+  CHECK(outstanding_bytes_ >= packet.size);
+  outstanding_bytes_ -= packet.size;
+  delivered_bytes_ += packet.size;
+  stats_.acked_bytes += packet.size;
+
+  on_rtt_sample(now - packet.sent_at, now);
+  // acknowledgements can be compressed, so the delivery rate can't be bigger than the sending rate
+  auto interval = max(now - packet.delivered_at, packet.sent_at - packet.first_sent_at);
+  if (interval > 0.0) {
+    on_bandwidth_sample(static_cast<double>(delivered_bytes_ - packet.delivered_bytes) / interval,
+                        packet.is_app_limited, now);
+  }
+  delivered_at_ = now;
+  delivered_packet_sent_at_ = packet.sent_at;
+
+  drop_old_packets(now);
+}
+
+void ContainerPacker::on_rtt_sample(double rtt, double now) {
+  if (rtt <= 0.0) {
+    return;
+  }
+  rtt_ = rtt_ == 0.0 ? rtt : rtt_ * 0.875 + rtt * 0.125;
+  if (min_rtt_ == 0.0 || rtt <= min_rtt_ || min_rtt_at_ + FILTER_WINDOW < now) {
+    min_rtt_ = rtt;
+    min_rtt_at_ = now;
+  }
+}
+
+void ContainerPacker::on_bandwidth_sample(double bandwidth, bool is_app_limited, double now) {
+  if (bandwidth >= bandwidth_ || (!is_app_limited && bandwidth_at_ + FILTER_WINDOW < now)) {
+    bandwidth_ = bandwidth;
+    bandwidth_at_ = now;
+  }
+}
+
+void ContainerPacker::drop_old_packets(double now) {
+  // the server doesn't acknowledge some messages, so unacknowledged packets are forgotten after a timeout
+  auto ack_timeout = max(MIN_ACK_TIMEOUT, rtt_ * 4);
+  while (!sent_packets_.empty()) {
+    auto &packet = sent_packets_.front();
+    if (!packet.is_acked && packet.sent_at + ack_timeout >= now) {
+      break;
+    }
+    if (!packet.is_acked) {
+      CHECK(outstanding_bytes_ >= packet.size);
+      outstanding_bytes_ -= packet.size;
+    }
+    for (auto message_id : packet.message_ids) {
+      auto it = message_id_to_packet_id_.find(message_id);
+      if (it != message_id_to_packet_id_.end() && it->second == first_packet_id_) {
+        message_id_to_packet_id_.erase(it);
+      }
+    }
+    sent_packets_.pop_front();
+    first_packet_id_++;
+  }
+}
+
+ContainerPacker::Stats ContainerPacker::get_stats() const {
+  auto stats = stats_;
+  stats.rtt = rtt_;
+  stats.min_rtt = min_rtt_;
+  stats.bandwidth = bandwidth_;
+  stats.max_container_size = get_max_container_size();
+  return stats;
+}
+
+StringBuilder &operator<<(StringBuilder &string_builder, const ContainerPacker::Stats &stats) {
+  auto fill_ratio = stats.packet_count == 0 ? 0.0 : stats.fill_ratio_sum / static_cast<double>(stats.packet_count);
+  return string_builder << "[packets:" << stats.packet_count << " queries:" << stats.query_count
+                        << " sent:" << stats.sent_bytes << "B acked:" << stats.acked_bytes
+                        << "B fill_ratio:" << fill_ratio << " RTT:" << stats.rtt << " min_RTT:" << stats.min_rtt
+                        << " bandwidth:" << stats.bandwidth << "B/s max_container_size:" << stats.max_container_size
+                        << ']';
+}
+
+}  // namespace mtproto
+}  // namespace td
@@ -0,0 +1,107 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/mtproto/MessageId.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/StringBuilder.h"
+
+#include <deque>
+
+namespace td {
+namespace mtproto {
+
+// chooses size of containers and the moment when pending queries must be sent,
+// based on the measured RTT, delivery rate and the number of bytes sent, but not acknowledged yet;
+// if the bandwidth-delay product isn't filled, queries are sent almost immediately,
+// otherwise they are held for a while to be packed together, because they would wait in the network anyway
+class ContainerPacker {
+ public:
+  struct Stats {
+    uint64 packet_count = 0;
+    uint64 query_count = 0;
+    uint64 sent_bytes = 0;
+    uint64 acked_bytes = 0;
+    double fill_ratio_sum = 0.0;  // sum of ratios of query size to the container size limit over all packets
+    double rtt = 0.0;
+    double min_rtt = 0.0;
+    double bandwidth = 0.0;  // bytes per second
+    size_t max_container_size = 0;
+  };
+
+  // if !is_adaptive, then containers are limited by 32 KB and are sent 1 millisecond after the first query
+  explicit ContainerPacker(bool is_adaptive = true) : is_adaptive_(is_adaptive) {
+  }
+
+  size_t get_max_container_size() const;
+
+  // returns delay after which pending queries of the given total size must be sent
+  double get_flush_delay(size_t pending_size, double now) const;
+
+  // must be called for every sent packet with queries or ping; message_ids must include all message identifiers,
+  // which can be acknowledged by the server, including identifier of the container
+  void on_packet_sent(vector<MessageId> message_ids, size_t packet_size, size_t query_size, size_t query_count,
+                      bool has_pending_queries, double now);
+
+  void on_message_ack(MessageId message_id, double now);
+
+  size_t get_outstanding_bytes() const {
+    return outstanding_bytes_;
+  }
+
+  Stats get_stats() const;
+
+ private:
+  struct SentPacket {
+    vector<MessageId> message_ids;
+    double sent_at = 0.0;
+    double first_sent_at = 0.0;  // sending time of the last acknowledged packet at the moment of sending
+    double delivered_at = 0.0;
+    uint64 delivered_bytes = 0;
+    size_t size = 0;
+    bool is_app_limited = false;
+    bool is_acked = false;
+  };
+
+  bool is_adaptive_;
+
+  std::deque<SentPacket> sent_packets_;
+  uint64 first_packet_id_ = 0;
+  FlatHashMap<MessageId, uint64, MessageIdHash> message_id_to_packet_id_;
+
+  size_t outstanding_bytes_ = 0;
+  uint64 delivered_bytes_ = 0;
+  double delivered_at_ = 0.0;
+  double delivered_packet_sent_at_ = 0.0;
+
+  double rtt_ = 0.0;
+  double min_rtt_ = 0.0;
+  double min_rtt_at_ = 0.0;
+  double bandwidth_ = 0.0;
+  double bandwidth_at_ = 0.0;
+
+  Stats stats_;
+
+  bool has_estimates() const {
+    return bandwidth_ > 0.0 && min_rtt_ > 0.0;
+  }
+
+  double get_bdp() const;
+
+  void on_rtt_sample(double rtt, double now);
+
+  void on_bandwidth_sample(double bandwidth, bool is_app_limited, double now);
+
+  void drop_old_packets(double now);
+};
+
+StringBuilder &operator<<(StringBuilder &string_builder, const ContainerPacker::Stats &stats);
+
+}  // namespace mtproto
+}  // namespace td
@@ -247,6 +247,7 @@ Status SessionConnection::on_packet_rpc_result(const MsgInfo &info, Slice packet
     return Status::Error("Receive an update in rpc_result");
   }
   VLOG(mtproto) << "Receive result for request with " << MessageId(req_msg_id) << ' ' << info;
+  container_packer_.on_message_ack(MessageId(req_msg_id), Time::now_cached());
 
   if (info.message_id.get() < req_msg_id - (static_cast<uint64>(15) << 32)) {
     reset_server_time_difference(info.message_id);
@@ -351,6 +352,7 @@ Status SessionConnection::on_packet(const MsgInfo &info,
       LOG(WARNING) << bad_info << ": MessageId is too high. Session will be closed";
       // All this queries will be re-sent by parent
       to_send_.clear();
+      to_send_size_ = 0;
       reset_server_time_difference(info.message_id);
       callback_->on_session_failed(Status::Error("MessageId is too high"));
       return Status::Error("MessageId is too high");
@@ -400,6 +402,7 @@ Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::msgs
   auto message_ids = transform(msgs_ack.msg_ids_, [](int64 msg_id) { return MessageId(static_cast<uint64>(msg_id)); });
   VLOG(mtproto) << "Receive msgs_ack " << info << ": " << message_ids;
   for (auto message_id : message_ids) {
+    container_packer_.on_message_ack(message_id, Time::now_cached());
     callback_->on_message_ack(message_id);
   }
   return Status::OK();
@@ -425,6 +428,7 @@ Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::pong
 
   last_pong_at_ = Time::now_cached();
   real_last_pong_at_ = last_pong_at_;
+  container_packer_.on_message_ack(MessageId(static_cast<uint64>(pong.msg_id_)), last_pong_at_);
   auto get_time = [](int64 msg_id) {
     return static_cast<double>(msg_id) / (static_cast<uint64>(1) << 32);
   };
@@ -744,6 +748,7 @@ Status SessionConnection::on_raw_packet(const PacketInfo &packet_info, BufferSli
 }
 
 Status SessionConnection::on_quick_ack(uint64 quick_ack_token) {
+  container_packer_.on_message_ack(MessageId(quick_ack_token), Time::now_cached());
   callback_->on_message_ack(MessageId(quick_ack_token));
   return Status::OK();
 }
@@ -798,6 +803,7 @@ void SessionConnection::set_online(bool online_flag, bool is_main) {
 
 void SessionConnection::do_close(Status status) {
   state_ = Closed;
+  LOG(INFO) << "Close connection with container statistics " << container_packer_.get_stats();
   // NB: this could be destroyed after on_closed
   callback_->on_closed(std::move(status));
 }
@@ -816,9 +822,8 @@ Result<MessageId> SessionConnection::send_query(BufferSlice buffer, bool gzip_fl
     message_id = auth_data_->next_message_id(Time::now_cached());
   }
   auto seq_no = auth_data_->next_seq_no(true);
-  if (to_send_.empty()) {
-    send_before(Time::now_cached() + QUERY_DELAY);
-  }
+  to_send_size_ += buffer.size();
+  send_before(Time::now_cached() + container_packer_.get_flush_delay(to_send_size_, Time::now_cached()));
   to_send_.push_back(MtprotoQuery{message_id, seq_no, std::move(buffer), gzip_flag, std::move(invoke_after_message_ids),
                                   use_quick_ack});
   VLOG(mtproto) << "Invoke query with " << message_id << " and seq_no " << seq_no << " of size "
@@ -949,12 +954,15 @@ void SessionConnection::flush_packet() {
   size_t send_till = 0;
   size_t send_size = 0;
   if (has_salt) {
-    // send at most MAX_QUERY_COUNT queries, of total size up to 2^15
-    while (send_till < to_send_.size() && send_till < MAX_QUERY_COUNT && send_size < (1 << 15)) {
+    // send at most MAX_QUERY_COUNT queries, of total size up to the limit chosen by container_packer_
+    auto max_container_size = container_packer_.get_max_container_size();
+    while (send_till < to_send_.size() && send_till < MAX_QUERY_COUNT && send_size < max_container_size) {
       send_size += to_send_[send_till].packet.size();
       send_till++;
     }
   }
+  CHECK(to_send_size_ >= send_size);
+  to_send_size_ -= send_size;
   vector<MtprotoQuery> queries;
   if (send_till == to_send_.size()) {
     queries = std::move(to_send_);
@@ -1014,9 +1022,10 @@ void SessionConnection::flush_packet() {
 
   bool use_quick_ack = any_of(queries, [](const auto &query) { return query.use_quick_ack; });
 
+  MessageId parent_message_id;
+  auto old_write_size = last_write_size_;
   {
     // LOG(ERROR) << (auth_data_->get_header().empty() ? '-' : '+');
-    MessageId parent_message_id;
     auto storer = PacketStorer<CryptoImpl>(
         queries, auth_data_->get_header(), std::move(to_ack), ping_id, static_cast<int>(ping_disconnect_delay() + 2.0),
         max_delay, max_after, max_wait, future_salt_n, to_get_state_info, to_resend_answer, to_cancel_answer,
@@ -1027,6 +1036,16 @@ void SessionConnection::flush_packet() {
     send_crypto(storer, quick_ack_token);
   }
 
+  if (!queries.empty() || ping_id != 0) {
+    auto message_ids = transform(queries, [](const MtprotoQuery &query) { return query.message_id; });
+    message_ids.push_back(parent_message_id);
+    if (ping_id != 0) {
+      message_ids.push_back(ping_message_id);
+    }
+    container_packer_.on_packet_sent(std::move(message_ids), static_cast<size_t>(last_write_size_ - old_write_size),
+                                     send_size, queries.size(), !to_send_.empty(), Time::now_cached());
+  }
+
   if (resend_answer_message_id != MessageId()) {
     service_queries_.emplace(resend_answer_message_id, ServiceQuery{ServiceQuery::ResendAnswer, container_message_id,
                                                                     std::move(to_resend_answer)});
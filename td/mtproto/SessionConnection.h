@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/mtproto/ContainerPacker.h"
 #include "td/mtproto/MessageId.h"
 #include "td/mtproto/MtprotoQuery.h"
 #include "td/mtproto/PacketInfo.h"
@@ -117,9 +118,12 @@ class SessionConnection final
   // NB: Do not call force_close after on_closed callback
   void force_close(SessionConnection::Callback *callback);
 
+  ContainerPacker::Stats get_container_stats() const {
+    return container_packer_.get_stats();
+  }
+
  private:
   static constexpr int ACK_DELAY = 30;                  // 30s
-  static constexpr double QUERY_DELAY = 0.001;          // 0.001s
   static constexpr double RESEND_ANSWER_DELAY = 0.001;  // 0.001s
 
   struct MsgInfo {
@@ -161,6 +165,8 @@ class SessionConnection final
   static constexpr int HTTP_MAX_DELAY = 30;  // 0.03s
 
   vector<MtprotoQuery> to_send_;
+  size_t to_send_size_ = 0;
+  ContainerPacker container_packer_;
   vector<MessageId> to_ack_message_ids_;
   double force_send_at_ = 0;
 
@@ -171,6 +171,18 @@ class ClientManager::Impl final {
     return response;
   }
 
+  vector<Response> receive_batch(size_t max_count, double timeout) {
+    vector<Response> responses;
+    while (responses.size() < max_count) {
+      auto response = receive(responses.empty() ? timeout : 0.0);
+      if (response.object == nullptr) {
+        break;
+      }
+      responses.push_back(std::move(response));
+    }
+    return responses;
+  }
+
   Impl() = default;
   Impl(const Impl &) = delete;
   Impl &operator=(const Impl &) = delete;
@@ -278,23 +290,24 @@ class TdReceiver {
 
   ClientManager::Response receive(double timeout, bool from_manager) {
     VLOG(td_requests) << "Begin to wait for updates with timeout " << timeout;
-    auto is_locked = receive_lock_.exchange(true);
-    if (is_locked) {
-      if (from_manager) {
-        LOG(FATAL) << "Receive must not be called simultaneously from two different threads, but this has just "
-                      "happened. Call it from a fixed thread, dedicated for updates and response processing.";
-      } else {
-        LOG(FATAL) << "Receive is called after Client destroy, or simultaneously from different threads";
-      }
-    }
+    lock_receive(from_manager);
     auto response = receive_unlocked(clamp(timeout, 0.0, 1000000.0));
-    is_locked = receive_lock_.exchange(false);
-    CHECK(is_locked);
+    unlock_receive();
     VLOG(td_requests) << "End to wait for updates, returning object " << response.request_id << ' '
                       << response.object.get();
     return response;
   }
 
+  vector<ClientManager::Response> receive_batch(size_t max_count, double timeout, bool from_manager) {
+    VLOG(td_requests) << "Begin to wait for up to " << max_count << " updates with timeout " << timeout;
+    vector<ClientManager::Response> responses;
+    lock_receive(from_manager);
+    receive_batch_unlocked(responses, max_count, clamp(timeout, 0.0, 1000000.0));
+    unlock_receive();
+    VLOG(td_requests) << "End to wait for updates, returning " << responses.size() << " objects";
+    return responses;
+  }
+
   unique_ptr<TdCallback> create_callback(ClientManager::ClientId client_id) {
     class Callback final : public TdCallback {
      public:
@@ -332,6 +345,23 @@ class TdReceiver {
   int output_queue_ready_cnt_{0};
   std::atomic<bool> receive_lock_{false};
 
+  void lock_receive(bool from_manager) {
+    auto is_locked = receive_lock_.exchange(true);
+    if (is_locked) {
+      if (from_manager) {
+        LOG(FATAL) << "Receive must not be called simultaneously from two different threads, but this has just "
+                      "happened. Call it from a fixed thread, dedicated for updates and response processing.";
+      } else {
+        LOG(FATAL) << "Receive is called after Client destroy, or simultaneously from different threads";
+      }
+    }
+  }
+
+  void unlock_receive() {
+    auto is_locked = receive_lock_.exchange(false);
+    CHECK(is_locked);
+  }
+
   ClientManager::Response receive_unlocked(double timeout) {
     if (output_queue_ready_cnt_ == 0) {
       output_queue_ready_cnt_ = output_queue_->reader_wait_nonblock();
@@ -346,14 +376,45 @@ class TdReceiver {
     }
     return {0, 0, nullptr};
   }
+
+  void receive_batch_unlocked(vector<ClientManager::Response> &responses, size_t max_count, double timeout) {
+    while (responses.size() < max_count) {
+      if (output_queue_ready_cnt_ == 0) {
+        output_queue_ready_cnt_ = output_queue_->reader_wait_nonblock();
+        if (output_queue_ready_cnt_ == 0) {
+          break;
+        }
+      }
+      if (responses.empty()) {
+        responses.reserve(min(max_count, static_cast<size_t>(output_queue_ready_cnt_)));
+      }
+      output_queue_ready_cnt_--;
+      responses.push_back(output_queue_->reader_get_unsafe());
+    }
+    if (responses.empty() && max_count != 0 && timeout != 0) {
+      output_queue_->reader_get_event_fd().wait(static_cast<int>(timeout * 1000));
+      receive_batch_unlocked(responses, max_count, 0);
+    }
+  }
 };
 
 class MultiImpl {
  public:
-  static constexpr int32 ADDITIONAL_THREAD_COUNT = 3;
-
-  explicit MultiImpl(std::shared_ptr<NetQueryStats> net_query_stats) {
-    concurrent_scheduler_ = std::make_shared<ConcurrentScheduler>(ADDITIONAL_THREAD_COUNT, 0);
+  // additional schedulers are used for database access, garbage collection, network requests and database reads
+  static constexpr int32 MAX_ADDITIONAL_THREAD_COUNT = 4;
+
+  MultiImpl(std::shared_ptr<NetQueryStats> net_query_stats, const ClientManager::ThreadOptions &thread_options) {
+    auto additional_thread_count = get_additional_thread_count(thread_options);
+    concurrent_scheduler_ = std::make_shared<ConcurrentScheduler>(additional_thread_count, 0);
+    // the order of tasks must be the same as in Global::Global();
+    // if there are not enough threads, then the last thread is shared and uses the mask of its first task
+    uint64 thread_affinity_masks[] = {thread_options.database_thread_affinity_mask,
+                                      thread_options.gc_thread_affinity_mask,
+                                      thread_options.network_thread_affinity_mask,
+                                      thread_options.database_read_thread_affinity_mask};
+    for (int32 sched_id = 1; sched_id <= additional_thread_count; sched_id++) {
+      concurrent_scheduler_->set_thread_affinity_mask(sched_id, thread_affinity_masks[sched_id - 1]);
+    }
     concurrent_scheduler_->start();
 
     {
@@ -363,7 +424,15 @@ class MultiImpl {
       multi_td_ = create_actor<MultiTd>("MultiTd", std::move(options));
     }
 
-    scheduler_thread_ = thread([concurrent_scheduler = concurrent_scheduler_] {
+    scheduler_thread_ = thread([concurrent_scheduler = concurrent_scheduler_,
+                                thread_affinity_mask = thread_options.main_thread_affinity_mask] {
+#if TD_HAVE_THREAD_AFFINITY
+      if (thread_affinity_mask != 0) {
+        thread::set_affinity_mask(this_thread::get_id(), thread_affinity_mask).ignore();
+      }
+#else
+      (void)thread_affinity_mask;
+#endif
       while (concurrent_scheduler->run_main(10)) {
       }
     });
@@ -401,6 +470,10 @@ class MultiImpl {
     send_closure(multi_td_, &MultiTd::close, client_id);
   }
 
+  static int32 get_additional_thread_count(const ClientManager::ThreadOptions &thread_options) {
+    return clamp(thread_options.additional_thread_count, 0, MAX_ADDITIONAL_THREAD_COUNT);
+  }
+
   ~MultiImpl() {
     {
       auto guard = concurrent_scheduler_->get_send_guard();
@@ -423,22 +496,41 @@ class MultiImpl {
   static std::atomic<uint32> current_id_;
 };
 
-constexpr int32 MultiImpl::ADDITIONAL_THREAD_COUNT;
+constexpr int32 MultiImpl::MAX_ADDITIONAL_THREAD_COUNT;
 std::atomic<uint32> MultiImpl::current_id_{1};
 
 class MultiImplPool {
  public:
+  static void set_thread_options(const ClientManager::ThreadOptions &thread_options) {
+    std::lock_guard<std::mutex> lock(thread_options_mutex_);
+    thread_options_ = thread_options;
+  }
+
   std::shared_ptr<MultiImpl> get() {
     std::unique_lock<std::mutex> lock(mutex_);
     if (impls_.empty()) {
       init_openssl_threads();
 
-      auto max_client_threads = clamp(thread::hardware_concurrency(), 8u, 20u) * 5 / 4;
+      {
+        std::lock_guard<std::mutex> thread_options_lock(thread_options_mutex_);
+        current_thread_options_ = thread_options_;
+      }
+      auto additional_thread_count = MultiImpl::get_additional_thread_count(current_thread_options_);
+
+      uint32 max_client_threads = 0;
+      if (current_thread_options_.instance_count > 0) {
+        max_client_threads = static_cast<uint32>(current_thread_options_.instance_count);
+      } else {
+        max_client_threads = clamp(thread::hardware_concurrency(), 8u, 20u) * 5 / 4;
 #if TD_OPENBSD
-      max_client_threads = td::min(max_client_threads, 4u);
+        max_client_threads = td::min(max_client_threads, 4u);
 #endif
+      }
+      // the total number of threads is limited by ThreadLocalStorage
+      auto threads_per_impl = static_cast<uint32>(1 + additional_thread_count + 1 /* IOCP */);
+      max_client_threads = td::min(max_client_threads, 127 / threads_per_impl);
       impls_.resize(max_client_threads);
-      CHECK(impls_.size() * (1 + MultiImpl::ADDITIONAL_THREAD_COUNT + 1 /* IOCP */) < 128);
+      CHECK(impls_.size() * threads_per_impl < 128);
 
       net_query_stats_ = std::make_shared<NetQueryStats>();
     }
@@ -446,7 +538,7 @@ class MultiImplPool {
                                    [](auto &a, auto &b) { return a.lock().use_count() < b.lock().use_count(); });
     auto result = impl.lock();
     if (!result) {
-      result = std::make_shared<MultiImpl>(net_query_stats_);
+      result = std::make_shared<MultiImpl>(net_query_stats_, current_thread_options_);
       impl = result;
     }
     return result;
@@ -474,8 +566,15 @@ class MultiImplPool {
   std::mutex mutex_;
   std::vector<std::weak_ptr<MultiImpl>> impls_;
   std::shared_ptr<NetQueryStats> net_query_stats_;
+  ClientManager::ThreadOptions current_thread_options_;
+
+  static std::mutex thread_options_mutex_;
+  static ClientManager::ThreadOptions thread_options_;
 };
 
+std::mutex MultiImplPool::thread_options_mutex_;
+ClientManager::ThreadOptions MultiImplPool::thread_options_;
+
 class ClientManager::Impl final {
  public:
   ClientId create_client_id() {
@@ -520,6 +619,28 @@ class ClientManager::Impl final {
 
   Response receive(double timeout) {
     auto response = receiver_.receive(timeout, true);
+    process_response(response);
+    return response;
+  }
+
+  vector<Response> receive_batch(size_t max_count, double timeout) {
+    auto responses = receiver_.receive_batch(max_count, timeout, true);
+    size_t result_size = 0;
+    for (auto &response : responses) {
+      process_response(response);
+      if (response.object != nullptr) {
+        if (&responses[result_size] != &response) {
+          responses[result_size] = std::move(response);
+        }
+        result_size++;
+      }
+    }
+    responses.erase(responses.begin() + result_size, responses.end());
+    return responses;
+  }
+
+  // releases resources of closed clients; the response is emptied if it must not be returned
+  void process_response(Response &response) {
     if (response.request_id == 0 && response.object != nullptr &&
         response.object->get_id() == td_api::updateAuthorizationState::ID &&
         static_cast<const td_api::updateAuthorizationState *>(response.object.get())->authorization_state_->get_id() ==
@@ -546,7 +667,6 @@ class ClientManager::Impl final {
         pool_.try_clear();
       }
     }
-    return response;
   }
 
   void close_impl(ClientId client_id) {
@@ -679,6 +799,10 @@ ClientManager::Response ClientManager::receive(double timeout) {
   return impl_->receive(timeout);
 }
 
+std::vector<ClientManager::Response> ClientManager::receive_batch(std::size_t max_count, double timeout) {
+  return impl_->receive_batch(max_count, timeout);
+}
+
 td_api::object_ptr<td_api::Object> ClientManager::execute(td_api::object_ptr<td_api::Function> &&request) {
   return Td::static_request(std::move(request));
 }
@@ -713,6 +837,14 @@ void ClientManager::set_log_message_callback(int max_verbosity_level, LogMessage
   }
 }
 
+void ClientManager::set_thread_options(const ThreadOptions &options) {
+#if TD_THREAD_UNSUPPORTED || TD_EVENTFD_UNSUPPORTED
+  (void)options;
+#else
+  MultiImplPool::set_thread_options(options);
+#endif
+}
+
 ClientManager::ClientManager(ClientManager &&) noexcept = default;
 ClientManager &ClientManager::operator=(ClientManager &&) noexcept = default;
 ClientManager::~ClientManager() = default;
@@ -11,8 +11,10 @@
 #include "td/telegram/td_api.h"
 #include "td/telegram/td_api.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace td {
 
@@ -115,6 +117,19 @@ class ClientManager final {
    */
   Response receive(double timeout);
 
+  /**
+   * Receives all available incoming updates and responses to requests from TDLib, but no more than max_count of them.
+   * Waits for new data only if there are no available updates and responses. The method is much faster than
+   * ClientManager::receive, if there are many incoming updates. May be called from any thread, but must not be called
+   * simultaneously from two different threads, including simultaneous calls with ClientManager::receive.
+   * \param[in] max_count The maximum number of received updates and responses.
+   * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+   * \return Incoming updates and responses to requests in the order they were received. All objects in the responses
+   *         are non-null. The list is empty if the timeout expires, but can also be empty before the timeout expires,
+   *         for example, if only internal responses were received. The wait isn't restarted in this case.
+   */
+  std::vector<Response> receive_batch(std::size_t max_count, double timeout);
+
   /**
    * Synchronously executes a TDLib request.
    * A request can be executed synchronously, only if it is documented with "Can be called synchronously".
@@ -144,6 +159,60 @@ class ClientManager final {
    */
   static void set_log_message_callback(int max_verbosity_level, LogMessageCallbackPtr callback);
 
+  /**
+   * Options, which control distribution of TDLib client instances between threads.
+   */
+  struct ThreadOptions {
+    /**
+     * The maximum number of groups of threads, between which TDLib client instances are distributed.
+     * Each group has a main thread, in which client instances are running, and additional threads.
+     * Pass 0 to choose the number automatically, based on the number of available CPU cores.
+     */
+    std::int32_t instance_count = 0;
+
+    /**
+     * The number of additional threads in each group from 0 up to 4. The threads are used for database access,
+     * garbage collection, network requests and message database reads respectively. If there are less than 4 additional
+     * threads, then the tasks share the last thread, or are performed in the main thread if there are no additional
+     * threads.
+     */
+    std::int32_t additional_thread_count = 4;
+
+    /**
+     * CPU affinity mask for main threads of the groups, or 0 if the affinity mask must not be changed.
+     */
+    std::uint64_t main_thread_affinity_mask = 0;
+
+    /**
+     * CPU affinity mask for threads used for database access, or 0 if the affinity mask must not be changed.
+     */
+    std::uint64_t database_thread_affinity_mask = 0;
+
+    /**
+     * CPU affinity mask for threads used for garbage collection, or 0 if the affinity mask must not be changed.
+     */
+    std::uint64_t gc_thread_affinity_mask = 0;
+
+    /**
+     * CPU affinity mask for threads used for network requests, or 0 if the affinity mask must not be changed.
+     */
+    std::uint64_t network_thread_affinity_mask = 0;
+
+    /**
+     * CPU affinity mask for threads used for message database reads, or 0 if the affinity mask must not be changed.
+     */
+    std::uint64_t database_read_thread_affinity_mask = 0;
+  };
+
+  /**
+   * Changes options, which control distribution of TDLib client instances between threads.
+   * The options are applied only when the threads are created, therefore the method must be called before the first
+   * request is sent to any TDLib client instance. The options are shared by all ClientManager and Client objects.
+   *
+   * \param[in] options New thread options.
+   */
+  static void set_thread_options(const ThreadOptions &options);
+
   /**
    * Destroys the client manager and all TDLib client instances managed by it.
    */
@@ -0,0 +1,102 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/ClientBinary.h"
+
+#include "td/telegram/td_api.h"
+
+#include "td/utils/ExitGuard.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
+
+#include <cstring>
+#include <utility>
+
+namespace td {
+
+static td_api::object_ptr<td_api::Function> get_return_error_function(Slice error_message) {
+  auto error = td_api::make_object<td_api::error>(400, error_message.str());
+  return td_api::make_object<td_api::testReturnError>(std::move(error));
+}
+
+static TD_THREAD_LOCAL string *current_output;
+
+Slice binary_encode_object(const td_api::Object &object) {
+  init_thread_local<string>(current_output);
+  auto &output = *current_output;
+
+  TlStorerCalcLength calc_length;
+  calc_length.store_binary(object.get_id());
+  object.store(calc_length);
+  auto length = calc_length.get_length();
+
+  // the buffer is reused between calls, so it is resized only if needed
+  if (output.size() < length) {
+    output.resize(length);
+  }
+  TlStorerUnsafe storer(MutableSlice(output).ubegin());
+  storer.store_binary(object.get_id());
+  object.store(storer);
+  CHECK(storer.get_buf() == MutableSlice(output).ubegin() + length);
+  return Slice(output).substr(0, length);
+}
+
+td_api::object_ptr<td_api::Function> binary_decode_function(Slice request) {
+  vector<int32> aligned_request;
+  if (!is_aligned_pointer<4>(request.begin())) {
+    aligned_request.resize((request.size() + 3) / 4);
+    std::memcpy(aligned_request.data(), request.begin(), request.size());
+    request = Slice(reinterpret_cast<const char *>(aligned_request.data()), request.size());
+  }
+
+  TlParser parser(request);
+  auto function = td_api::Function::fetch(parser);
+  parser.fetch_end();
+  auto status = parser.get_status();
+  if (status.is_error() || function == nullptr) {
+    return get_return_error_function(PSLICE() << "Failed to parse TDLib request: " << status.message());
+  }
+  return function;
+}
+
+static ClientManager *get_manager() {
+  // binary interface uses its own ClientManager, so request identifiers can be chosen by the caller
+  static ClientManager client_manager;
+  static ExitGuard exit_guard;
+  return &client_manager;
+}
+
+int binary_create_client_id() {
+  return static_cast<int>(get_manager()->create_client_id());
+}
+
+void binary_send(int client_id, uint64 request_id, Slice request) {
+  if (request_id == 0) {
+    LOG(ERROR) << "Drop request with zero identifier";
+    return;
+  }
+  get_manager()->send(client_id, request_id, binary_decode_function(request));
+}
+
+Slice binary_receive(double timeout, int &client_id, uint64 &request_id) {
+  auto response = get_manager()->receive(timeout);
+  client_id = static_cast<int>(response.client_id);
+  request_id = response.request_id;
+  if (!response.object) {
+    return Slice();
+  }
+  return binary_encode_object(*response.object);
+}
+
+Slice binary_execute(Slice request) {
+  return binary_encode_object(*ClientManager::execute(binary_decode_function(request)));
+}
+
+}  // namespace td
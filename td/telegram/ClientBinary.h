@@ -0,0 +1,31 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/Client.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+namespace td {
+
+// returns TL-serialized boxed object; the result is stored in a per-thread buffer and is valid until the next call to
+// any binary interface function in the same thread
+Slice binary_encode_object(const td_api::Object &object);
+
+// returns a request, which returns an error if the request can't be parsed
+td_api::object_ptr<td_api::Function> binary_decode_function(Slice request);
+
+int binary_create_client_id();
+
+void binary_send(int client_id, uint64 request_id, Slice request);
+
+Slice binary_receive(double timeout, int &client_id, uint64 &request_id);
+
+Slice binary_execute(Slice request);
+
+}  // namespace td
@@ -12,9 +12,9 @@
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/JsonBuilder.h"
+#include "td/utils/logging.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/SliceBuilder.h"
-#include "td/utils/StackAllocator.h"
 #include "td/utils/StringBuilder.h"
 
 #include <utility>
@@ -53,40 +53,108 @@ static std::pair<td_api::object_ptr<td_api::Function>, string> to_request(Slice
   return std::make_pair(std::move(func), std::move(extra));
 }
 
-static string from_response(const td_api::Object &object, const string &extra, int client_id) {
-  auto buf = StackAllocator::alloc(1 << 18);
-  JsonBuilder jb(StringBuilder(buf.as_slice(), true), -1);
-  jb.enter_value() << ToJson(object);
-  auto &sb = jb.string_builder();
-  auto slice = sb.as_cslice();
-  CHECK(!slice.empty() && slice.back() == '}');
-  sb.pop_back();
-  if (!extra.empty()) {
-    sb << ",\"@extra\":" << extra;
+namespace {
+
+// JSON representations of responses are built directly in a per-thread buffer, which is reused between calls,
+// so the representations are never copied after serialization
+class JsonResponseBuffer {
+ public:
+  void start() {
+    if (last_size_ > MAX_KEPT_BUFFER_SIZE) {
+      // free memory allocated for a big response
+      sb_ = StringBuilder();
+    }
+    sb_.clear();
+  }
+
+  void append(const td_api::Object &object, Slice extra, int client_id) {
+    JsonBuilder jb(std::move(sb_), -1);
+    jb.enter_value() << ToJson(object);
+    sb_ = std::move(jb.string_builder());
+
+    CHECK(sb_.size() > 0 && sb_.as_cslice().back() == '}');
+    sb_.pop_back();
+    if (!extra.empty()) {
+      sb_ << ",\"@extra\":" << extra;
+    }
+    if (client_id != 0) {
+      sb_ << ",\"@client_id\":" << client_id;
+    }
+    sb_ << '}';
+  }
+
+  void append_char(char c) {
+    sb_.push_back(c);
   }
-  if (client_id != 0) {
-    sb << ",\"@client_id\":" << client_id;
+
+  CSlice finish() {
+    LOG_IF(ERROR, sb_.is_error()) << "JSON buffer overflow";
+    last_size_ = sb_.size();
+    return sb_.as_cslice();
+  }
+
+  CSlice store(const td_api::Object &object, Slice extra, int client_id) {
+    start();
+    append(object, extra, client_id);
+    return finish();
   }
-  sb << '}';
-  return sb.as_cslice().str();
+
+ private:
+  static constexpr size_t MAX_KEPT_BUFFER_SIZE = 1 << 20;
+
+  StringBuilder sb_;
+  size_t last_size_ = 0;
+};
+
+}  // namespace
+
+static TD_THREAD_LOCAL JsonResponseBuffer *current_output;
+
+static JsonResponseBuffer &get_output() {
+  init_thread_local<JsonResponseBuffer>(current_output);
+  return *current_output;
+}
+
+CSlice json_encode_response(const td_api::Object &object, Slice extra, int client_id) {
+  return get_output().store(object, extra, client_id);
 }
 
-static TD_THREAD_LOCAL string *current_output;
+std::uint64_t JsonRequestExtraStorage::add(std::string &&extra) {
+  auto request_id = next_request_id_.fetch_add(1, std::memory_order_relaxed);
+  if (!extra.empty()) {
+    // consecutive request identifiers belong to different shards
+    auto &shard = shards_[request_id % SHARD_COUNT];
+    std::lock_guard<std::mutex> guard(shard.mutex_);
+    shard.extra_[request_id] = std::move(extra);
+    shard.size_.store(shard.extra_.size(), std::memory_order_release);
+  }
+  return request_id;
+}
 
-static const char *store_string(string str) {
-  init_thread_local<string>(current_output);
-  *current_output = std::move(str);
-  return current_output->c_str();
+std::string JsonRequestExtraStorage::extract(std::uint64_t request_id) {
+  std::string result;
+  if (request_id == 0) {
+    return result;
+  }
+  auto &shard = shards_[request_id % SHARD_COUNT];
+  if (shard.size_.load(std::memory_order_acquire) == 0) {
+    // the "@extra" field is added before the request is sent, so it must be visible here if it exists
+    return result;
+  }
+  std::lock_guard<std::mutex> guard(shard.mutex_);
+  auto it = shard.extra_.find(request_id);
+  if (it != shard.extra_.end()) {
+    result = std::move(it->second);
+    shard.extra_.erase(it);
+    shard.size_.store(shard.extra_.size(), std::memory_order_release);
+  }
+  return result;
 }
 
 void ClientJson::send(Slice request) {
   auto parsed_request = to_request(request);
-  std::uint64_t extra_id = extra_id_.fetch_add(1, std::memory_order_relaxed);
-  if (!parsed_request.second.empty()) {
-    std::lock_guard<std::mutex> guard(mutex_);
-    extra_[extra_id] = std::move(parsed_request.second);
-  }
-  client_.send(Client::Request{extra_id, std::move(parsed_request.first)});
+  auto request_id = extra_storage_.add(std::move(parsed_request.second));
+  client_.send(Client::Request{request_id, std::move(parsed_request.first)});
 }
 
 const char *ClientJson::receive(double timeout) {
@@ -95,31 +163,22 @@ const char *ClientJson::receive(double timeout) {
     return nullptr;
   }
 
-  string extra;
-  if (response.id != 0) {
-    std::lock_guard<std::mutex> guard(mutex_);
-    auto it = extra_.find(response.id);
-    if (it != extra_.end()) {
-      extra = std::move(it->second);
-      extra_.erase(it);
-    }
-  }
-  return store_string(from_response(*response.object, extra, 0));
+  auto extra = extra_storage_.extract(response.id);
+  return json_encode_response(*response.object, extra, 0).c_str();
 }
 
 const char *ClientJson::execute(Slice request) {
   auto parsed_request = to_request(request);
-  return store_string(from_response(*Client::execute(Client::Request{0, std::move(parsed_request.first)}).object,
-                                    parsed_request.second, 0));
+  return json_encode_response(*Client::execute(Client::Request{0, std::move(parsed_request.first)}).object,
+                              parsed_request.second, 0)
+      .c_str();
 }
 
 static ClientManager *get_manager() {
   return ClientManager::get_manager_singleton();
 }
 
-static std::mutex extra_mutex;
-static FlatHashMap<int64, string> extra;
-static std::atomic<uint64> extra_id{1};
+static JsonRequestExtraStorage extra_storage;
 
 int json_create_client_id() {
   return static_cast<int>(get_manager()->create_client_id());
@@ -127,36 +186,55 @@ int json_create_client_id() {
 
 void json_send(int client_id, Slice request) {
   auto parsed_request = to_request(request);
-  auto request_id = extra_id.fetch_add(1, std::memory_order_relaxed);
-  if (!parsed_request.second.empty()) {
-    std::lock_guard<std::mutex> guard(extra_mutex);
-    extra[request_id] = std::move(parsed_request.second);
-  }
+  auto request_id = extra_storage.add(std::move(parsed_request.second));
   get_manager()->send(client_id, request_id, std::move(parsed_request.first));
 }
 
-const char *json_receive(double timeout) {
+const char *json_receive(double timeout, size_t *length) {
   auto response = get_manager()->receive(timeout);
   if (!response.object) {
+    if (length != nullptr) {
+      *length = 0;
+    }
+    return nullptr;
+  }
+
+  auto extra = extra_storage.extract(response.request_id);
+  auto result = json_encode_response(*response.object, extra, response.client_id);
+  if (length != nullptr) {
+    *length = result.size();
+  }
+  return result.c_str();
+}
+
+const char *json_receive_batch(int max_count, double timeout) {
+  if (max_count <= 0) {
+    return nullptr;
+  }
+  auto responses = get_manager()->receive_batch(static_cast<size_t>(max_count), timeout);
+  if (responses.empty()) {
     return nullptr;
   }
 
-  string extra_str;
-  if (response.request_id != 0) {
-    std::lock_guard<std::mutex> guard(extra_mutex);
-    auto it = extra.find(response.request_id);
-    if (it != extra.end()) {
-      extra_str = std::move(it->second);
-      extra.erase(it);
+  auto &output = get_output();
+  output.start();
+  output.append_char('[');
+  for (size_t i = 0; i < responses.size(); i++) {
+    if (i != 0) {
+      output.append_char(',');
     }
+    auto &response = responses[i];
+    auto extra = extra_storage.extract(response.request_id);
+    output.append(*response.object, extra, response.client_id);
   }
-  return store_string(from_response(*response.object, extra_str, response.client_id));
+  output.append_char(']');
+  return output.finish().c_str();
 }
 
 const char *json_execute(Slice request) {
   auto parsed_request = to_request(request);
-  return store_string(
-      from_response(*ClientManager::execute(std::move(parsed_request.first)), parsed_request.second, 0));
+  return json_encode_response(*ClientManager::execute(std::move(parsed_request.first)), parsed_request.second, 0)
+      .c_str();
 }
 
 }  // namespace td
@@ -9,15 +9,43 @@
 #include "td/telegram/Client.h"
 
 #include "td/utils/FlatHashMap.h"
+#include "td/utils/port/platform.h"
 #include "td/utils/Slice.h"
 
+#include <array>
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <mutex>
 #include <string>
 
 namespace td {
 
+// stores "@extra" fields of pending requests until responses to them are received
+// the storage is split into shards by request identifier, so concurrent sends and receives almost never wait each other
+class JsonRequestExtraStorage {
+ public:
+  // returns identifier for a new request with the given "@extra" field
+  std::uint64_t add(std::string &&extra);
+
+  // returns "@extra" field of the request and forgets it; returns an empty string if the request has no "@extra" field
+  std::string extract(std::uint64_t request_id);
+
+ private:
+  static constexpr std::size_t SHARD_COUNT = 64;
+
+  struct Shard {
+    std::atomic<std::size_t> size_{0};  // for lock-free check whether the shard is empty
+    std::mutex mutex_;                  // for extra_
+    FlatHashMap<std::uint64_t, std::string> extra_;
+    char pad[TD_CONCURRENCY_PAD];
+  };
+
+  std::atomic<std::uint64_t> next_request_id_{1};
+  char pad[TD_CONCURRENCY_PAD - sizeof(std::atomic<std::uint64_t>)];
+  std::array<Shard, SHARD_COUNT> shards_;
+};
+
 // TODO can be removed in TDLib 2.0
 class ClientJson final {
  public:
@@ -29,16 +57,20 @@ class ClientJson final {
 
  private:
   Client client_;
-  std::mutex mutex_;  // for extra_
-  FlatHashMap<std::int64_t, std::string> extra_;
-  std::atomic<std::uint64_t> extra_id_{1};
+  JsonRequestExtraStorage extra_storage_;
 };
 
+// returns JSON representation of the object with the given "@extra" and "@client_id" fields;
+// the result is stored in a per-thread buffer and is valid until the next call to any JSON interface function
+CSlice json_encode_response(const td_api::Object &object, Slice extra, int client_id);
+
 int json_create_client_id();
 
 void json_send(int client_id, Slice request);
 
-const char *json_receive(double timeout);
+const char *json_receive(double timeout, std::size_t *length = nullptr);
+
+const char *json_receive_batch(int max_count, double timeout);
 
 const char *json_execute(Slice request);
 
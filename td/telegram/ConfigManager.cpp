@@ -328,6 +328,8 @@ static ActorOwn<> get_full_config(DcOption option, Promise<tl_object_ptr<telegra
     }
     void on_closed() final {
     }
+    void on_connection_state_changed(bool is_connected) final {
+    }
     void request_raw_connection(unique_ptr<mtproto::AuthData> auth_data,
                                 Promise<unique_ptr<mtproto::RawConnection>> promise) final {
       request_raw_connection_cnt_++;
@@ -32,6 +32,7 @@ Global::Global() {
   database_scheduler_id_ = min(current_scheduler_id + 1, max_scheduler_id);
   gc_scheduler_id_ = min(current_scheduler_id + 2, max_scheduler_id);
   slow_net_scheduler_id_ = min(current_scheduler_id + 3, max_scheduler_id);
+  database_read_scheduler_id_ = min(current_scheduler_id + 4, max_scheduler_id);
 }
 
 Global::~Global() = default;
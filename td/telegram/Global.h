@@ -62,6 +62,7 @@ class MessageImportManager;
 class MessagesManager;
 class NetQueryDispatcher;
 class NetQueryStats;
+class NetStatsManager;
 class NotificationManager;
 class NotificationSettingsManager;
 class OnlineManager;
@@ -191,6 +192,13 @@ class Global final : public ActorContext {
     state_manager_ = state_manager;
   }
 
+  ActorId<NetStatsManager> net_stats_manager() const {
+    return net_stats_manager_;
+  }
+  void set_net_stats_manager(ActorId<NetStatsManager> net_stats_manager) {
+    net_stats_manager_ = net_stats_manager;
+  }
+
   ActorId<Td> td() const {
     return td_;
   }
@@ -590,6 +598,10 @@ class Global final : public ActorContext {
     return slow_net_scheduler_id_;
   }
 
+  int32 get_database_read_scheduler_id() const {
+    return database_read_scheduler_id_;
+  }
+
   DcId get_webfile_dc_id() const;
 
   std::shared_ptr<DhConfig> get_dh_config() {
@@ -736,6 +748,7 @@ class Global final : public ActorContext {
   int32 database_scheduler_id_ = 0;
   int32 gc_scheduler_id_ = 0;
   int32 slow_net_scheduler_id_ = 0;
+  int32 database_read_scheduler_id_ = 0;
 
   std::atomic<bool> store_all_files_in_files_directory_{false};
 
@@ -755,6 +768,7 @@ class Global final : public ActorContext {
   std::vector<std::shared_ptr<NetStatsCallback>> net_stats_file_callbacks_;
 
   ActorId<StateManager> state_manager_;
+  ActorId<NetStatsManager> net_stats_manager_;
 
   LazySchedulerLocalStorage<unique_ptr<NetQueryCreator>> net_query_creator_;
   unique_ptr<NetQueryDispatcher> net_query_dispatcher_;
@@ -15,6 +15,7 @@
 #include "td/db/SqliteStatement.h"
 
 #include "td/actor/actor.h"
+#include "td/actor/MultiPromise.h"
 #include "td/actor/SchedulerLocalStorage.h"
 
 #include "td/utils/format.h"
@@ -984,8 +985,10 @@ std::shared_ptr<MessageDbSyncSafeInterface> create_message_db_sync(
 
 class MessageDbAsync final : public MessageDbAsyncInterface {
  public:
-  MessageDbAsync(std::shared_ptr<MessageDbSyncSafeInterface> sync_db, int32 scheduler_id) {
-    impl_ = create_actor_on_scheduler<Impl>("MessageDbActor", scheduler_id, std::move(sync_db));
+  MessageDbAsync(std::shared_ptr<MessageDbSyncSafeInterface> sync_db, int32 scheduler_id,
+                 vector<int32> read_scheduler_ids) {
+    impl_ = create_actor_on_scheduler<Impl>("MessageDbActor", scheduler_id, std::move(sync_db),
+                                            std::move(read_scheduler_ids));
   }
 
   void add_message(MessageFullId message_full_id, ServerMessageId unique_message_id, DialogId sender_dialog_id,
@@ -1064,40 +1067,114 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
   }
 
  private:
+  // executes read queries using its own scheduler-local database connection
+  class Reader final : public Actor {
+   public:
+    explicit Reader(std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe) : sync_db_safe_(std::move(sync_db_safe)) {
+    }
+
+    void get_message(MessageFullId message_full_id, Promise<MessageDbDialogMessage> promise) {
+      promise.set_result(sync_db_->get_message(message_full_id));
+    }
+    void get_message_by_unique_message_id(ServerMessageId unique_message_id, Promise<MessageDbMessage> promise) {
+      promise.set_result(sync_db_->get_message_by_unique_message_id(unique_message_id));
+    }
+    void get_message_by_random_id(DialogId dialog_id, int64 random_id, Promise<MessageDbDialogMessage> promise) {
+      promise.set_result(sync_db_->get_message_by_random_id(dialog_id, random_id));
+    }
+    void get_dialog_message_by_date(DialogId dialog_id, MessageId first_message_id, MessageId last_message_id,
+                                    int32 date, Promise<MessageDbDialogMessage> promise) {
+      promise.set_result(sync_db_->get_dialog_message_by_date(dialog_id, first_message_id, last_message_id, date));
+    }
+
+    void get_dialog_message_calendar(MessageDbDialogCalendarQuery query, Promise<MessageDbCalendar> promise) {
+      promise.set_value(sync_db_->get_dialog_message_calendar(std::move(query)));
+    }
+
+    void get_dialog_sparse_message_positions(MessageDbGetDialogSparseMessagePositionsQuery query,
+                                             Promise<MessageDbMessagePositions> promise) {
+      promise.set_result(sync_db_->get_dialog_sparse_message_positions(std::move(query)));
+    }
+
+    void get_messages(MessageDbMessagesQuery query, Promise<vector<MessageDbDialogMessage>> promise) {
+      promise.set_value(sync_db_->get_messages(std::move(query)));
+    }
+    void get_scheduled_messages(DialogId dialog_id, int32 limit, Promise<vector<MessageDbDialogMessage>> promise) {
+      promise.set_value(sync_db_->get_scheduled_messages(dialog_id, limit));
+    }
+    void get_messages_from_notification_id(DialogId dialog_id, NotificationId from_notification_id, int32 limit,
+                                           Promise<vector<MessageDbDialogMessage>> promise) {
+      promise.set_value(sync_db_->get_messages_from_notification_id(dialog_id, from_notification_id, limit));
+    }
+    void get_calls(MessageDbCallsQuery query, Promise<MessageDbCallsResult> promise) {
+      promise.set_value(sync_db_->get_calls(std::move(query)));
+    }
+    void get_messages_fts(MessageDbFtsQuery query, Promise<MessageDbFtsResult> promise) {
+      promise.set_value(sync_db_->get_messages_fts(std::move(query)));
+    }
+    void get_expiring_messages(int32 expires_till, int32 limit, Promise<vector<MessageDbMessage>> promise) {
+      promise.set_value(sync_db_->get_expiring_messages(expires_till, limit));
+    }
+
+    void close(Promise<> promise) {
+      sync_db_safe_.reset();
+      sync_db_ = nullptr;
+      promise.set_value(Unit());
+      stop();
+    }
+
+   private:
+    std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe_;
+    MessageDbSyncInterface *sync_db_ = nullptr;
+
+    void start_up() final {
+      sync_db_ = &sync_db_safe_->get();
+    }
+  };
+
   class Impl final : public Actor {
    public:
-    explicit Impl(std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe) : sync_db_safe_(std::move(sync_db_safe)) {
+    Impl(std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe, vector<int32> read_scheduler_ids)
+        : sync_db_safe_(std::move(sync_db_safe)), read_scheduler_ids_(std::move(read_scheduler_ids)) {
     }
     void add_message(MessageFullId message_full_id, ServerMessageId unique_message_id, DialogId sender_dialog_id,
                      int64 random_id, int32 ttl_expires_at, int32 index_mask, int64 search_id, string text,
                      NotificationId notification_id, MessageId top_thread_message_id, BufferSlice data,
                      Promise<> promise) {
-      add_write_query([this, message_full_id, unique_message_id, sender_dialog_id, random_id, ttl_expires_at,
-                       index_mask, search_id, text = std::move(text), notification_id, top_thread_message_id,
-                       data = std::move(data), promise = std::move(promise)](Unit) mutable {
-        sync_db_->add_message(message_full_id, unique_message_id, sender_dialog_id, random_id, ttl_expires_at,
-                              index_mask, search_id, std::move(text), notification_id, top_thread_message_id,
-                              std::move(data));
-        on_write_result(std::move(promise));
-      });
+      pending_writes_.emplace_back();
+      auto &write = pending_writes_.back();
+      write.type_ = PendingWrite::Type::AddMessage;
+      write.message_full_id_ = message_full_id;
+      write.unique_message_id_ = unique_message_id;
+      write.sender_dialog_id_ = sender_dialog_id;
+      write.random_id_ = random_id;
+      write.ttl_expires_at_ = ttl_expires_at;
+      write.index_mask_ = index_mask;
+      write.search_id_ = search_id;
+      write.text_ = std::move(text);
+      write.notification_id_ = notification_id;
+      write.top_thread_message_id_ = top_thread_message_id;
+      write.data_ = std::move(data);
+      write.promise_ = std::move(promise);
+      on_write_query_added();
     }
     void add_scheduled_message(MessageFullId message_full_id, BufferSlice data, Promise<> promise) {
-      add_write_query([this, message_full_id, promise = std::move(promise), data = std::move(data)](Unit) mutable {
-        sync_db_->add_scheduled_message(message_full_id, std::move(data));
-        on_write_result(std::move(promise));
-      });
+      pending_writes_.emplace_back();
+      auto &write = pending_writes_.back();
+      write.type_ = PendingWrite::Type::AddScheduledMessage;
+      write.message_full_id_ = message_full_id;
+      write.data_ = std::move(data);
+      write.promise_ = std::move(promise);
+      on_write_query_added();
     }
 
     void delete_message(MessageFullId message_full_id, Promise<> promise) {
-      add_write_query([this, message_full_id, promise = std::move(promise)](Unit) mutable {
-        sync_db_->delete_message(message_full_id);
-        on_write_result(std::move(promise));
-      });
-    }
-
-    void on_write_result(Promise<Unit> &&promise) {
-      // We are inside a transaction and don't know how to handle errors
-      finished_writes_.push_back(std::move(promise));
+      pending_writes_.emplace_back();
+      auto &write = pending_writes_.back();
+      write.type_ = PendingWrite::Type::DeleteMessage;
+      write.message_full_id_ = message_full_id;
+      write.promise_ = std::move(promise);
+      on_write_query_added();
     }
 
     void delete_all_dialog_messages(DialogId dialog_id, MessageId from_message_id, Promise<> promise) {
@@ -1114,64 +1191,80 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
 
     void get_message(MessageFullId message_full_id, Promise<MessageDbDialogMessage> promise) {
       add_read_query();
-      promise.set_result(sync_db_->get_message(message_full_id));
+      send_closure(get_reader(message_full_id.get_dialog_id()), &Reader::get_message, message_full_id,
+                   std::move(promise));
     }
     void get_message_by_unique_message_id(ServerMessageId unique_message_id, Promise<MessageDbMessage> promise) {
       add_read_query();
-      promise.set_result(sync_db_->get_message_by_unique_message_id(unique_message_id));
+      send_closure(get_reader(), &Reader::get_message_by_unique_message_id, unique_message_id, std::move(promise));
     }
     void get_message_by_random_id(DialogId dialog_id, int64 random_id, Promise<MessageDbDialogMessage> promise) {
       add_read_query();
-      promise.set_result(sync_db_->get_message_by_random_id(dialog_id, random_id));
+      send_closure(get_reader(dialog_id), &Reader::get_message_by_random_id, dialog_id, random_id, std::move(promise));
     }
     void get_dialog_message_by_date(DialogId dialog_id, MessageId first_message_id, MessageId last_message_id,
                                     int32 date, Promise<MessageDbDialogMessage> promise) {
       add_read_query();
-      promise.set_result(sync_db_->get_dialog_message_by_date(dialog_id, first_message_id, last_message_id, date));
+      send_closure(get_reader(dialog_id), &Reader::get_dialog_message_by_date, dialog_id, first_message_id,
+                   last_message_id, date, std::move(promise));
     }
 
     void get_dialog_message_calendar(MessageDbDialogCalendarQuery query, Promise<MessageDbCalendar> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_dialog_message_calendar(std::move(query)));
+      auto reader = get_reader(query.dialog_id);
+      send_closure(reader, &Reader::get_dialog_message_calendar, std::move(query), std::move(promise));
     }
 
     void get_dialog_sparse_message_positions(MessageDbGetDialogSparseMessagePositionsQuery query,
                                              Promise<MessageDbMessagePositions> promise) {
       add_read_query();
-      promise.set_result(sync_db_->get_dialog_sparse_message_positions(std::move(query)));
+      auto reader = get_reader(query.dialog_id);
+      send_closure(reader, &Reader::get_dialog_sparse_message_positions, std::move(query), std::move(promise));
     }
 
     void get_messages(MessageDbMessagesQuery query, Promise<vector<MessageDbDialogMessage>> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_messages(std::move(query)));
+      auto reader = get_reader(query.dialog_id);
+      send_closure(reader, &Reader::get_messages, std::move(query), std::move(promise));
     }
     void get_scheduled_messages(DialogId dialog_id, int32 limit, Promise<vector<MessageDbDialogMessage>> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_scheduled_messages(dialog_id, limit));
+      send_closure(get_reader(dialog_id), &Reader::get_scheduled_messages, dialog_id, limit, std::move(promise));
     }
     void get_messages_from_notification_id(DialogId dialog_id, NotificationId from_notification_id, int32 limit,
                                            Promise<vector<MessageDbDialogMessage>> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_messages_from_notification_id(dialog_id, from_notification_id, limit));
+      send_closure(get_reader(dialog_id), &Reader::get_messages_from_notification_id, dialog_id, from_notification_id,
+                   limit, std::move(promise));
     }
     void get_calls(MessageDbCallsQuery query, Promise<MessageDbCallsResult> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_calls(std::move(query)));
+      send_closure(get_reader(), &Reader::get_calls, std::move(query), std::move(promise));
     }
     void get_messages_fts(MessageDbFtsQuery query, Promise<MessageDbFtsResult> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_messages_fts(std::move(query)));
+      auto reader = query.dialog_id.is_valid() ? get_reader(query.dialog_id) : get_reader();
+      send_closure(reader, &Reader::get_messages_fts, std::move(query), std::move(promise));
     }
     void get_expiring_messages(int32 expires_till, int32 limit, Promise<vector<MessageDbMessage>> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_expiring_messages(expires_till, limit));
+      send_closure(get_reader(), &Reader::get_expiring_messages, expires_till, limit, std::move(promise));
     }
 
     void close(Promise<> promise) {
       do_flush();
       sync_db_safe_.reset();
       sync_db_ = nullptr;
-      promise.set_value(Unit());
+
+      // the database connections must not be used after the promise is set
+      MultiPromiseActorSafe mpas{"MessageDbCloseMultiPromiseActor"};
+      mpas.add_promise(std::move(promise));
+      auto lock = mpas.get_promise();
+      for (auto &reader : readers_) {
+        send_closure(reader.release(), &Reader::close, mpas.get_promise());
+      }
+      readers_.clear();
+      lock.set_value(Unit());
       stop();
     }
 
@@ -1184,20 +1277,40 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
     std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe_;
     MessageDbSyncInterface *sync_db_ = nullptr;
 
-    static constexpr size_t MAX_PENDING_QUERIES_COUNT{50};
-    static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
+    vector<int32> read_scheduler_ids_;
+    vector<ActorOwn<Reader>> readers_;
+    size_t next_reader_ = 0;
 
-    //NB: order is important, destructor of pending_writes_ will change finished_writes_
-    vector<Promise<Unit>> finished_writes_;
-    vector<Promise<Unit>> pending_writes_;  // TODO use Action
+    // the batch size is adapted to keep a write transaction shorter than MAX_COMMIT_TIME
+    static constexpr size_t MIN_PENDING_QUERIES_COUNT{50};
+    static constexpr size_t MAX_PENDING_QUERIES_COUNT{1000};
+    static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
+    static constexpr double MAX_COMMIT_TIME{0.005};
+
+    // the arguments of a queued write query; the queries are stored contiguously in a reused buffer
+    struct PendingWrite {
+      enum class Type : int32 { AddMessage, AddScheduledMessage, DeleteMessage };
+      Type type_ = Type::AddMessage;
+      MessageFullId message_full_id_;
+      ServerMessageId unique_message_id_;
+      DialogId sender_dialog_id_;
+      int64 random_id_ = 0;
+      int32 ttl_expires_at_ = 0;
+      int32 index_mask_ = 0;
+      int64 search_id_ = 0;
+      string text_;
+      NotificationId notification_id_;
+      MessageId top_thread_message_id_;
+      BufferSlice data_;
+      Promise<Unit> promise_;
+    };
+    vector<PendingWrite> pending_writes_;
+    size_t max_pending_writes_ = MIN_PENDING_QUERIES_COUNT;
     double wakeup_at_ = 0;
 
-    template <class F>
-    void add_write_query(F &&f) {
-      pending_writes_.push_back(PromiseCreator::lambda(std::forward<F>(f)));
-      if (pending_writes_.size() > MAX_PENDING_QUERIES_COUNT) {
+    void on_write_query_added() {
+      if (pending_writes_.size() > max_pending_writes_) {
         do_flush();
-        wakeup_at_ = 0;
       } else if (wakeup_at_ == 0) {
         wakeup_at_ = Time::now_cached() + MAX_PENDING_QUERIES_DELAY;
       }
@@ -1205,18 +1318,70 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
         set_timeout_at(wakeup_at_);
       }
     }
+    // all pending writes must be committed before a read query is started, so the query sees them
     void add_read_query() {
       do_flush();
     }
+
+    // queries for the same chat are handled by the same reader, so their results are returned in order
+    ActorId<Reader> get_reader(DialogId dialog_id) {
+      return readers_[static_cast<uint64>(dialog_id.get()) % readers_.size()].get();
+    }
+
+    ActorId<Reader> get_reader() {
+      if (++next_reader_ == readers_.size()) {
+        next_reader_ = 0;
+      }
+      return readers_[next_reader_].get();
+    }
     void do_flush() {
       if (pending_writes_.empty()) {
         return;
       }
+      auto start_time = Time::now();
       sync_db_->begin_write_transaction().ensure();
-      set_promises(pending_writes_);
+      for (auto &write : pending_writes_) {
+        switch (write.type_) {
+          case PendingWrite::Type::AddMessage:
+            sync_db_->add_message(write.message_full_id_, write.unique_message_id_, write.sender_dialog_id_,
+                                  write.random_id_, write.ttl_expires_at_, write.index_mask_, write.search_id_,
+                                  std::move(write.text_), write.notification_id_, write.top_thread_message_id_,
+                                  std::move(write.data_));
+            break;
+          case PendingWrite::Type::AddScheduledMessage:
+            sync_db_->add_scheduled_message(write.message_full_id_, std::move(write.data_));
+            break;
+          case PendingWrite::Type::DeleteMessage:
+            sync_db_->delete_message(write.message_full_id_);
+            break;
+          default:
+            UNREACHABLE();
+        }
+      }
       sync_db_->commit_transaction().ensure();
-      set_promises(finished_writes_);
+      auto commit_time = Time::now() - start_time;
+
+      // grow full batches while commits are fast and shrink them if commits become too slow
+      if (commit_time > MAX_COMMIT_TIME) {
+        max_pending_writes_ = max(max_pending_writes_ / 2, MIN_PENDING_QUERIES_COUNT);
+      } else if (commit_time < MAX_COMMIT_TIME / 2 && pending_writes_.size() > max_pending_writes_) {
+        max_pending_writes_ = min(max_pending_writes_ * 2, MAX_PENDING_QUERIES_COUNT);
+      }
+
+      auto writes = std::move(pending_writes_);
+      pending_writes_.clear();
+      wakeup_at_ = 0;
       cancel_timeout();
+
+      // we are outside of the transaction now, so the promises can be safely set
+      for (auto &write : writes) {
+        write.promise_.set_value(Unit());
+      }
+      if (pending_writes_.empty()) {
+        // reuse the memory
+        writes.clear();
+        pending_writes_ = std::move(writes);
+      }
     }
     void timeout_expired() final {
       do_flush();
@@ -1224,14 +1389,21 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
 
     void start_up() final {
       sync_db_ = &sync_db_safe_->get();
+
+      if (read_scheduler_ids_.empty()) {
+        readers_.push_back(create_actor<Reader>("MessageDbReader", sync_db_safe_));
+      }
+      for (auto scheduler_id : read_scheduler_ids_) {
+        readers_.push_back(create_actor_on_scheduler<Reader>("MessageDbReader", scheduler_id, sync_db_safe_));
+      }
     }
   };
   ActorOwn<Impl> impl_;
 };
 
 std::shared_ptr<MessageDbAsyncInterface> create_message_db_async(std::shared_ptr<MessageDbSyncSafeInterface> sync_db,
-                                                                 int32 scheduler_id) {
-  return std::make_shared<MessageDbAsync>(std::move(sync_db), scheduler_id);
+                                                                 int32 scheduler_id, vector<int32> read_scheduler_ids) {
+  return std::make_shared<MessageDbAsync>(std::move(sync_db), scheduler_id, std::move(read_scheduler_ids));
 }
 
 }  // namespace td
@@ -165,6 +165,10 @@ OptionManager::OptionManager(Td *td)
     update_premium_options();
   }
 
+  if (options.isset("binlog_force_sync_delay_ms") || options.isset("binlog_force_sync_batch_size_max")) {
+    update_binlog_sync_options();
+  }
+
   set_option_empty("archive_and_mute_new_chats_from_unknown_users");
   set_option_empty("business_intro_title_length_max");
   set_option_empty("business_intro_message_length_max");
@@ -180,6 +184,12 @@ OptionManager::OptionManager(Td *td)
 
 OptionManager::~OptionManager() = default;
 
+void OptionManager::update_binlog_sync_options() {
+  auto max_force_sync_delay = static_cast<double>(get_option_integer("binlog_force_sync_delay_ms", 3)) * 1e-3;
+  auto max_force_sync_batch_size = static_cast<size_t>(get_option_integer("binlog_force_sync_batch_size_max", 0));
+  G()->td_db()->set_binlog_sync_options(max_force_sync_delay, max_force_sync_batch_size);
+}
+
 void OptionManager::update_premium_options() {
   bool is_premium = get_option_boolean("is_premium");
   if (is_premium) {
@@ -510,6 +520,9 @@ void OptionManager::on_option_updated(Slice name) {
       if (name == "base_language_pack_version") {
         send_closure(td_->language_pack_manager_, &LanguagePackManager::on_language_pack_version_changed, true, -1);
       }
+      if (name == "binlog_force_sync_delay_ms" || name == "binlog_force_sync_batch_size_max") {
+        update_binlog_sync_options();
+      }
       break;
     case 'c':
       if (name == "connection_parameters") {
@@ -813,6 +826,14 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       */
       break;
+    case 'b':
+      if (set_integer_option("binlog_force_sync_delay_ms", 0, 1000)) {
+        return;
+      }
+      if (set_integer_option("binlog_force_sync_batch_size_max", 0, 10000)) {
+        return;
+      }
+      break;
     case 'c':
       if (!is_bot && set_string_option("connection_parameters", [](Slice value) {
             string value_copy = value.str();
@@ -989,6 +1010,14 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
         return;
       }
       break;
+    case 'w':
+      if (set_integer_option("warm_connection_count_max", 0, 8)) {
+        return;
+      }
+      if (set_integer_option("warm_media_connection_count_max", 0, 8)) {
+        return;
+      }
+      break;
     case 'X':
     case 'x': {
       if (name.size() > 255) {
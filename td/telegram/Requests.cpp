@@ -2785,6 +2785,37 @@ void Requests::on_request(uint64 id, td_api::getNetworkStatistics &request) {
                std::move(query_promise));
 }
 
+void Requests::on_request(uint64 id, const td_api::getNetworkConnectionStatistics &request) {
+  if (td_->net_stats_manager_.empty()) {
+    return send_error_raw(id, 400, "Network statistics are disabled");
+  }
+  CREATE_REQUEST_PROMISE();
+  auto query_promise =
+      PromiseCreator::lambda([promise = std::move(promise)](Result<vector<SessionStatsEntry>> result) mutable {
+        if (result.is_error()) {
+          return promise.set_error(result.move_as_error());
+        }
+        string statistics = "sessions:\n";
+        for (auto &entry : result.ok()) {
+          statistics += PSTRING() << entry << '\n';
+        }
+        send_closure(G()->connection_creator(), &ConnectionCreator::get_connection_pool_stats,
+                     PromiseCreator::lambda([statistics = std::move(statistics), promise = std::move(promise)](
+                                                Result<vector<std::pair<string, ConnectionPoolStats>>> r_stats) mutable {
+                       if (r_stats.is_error()) {
+                         return promise.set_error(r_stats.move_as_error());
+                       }
+                       statistics += "connection pools:\n";
+                       for (auto &stats : r_stats.ok()) {
+                         statistics += PSTRING() << stats.first << ' ' << stats.second << '\n';
+                       }
+                       promise.set_value(
+                           td_api::make_object<td_api::networkConnectionStatistics>(std::move(statistics)));
+                     }));
+      });
+  send_closure(td_->net_stats_manager_, &NetStatsManager::get_session_stats, std::move(query_promise));
+}
+
 void Requests::on_request(uint64 id, td_api::resetNetworkStatistics &request) {
   if (td_->net_stats_manager_.empty()) {
     return send_error_raw(id, 400, "Network statistics are disabled");
@@ -7776,6 +7807,14 @@ void Requests::on_request(uint64 id, const td_api::addLogMessage &request) {
   UNREACHABLE();
 }
 
+void Requests::on_request(uint64 id, const td_api::setActorStatisticsEnabled &request) {
+  UNREACHABLE();
+}
+
+void Requests::on_request(uint64 id, const td_api::getActorStatistics &request) {
+  UNREACHABLE();
+}
+
 // test
 void Requests::on_request(uint64 id, const td_api::testNetwork &request) {
   CREATE_OK_REQUEST_PROMISE();
@@ -319,6 +319,8 @@ class Requests {
 
   void on_request(uint64 id, td_api::getNetworkStatistics &request);
 
+  void on_request(uint64 id, const td_api::getNetworkConnectionStatistics &request);
+
   void on_request(uint64 id, td_api::resetNetworkStatistics &request);
 
   void on_request(uint64 id, td_api::addNetworkStatistics &request);
@@ -1655,6 +1657,10 @@ class Requests {
 
   void on_request(uint64 id, const td_api::addLogMessage &request);
 
+  void on_request(uint64 id, const td_api::setActorStatisticsEnabled &request);
+
+  void on_request(uint64 id, const td_api::getActorStatistics &request);
+
   void on_request(uint64 id, const td_api::testNetwork &request);
 
   void on_request(uint64 id, td_api::testProxy &request);
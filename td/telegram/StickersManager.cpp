@@ -6275,7 +6275,8 @@ void StickersManager::load_custom_emoji_sticker_from_database_force(CustomEmojiI
   CustomEmojiLogEvent log_event;
   if (log_event_parse(log_event, value).is_error()) {
     LOG(ERROR) << "Delete invalid " << custom_emoji_id << " value from database";
-    G()->td_db()->get_sqlite_sync_pmc()->erase(get_custom_emoji_database_key(custom_emoji_id));
+    // the value must be erased through the asynchronous interface, which caches values
+    G()->td_db()->get_sqlite_pmc()->erase(get_custom_emoji_database_key(custom_emoji_id), Auto());
   }
 }
 
@@ -23,6 +23,7 @@
 #include "td/utils/port/Stat.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
 
 namespace td {
@@ -94,12 +95,34 @@ void StorageManager::get_storage_stats_fast(Promise<FileStatsFast> promise) {
 
 void StorageManager::get_database_stats(Promise<DatabaseStats> promise) {
   //TODO: use another thread
-  auto r_stats = G()->td_db()->get_stats();
-  if (r_stats.is_error()) {
-    promise.set_error(r_stats.move_as_error());
-  } else {
-    promise.set_value(DatabaseStats(r_stats.move_as_ok()));
+  TRY_RESULT_PROMISE(promise, stats, G()->td_db()->get_stats());
+  G()->td_db()->get_binlog_sync_stats(
+      PromiseCreator::lambda([actor_id = actor_id(this), stats = std::move(stats),
+                              promise = std::move(promise)](Result<string> r_binlog_sync_stats) mutable {
+        send_closure(actor_id, &StorageManager::on_get_binlog_sync_stats, std::move(stats),
+                     std::move(r_binlog_sync_stats), std::move(promise));
+      }));
+}
+
+void StorageManager::on_get_binlog_sync_stats(string stats, Result<string> r_binlog_sync_stats,
+                                              Promise<DatabaseStats> promise) {
+  if (r_binlog_sync_stats.is_ok()) {
+    stats += PSTRING() << "binlog sync:\n" << r_binlog_sync_stats.ok() << '\n';
+  }
+  G()->td_db()->get_key_value_stats(
+      PromiseCreator::lambda([actor_id = actor_id(this), stats = std::move(stats),
+                              promise = std::move(promise)](Result<string> r_key_value_stats) mutable {
+        send_closure(actor_id, &StorageManager::on_get_key_value_stats, std::move(stats),
+                     std::move(r_key_value_stats), std::move(promise));
+      }));
+}
+
+void StorageManager::on_get_key_value_stats(string stats, Result<string> r_key_value_stats,
+                                            Promise<DatabaseStats> promise) {
+  if (r_key_value_stats.is_ok()) {
+    stats += PSTRING() << "key-value database:\n" << r_key_value_stats.ok() << '\n';
   }
+  promise.set_value(DatabaseStats(std::move(stats)));
 }
 
 void StorageManager::update_use_storage_optimizer() {
@@ -62,6 +62,8 @@ class StorageManager final : public Actor {
   CancellationTokenSource gc_cancellation_token_source_;
 
   void on_file_stats(Result<FileStats> r_file_stats, uint32 generation);
+  void on_get_binlog_sync_stats(string stats, Result<string> r_binlog_sync_stats, Promise<DatabaseStats> promise);
+  void on_get_key_value_stats(string stats, Result<string> r_key_value_stats, Promise<DatabaseStats> promise);
   void create_stats_worker();
   void update_fast_stats(const FileStats &stats);
   static void send_stats(FileStats &&stats, int32 dialog_limit, std::vector<Promise<FileStats>> &&promises);
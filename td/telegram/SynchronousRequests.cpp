@@ -21,6 +21,9 @@
 #include "td/telegram/td_api.hpp"
 #include "td/telegram/ThemeManager.h"
 
+#include "td/actor/ActorStatistics.h"
+
+#include "td/utils/algorithm.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
@@ -104,6 +107,8 @@ bool SynchronousRequests::is_synchronous_request(const td_api::Function *functio
     case td_api::setLogTagVerbosityLevel::ID:
     case td_api::getLogTagVerbosityLevel::ID:
     case td_api::addLogMessage::ID:
+    case td_api::setActorStatisticsEnabled::ID:
+    case td_api::getActorStatistics::ID:
     case td_api::testReturnError::ID:
       return true;
     case td_api::getOption::ID:
@@ -389,6 +394,21 @@ td_api::object_ptr<td_api::Object> SynchronousRequests::do_request(const td_api:
   return td_api::make_object<td_api::ok>();
 }
 
+td_api::object_ptr<td_api::Object> SynchronousRequests::do_request(const td_api::setActorStatisticsEnabled &request) {
+  ActorStatistics::set_enabled(request.is_enabled_);
+  return td_api::make_object<td_api::ok>();
+}
+
+td_api::object_ptr<td_api::Object> SynchronousRequests::do_request(const td_api::getActorStatistics &request) {
+  auto entries = transform(ActorStatistics::get_entries(), [](const ActorStatistics::Entry &entry) {
+    return td_api::make_object<td_api::actorStatisticsEntry>(
+        entry.name, static_cast<int64>(entry.event_count), entry.total_duration, entry.max_duration,
+        entry.average_wait_time, entry.max_wait_time,
+        static_cast<int32>(min(entry.max_mailbox_size, static_cast<uint64>(std::numeric_limits<int32>::max()))));
+  });
+  return td_api::make_object<td_api::actorStatistics>(ActorStatistics::get_since_date(), std::move(entries));
+}
+
 td_api::object_ptr<td_api::Object> SynchronousRequests::do_request(td_api::testReturnError &request) {
   if (request.error_ == nullptr) {
     return td_api::make_object<td_api::error>(404, "Not Found");
@@ -83,6 +83,10 @@ class SynchronousRequests {
 
   static td_api::object_ptr<td_api::Object> do_request(const td_api::addLogMessage &request);
 
+  static td_api::object_ptr<td_api::Object> do_request(const td_api::setActorStatisticsEnabled &request);
+
+  static td_api::object_ptr<td_api::Object> do_request(const td_api::getActorStatistics &request);
+
   static td_api::object_ptr<td_api::Object> do_request(td_api::testReturnError &request);
 };
 
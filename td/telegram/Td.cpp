@@ -209,6 +209,7 @@ bool Td::is_preauthentication_request(int32 id) {
     case td_api::getDatabaseStatistics::ID:
     case td_api::setNetworkType::ID:
     case td_api::getNetworkStatistics::ID:
+    case td_api::getNetworkConnectionStatistics::ID:
     case td_api::addNetworkStatistics::ID:
     case td_api::resetNetworkStatistics::ID:
     case td_api::setApplicationVerificationToken::ID:
@@ -327,8 +328,14 @@ void Td::run_request(uint64 id, td_api::object_ptr<td_api::Function> function) {
               });
           auto use_sqlite_pmc = parameters.second.use_message_database_ || parameters.second.use_chat_info_database_ ||
                                 parameters.second.use_file_database_;
-          return TdDb::open(use_sqlite_pmc ? G()->get_database_scheduler_id() : G()->get_slow_net_scheduler_id(),
-                            std::move(parameters.second), std::move(promise));
+          auto database_scheduler_id =
+              use_sqlite_pmc ? G()->get_database_scheduler_id() : G()->get_slow_net_scheduler_id();
+          // message database reads are done on a dedicated scheduler in parallel with database writes
+          auto database_read_scheduler_id = G()->get_database_read_scheduler_id();
+          if (database_read_scheduler_id != database_scheduler_id) {
+            parameters.second.message_db_read_scheduler_ids_.push_back(database_read_scheduler_id);
+          }
+          return TdDb::open(database_scheduler_id, std::move(parameters.second), std::move(promise));
         }
         default:
           if (is_preinitialization_request(function_id)) {
@@ -841,11 +848,13 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
     G()->connection_creator().get_actor_unsafe()->set_net_stats_callback(
         net_stats_manager_ptr->get_common_stats_callback(), net_stats_manager_ptr->get_media_stats_callback());
     G()->set_net_stats_file_callbacks(net_stats_manager_ptr->get_file_stats_callbacks());
+    G()->set_net_stats_manager(net_stats_manager_.get());
   }
 
   complete_pending_preauthentication_requests([](int32 id) {
     switch (id) {
       case td_api::getNetworkStatistics::ID:
+      case td_api::getNetworkConnectionStatistics::ID:
       case td_api::addNetworkStatistics::ID:
       case td_api::resetNetworkStatistics::ID:
         return true;
@@ -1379,6 +1388,21 @@ Result<std::pair<Td::Parameters, TdDb::Parameters>> Td::get_parameters(
   result.second.use_file_database_ = parameters->use_file_database_;
   result.second.use_chat_info_database_ = parameters->use_chat_info_database_;
   result.second.use_message_database_ = parameters->use_message_database_;
+  if (parameters->database_profile_ != nullptr) {
+    switch (parameters->database_profile_->get_id()) {
+      case td_api::databaseProfileDefault::ID:
+        result.second.database_profile_ = TdDb::DatabaseProfile::Default;
+        break;
+      case td_api::databaseProfileLowMemory::ID:
+        result.second.database_profile_ = TdDb::DatabaseProfile::LowMemory;
+        break;
+      case td_api::databaseProfileHighPerformance::ID:
+        result.second.database_profile_ = TdDb::DatabaseProfile::HighPerformance;
+        break;
+      default:
+        UNREACHABLE();
+    }
+  }
 
   VLOG(td_init) << "Create MtprotoHeader::Options";
   options_.api_id = parameters->api_id_;
@@ -20,6 +20,7 @@
 #include "td/db/binlog/Binlog.h"
 #include "td/db/binlog/ConcurrentBinlog.h"
 #include "td/db/BinlogKeyValue.h"
+#include "td/db/SqliteCheckpointer.h"
 #include "td/db/SqliteConnectionSafe.h"
 #include "td/db/SqliteDb.h"
 #include "td/db/SqliteKeyValue.h"
@@ -55,6 +56,20 @@ std::string get_sqlite_path(const TdDb::Parameters &parameters) {
   return parameters.database_directory_ + db_name + ".sqlite";
 }
 
+SqliteConnectionSettings get_sqlite_settings(TdDb::DatabaseProfile database_profile) {
+  switch (database_profile) {
+    case TdDb::DatabaseProfile::Default:
+      return SqliteConnectionSettings();
+    case TdDb::DatabaseProfile::LowMemory:
+      return SqliteConnectionSettings::low_memory();
+    case TdDb::DatabaseProfile::HighPerformance:
+      return SqliteConnectionSettings::high_performance();
+    default:
+      UNREACHABLE();
+      return SqliteConnectionSettings();
+  }
+}
+
 Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_pmc, BinlogKeyValue<Binlog> &config_pmc,
                    TdDb::OpenedDatabase &events, DbKey key) {
   auto r_binlog_stat = stat(path);
@@ -308,6 +323,11 @@ void TdDb::do_close(bool destroy_flag, Promise<Unit> on_finished) {
     file_db_.reset();
   }
 
+  if (sql_checkpointer_) {
+    sql_checkpointer_->close(mpas.get_promise());
+    sql_checkpointer_.reset();
+  }
+
   common_kv_safe_.reset();
   if (common_kv_async_) {
     common_kv_async_->close(mpas.get_promise());
@@ -351,7 +371,7 @@ void TdDb::do_close(bool destroy_flag, Promise<Unit> on_finished) {
   lock.set_value(Unit());
 }
 
-Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const DbKey &old_key,
+Status TdDb::init_sqlite(int32 scheduler_id, const Parameters &parameters, const DbKey &key, const DbKey &old_key,
                          BinlogKeyValue<Binlog> &binlog_pmc) {
   CHECK(!parameters.use_message_database_ || parameters.use_chat_info_database_);
   CHECK(!parameters.use_chat_info_database_ || parameters.use_file_database_);
@@ -373,11 +393,11 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   }
 
   TRY_RESULT(db_instance, SqliteDb::change_key(sql_database_path, true, key, old_key));
-  sql_connection_ = std::make_shared<SqliteConnectionSafe>(sql_database_path, key, db_instance.get_cipher_version());
+  sql_connection_ = std::make_shared<SqliteConnectionSafe>(sql_database_path, key, db_instance.get_cipher_version(),
+                                                           get_sqlite_settings(parameters.database_profile_));
+  TRY_STATUS(sql_connection_->init_connection(db_instance));
   sql_connection_->set(std::move(db_instance));
   auto &db = sql_connection_->get();
-  TRY_STATUS(db.exec("PRAGMA journal_mode=WAL"));
-  TRY_STATUS(db.exec("PRAGMA secure_delete=1"));
 
   // Init databases
   // Do initialization once and before everything else to avoid "database is locked" error.
@@ -457,10 +477,11 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
 
   TRY_STATUS(db.exec("COMMIT TRANSACTION"));
 
-  file_db_ = create_file_db(sql_connection_);
+  file_db_ = create_file_db(sql_connection_, scheduler_id);
+  sql_checkpointer_ = create_sqlite_checkpointer(sql_connection_, scheduler_id);
 
   common_kv_safe_ = std::make_shared<SqliteKeyValueSafe>("common", sql_connection_);
-  common_kv_async_ = create_sqlite_key_value_async(common_kv_safe_);
+  common_kv_async_ = create_sqlite_key_value_async(common_kv_safe_, scheduler_id);
 
   if (was_dialog_db_created_) {
     auto *sqlite_pmc = get_sqlite_sync_pmc();
@@ -471,22 +492,23 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
 
   if (use_dialog_db) {
     dialog_db_sync_safe_ = create_dialog_db_sync(sql_connection_);
-    dialog_db_async_ = create_dialog_db_async(dialog_db_sync_safe_);
+    dialog_db_async_ = create_dialog_db_async(dialog_db_sync_safe_, scheduler_id);
   }
 
   if (use_message_thread_db) {
     message_thread_db_sync_safe_ = create_message_thread_db_sync(sql_connection_);
-    message_thread_db_async_ = create_message_thread_db_async(message_thread_db_sync_safe_);
+    message_thread_db_async_ = create_message_thread_db_async(message_thread_db_sync_safe_, scheduler_id);
   }
 
   if (use_message_database) {
     message_db_sync_safe_ = create_message_db_sync(sql_connection_);
-    message_db_async_ = create_message_db_async(message_db_sync_safe_);
+    message_db_async_ =
+        create_message_db_async(message_db_sync_safe_, scheduler_id, parameters.message_db_read_scheduler_ids_);
   }
 
   if (use_story_database) {
     story_db_sync_safe_ = create_story_db_sync(sql_connection_);
-    story_db_async_ = create_story_db_async(story_db_sync_safe_);
+    story_db_async_ = create_story_db_async(story_db_sync_safe_, scheduler_id);
   }
 
   return Status::OK();
@@ -494,12 +516,12 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
 
 void TdDb::open(int32 scheduler_id, Parameters parameters, Promise<OpenedDatabase> &&promise) {
   Scheduler::instance()->run_on_scheduler(
-      scheduler_id, [parameters = std::move(parameters), promise = std::move(promise)](Unit) mutable {
-        TdDb::open_impl(std::move(parameters), std::move(promise));
+      scheduler_id, [scheduler_id, parameters = std::move(parameters), promise = std::move(promise)](Unit) mutable {
+        TdDb::open_impl(scheduler_id, std::move(parameters), std::move(promise));
       });
 }
 
-void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
+void TdDb::open_impl(int32 scheduler_id, Parameters parameters, Promise<OpenedDatabase> &&promise) {
   TRY_STATUS_PROMISE(promise, check_parameters(parameters));
 
   OpenedDatabase result;
@@ -552,7 +574,7 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
   }
   VLOG(td_init) << "Start to init database";
   auto db = make_unique<TdDb>();
-  auto init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
+  auto init_sqlite_status = db->init_sqlite(scheduler_id, parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
   VLOG(td_init) << "Finish to init database";
   if (init_sqlite_status.is_error()) {
     LOG(ERROR) << "Destroy bad SQLite database because of " << init_sqlite_status;
@@ -560,7 +582,7 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
       db->sql_connection_->get().close();
     }
     SqliteDb::destroy(get_sqlite_path(parameters)).ignore();
-    init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
+    init_sqlite_status = db->init_sqlite(scheduler_id, parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
     if (init_sqlite_status.is_error()) {
       return promise.set_error(Status::Error(400, init_sqlite_status.message()));
     }
@@ -673,6 +695,34 @@ void TdDb::change_key(DbKey key, Promise<> promise) {
   get_binlog()->change_key(std::move(key), std::move(promise));
 }
 
+void TdDb::set_binlog_sync_options(double max_force_sync_delay, size_t max_force_sync_batch_size) {
+  CHECK(binlog_ != nullptr);
+  ConcurrentBinlog::SyncOptions options;
+  options.max_force_sync_delay = max_force_sync_delay;
+  options.max_force_sync_batch_size = max_force_sync_batch_size;
+  binlog_->set_sync_options(options);
+}
+
+void TdDb::get_binlog_sync_stats(Promise<string> promise) {
+  CHECK(binlog_ != nullptr);
+  binlog_->get_sync_stats(
+      PromiseCreator::lambda([promise = std::move(promise)](Result<ConcurrentBinlog::SyncStats> r_stats) mutable {
+        TRY_RESULT_PROMISE(promise, stats, std::move(r_stats));
+        promise.set_value(PSTRING() << stats);
+      }));
+}
+
+void TdDb::get_key_value_stats(Promise<string> promise) {
+  if (common_kv_async_ == nullptr) {
+    return promise.set_error(Status::Error(500, "Key-value database isn't used"));
+  }
+  common_kv_async_->get_stats(PromiseCreator::lambda(
+      [promise = std::move(promise)](Result<SqliteKeyValueAsyncInterface::Stats> r_stats) mutable {
+        TRY_RESULT_PROMISE(promise, stats, std::move(r_stats));
+        promise.set_value(PSTRING() << stats);
+      }));
+}
+
 Status TdDb::destroy(const Parameters &parameters) {
   SqliteDb::destroy(get_sqlite_path(parameters)).ignore();
   Binlog::destroy(get_binlog_path(parameters)).ignore();
@@ -35,6 +35,7 @@ class MessageDbAsyncInterface;
 class MessageThreadDbSyncInterface;
 class MessageThreadDbSyncSafeInterface;
 class MessageThreadDbAsyncInterface;
+class SqliteCheckpointerInterface;
 class SqliteConnectionSafe;
 class SqliteKeyValueSafe;
 class SqliteKeyValueAsyncInterface;
@@ -52,6 +53,8 @@ class TdDb {
   TdDb &operator=(TdDb &&) = delete;
   ~TdDb();
 
+  enum class DatabaseProfile : int32 { Default, LowMemory, HighPerformance };
+
   struct Parameters {
     DbKey encryption_key_;
     string database_directory_;
@@ -60,6 +63,8 @@ class TdDb {
     bool use_file_database_ = false;
     bool use_chat_info_database_ = false;
     bool use_message_database_ = false;
+    vector<int32> message_db_read_scheduler_ids_;
+    DatabaseProfile database_profile_ = DatabaseProfile::Default;
   };
 
   struct OpenedDatabase {
@@ -152,6 +157,12 @@ class TdDb {
 
   void change_key(DbKey key, Promise<> promise);
 
+  void set_binlog_sync_options(double max_force_sync_delay, size_t max_force_sync_batch_size);
+
+  void get_binlog_sync_stats(Promise<string> promise);
+
+  void get_key_value_stats(Promise<string> promise);
+
   void with_db_path(const std::function<void(CSlice)> &callback);
 
   Result<string> get_stats();
@@ -162,6 +173,7 @@ class TdDb {
   bool was_dialog_db_created_ = false;
 
   std::shared_ptr<SqliteConnectionSafe> sql_connection_;
+  unique_ptr<SqliteCheckpointerInterface> sql_checkpointer_;
 
   std::shared_ptr<FileDbInterface> file_db_;
 
@@ -184,11 +196,11 @@ class TdDb {
   std::shared_ptr<BinlogKeyValue<ConcurrentBinlog>> config_pmc_;
   std::shared_ptr<ConcurrentBinlog> binlog_;
 
-  static void open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise);
+  static void open_impl(int32 scheduler_id, Parameters parameters, Promise<OpenedDatabase> &&promise);
 
   static Status check_parameters(Parameters &parameters);
 
-  Status init_sqlite(const Parameters &parameters, const DbKey &key, const DbKey &old_key,
+  Status init_sqlite(int32 scheduler_id, const Parameters &parameters, const DbKey &key, const DbKey &old_key,
                      BinlogKeyValue<Binlog> &binlog_pmc);
 
   void do_close(bool destroy_flag, Promise<Unit> on_finished);
@@ -3647,6 +3647,8 @@ class CliClient final : public Actor {
       send_request(td_api::make_object<td_api::getNetworkStatistics>());
     } else if (op == "current_network") {
       send_request(td_api::make_object<td_api::getNetworkStatistics>(true));
+    } else if (op == "network_connections") {
+      send_request(td_api::make_object<td_api::getNetworkConnectionStatistics>());
     } else if (op == "reset_network") {
       send_request(td_api::make_object<td_api::resetNetworkStatistics>());
     } else if (op == "snt") {
@@ -7190,6 +7192,12 @@ class CliClient final : public Actor {
       } else {
         execute(std::move(request));
       }
+    } else if (op == "sase") {
+      bool is_enabled;
+      get_args(args, is_enabled);
+      execute(td_api::make_object<td_api::setActorStatisticsEnabled>(is_enabled));
+    } else if (op == "gas") {
+      execute(td_api::make_object<td_api::getActorStatistics>());
     } else if (op == "q" || op == "Quit") {
       quit();
     } else if (op == "dnq") {
@@ -148,6 +148,21 @@ void ConnectionCreator::set_net_stats_callback(std::shared_ptr<NetStatsCallback>
   media_net_stats_callback_ = std::move(media_callback);
 }
 
+void ConnectionCreator::get_connection_pool_stats(Promise<vector<std::pair<string, ConnectionPoolStats>>> promise) {
+  vector<std::pair<string, ConnectionPoolStats>> result;
+  for (auto &it : clients_) {
+    const auto &client = it.second;
+    if (!client.inited) {
+      continue;
+    }
+    result.emplace_back(PSTRING() << client.dc_id << (client.is_media ? " media" : "")
+                                  << (client.allow_media_only ? " media-only" : "") << ' '
+                                  << format::as_hex(client.hash),
+                        client.warm_connection_pool.get_stats());
+  }
+  promise.set_value(std::move(result));
+}
+
 void ConnectionCreator::add_proxy(int32 old_proxy_id, string server, int32 port, bool enable,
                                   td_api::object_ptr<td_api::ProxyType> proxy_type,
                                   Promise<td_api::object_ptr<td_api::proxy>> promise) {
@@ -746,7 +761,11 @@ void ConnectionCreator::request_raw_connection(DcId dc_id, bool allow_media_only
   client.auth_data_generation++;
   VLOG(connections) << "Request connection for " << tag("client", format::as_hex(client.hash)) << " to " << dc_id << " "
                     << tag("allow_media_only", allow_media_only);
-  client.queries.push_back(std::move(promise));
+  ClientInfo::Query query;
+  query.promise = std::move(promise);
+  query.requested_at = Time::now();
+  client.warm_connection_pool.on_request(query.requested_at);
+  client.queries.push_back(std::move(query));
 
   client_loop(client);
 }
@@ -955,22 +974,49 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 
   VLOG(connections) << "In client_loop: " << tag("client", format::as_hex(client.hash));
 
-  // Remove expired ready connections
-  td::remove_if(client.ready_connections,
-                [&, expires_at = Time::now_cached() - ClientInfo::READY_CONNECTIONS_TIMEOUT](auto &v) {
-                  bool drop = v.second < expires_at;
-                  VLOG_IF(connections, drop) << "Drop expired " << tag("connection", v.first.get());
-                  return drop;
-                });
+  // Spare connections are created in advance only while the user is online and only if enabled by the options
+  // warm_media_connection_count_max and warm_connection_count_max. A client is created for each session,
+  // so the limit applies per session and the total number of warm connections to a DC is multiplied by session_count
+  size_t max_warm_connection_count = 0;
+  if (online_flag_) {
+    auto option_value = client.is_media ? G()->get_option_integer("warm_media_connection_count_max", 0)
+                                        : G()->get_option_integer("warm_connection_count_max", 0);
+    max_warm_connection_count = static_cast<size_t>(clamp(option_value, static_cast<int64>(0), static_cast<int64>(8)));
+  }
+  auto now = Time::now_cached();
+  auto warm_connection_count = client.warm_connection_pool.get_warm_connection_count(now, max_warm_connection_count);
+
+  // Remove ready connections created for another network and expired ready connections, which aren't kept warm
+  {
+    auto left_connection_count = client.ready_connections.size();
+    td::remove_if(client.ready_connections, [&, expires_at = now - ClientInfo::READY_CONNECTIONS_TIMEOUT](auto &v) {
+      bool drop = v.connection->extra().extra != network_generation_ ||
+                  (v.ready_at < expires_at && client.warm_connection_pool.can_drop_expired_connection(
+                                                  left_connection_count, warm_connection_count));
+      VLOG_IF(connections, drop) << "Drop expired " << tag("connection", v.connection.get());
+      if (drop) {
+        left_connection_count--;
+      }
+      return drop;
+    });
+  }
 
   // Send ready connections into promises
   {
     auto begin = client.queries.begin();
     auto it = begin;
     while (it != client.queries.end() && !client.ready_connections.empty()) {
-      if (!it->is_canceled()) {
-        VLOG(connections) << "Send to promise " << tag("connection", client.ready_connections.back().first.get());
-        it->set_value(std::move(client.ready_connections.back().first));
+      if (!it->promise.is_canceled()) {
+        auto &ready_connection = client.ready_connections.back();
+        auto wait_time = max(now - it->requested_at, 0.0);
+        client.warm_connection_pool.on_connection_returned(ready_connection.ready_at <= it->requested_at,
+                                                           ready_connection.handshake_time, wait_time);
+        VLOG(connections) << "Send to promise " << tag("connection", ready_connection.connection.get()) << " after "
+                          << format::as_time(wait_time) << " instead of "
+                          << format::as_time(ready_connection.handshake_time) << " for "
+                          << tag("client", format::as_hex(client.hash)) << ' '
+                          << client.warm_connection_pool.get_stats();
+        it->promise.set_value(std::move(ready_connection.connection));
         client.ready_connections.pop_back();
       }
       ++it;
@@ -978,14 +1024,26 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
     client.queries.erase(begin, it);
   }
 
+  // Ping idle connections to find out whether they are still alive
+  td::remove_if(client.ready_connections, [&](auto &v) {
+    if (!client.warm_connection_pool.need_health_check(v.checked_at, now)) {
+      return false;
+    }
+    client_check_connection_health(client, std::move(v));
+    return true;
+  });
+  if (!client.ready_connections.empty()) {
+    client_set_timeout_at(client, Time::now() + ClientInfo::READY_CONNECTIONS_TIMEOUT);
+  }
+
+  auto preconnect_count =
+      client.warm_connection_pool.get_preconnect_count(client.ready_connections.size(), warm_connection_count);
+
   // Main loop. Create new connections till needed
   bool check_mode = client.checking_connections != 0 && !proxy.use_proxy();
   while (true) {
     // Check if we need new connections
-    if (client.queries.empty()) {
-      if (!client.ready_connections.empty()) {
-        client_set_timeout_at(client, Time::now() + ClientInfo::READY_CONNECTIONS_TIMEOUT);
-      }
+    if (client.queries.empty() && client.pending_connections >= preconnect_count) {
       return;
     }
     if (check_mode) {
@@ -993,7 +1051,7 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
         return;
       }
     } else {
-      if (client.pending_connections >= client.queries.size()) {
+      if (client.pending_connections >= client.queries.size() + preconnect_count) {
         return;
       }
     }
@@ -1042,6 +1100,10 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
     }
 #endif
 
+    if (client.pending_connections >= client.queries.size()) {
+      VLOG(connections) << "Preconnect for " << tag("client", format::as_hex(client.hash));
+      client.warm_connection_pool.on_connection_preconnected();
+    }
     client.pending_connections++;
     if (check_mode) {
       if (extra.stat) {
@@ -1052,10 +1114,11 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 
     auto promise = PromiseCreator::lambda(
         [actor_id = actor_id(this), check_mode, transport_type = extra.transport_type, hash = client.hash,
-         debug_str = extra.debug_str,
-         network_generation = network_generation_](Result<ConnectionData> r_connection_data) mutable {
+         debug_str = extra.debug_str, network_generation = network_generation_,
+         started_at = Time::now()](Result<ConnectionData> r_connection_data) mutable {
           send_closure(actor_id, &ConnectionCreator::client_create_raw_connection, std::move(r_connection_data),
-                       check_mode, std::move(transport_type), hash, std::move(debug_str), network_generation);
+                       check_mode, std::move(transport_type), hash, std::move(debug_str), network_generation,
+                       started_at);
         });
 
     auto stats_callback =
@@ -1073,7 +1136,8 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 
 void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_connection_data, bool check_mode,
                                                      mtproto::TransportType transport_type, uint32 hash,
-                                                     string debug_str, uint32 network_generation) {
+                                                     string debug_str, uint32 network_generation,
+                                                     double started_at) {
   unique_ptr<mtproto::AuthData> auth_data;
   uint64 auth_data_generation{0};
   uint64 session_id{0};
@@ -1089,7 +1153,8 @@ void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_co
     }
   }
   auto promise = PromiseCreator::lambda([actor_id = actor_id(this), hash, check_mode, auth_data_generation, session_id,
-                                         debug_str](Result<unique_ptr<mtproto::RawConnection>> result) mutable {
+                                         debug_str,
+                                         started_at](Result<unique_ptr<mtproto::RawConnection>> result) mutable {
     if (result.is_ok()) {
       VLOG(connections) << "Ready connection (" << (check_mode ? "" : "un") << "checked) " << result.ok().get() << ' '
                         << tag("rtt", format::as_time(result.ok()->extra().rtt)) << ' ' << debug_str;
@@ -1098,7 +1163,7 @@ void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_co
                         << debug_str;
     }
     send_closure(actor_id, &ConnectionCreator::client_add_connection, hash, std::move(result), check_mode,
-                 auth_data_generation, session_id);
+                 auth_data_generation, session_id, started_at);
   });
 
   if (r_connection_data.is_error()) {
@@ -1134,7 +1199,8 @@ void ConnectionCreator::client_set_timeout_at(ClientInfo &client, double wakeup_
 }
 
 void ConnectionCreator::client_add_connection(uint32 hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection,
-                                              bool check_flag, uint64 auth_data_generation, uint64 session_id) {
+                                              bool check_flag, uint64 auth_data_generation, uint64 session_id,
+                                              double started_at) {
   auto &client = clients_[hash];
   client.add_session_id(session_id);
   CHECK(client.pending_connections > 0);
@@ -1147,7 +1213,13 @@ void ConnectionCreator::client_add_connection(uint32 hash, Result<unique_ptr<mtp
     VLOG(connections) << "Add ready connection " << r_raw_connection.ok().get() << " for "
                       << tag("client", format::as_hex(hash));
     client.backoff.clear();
-    client.ready_connections.emplace_back(r_raw_connection.move_as_ok(), Time::now_cached());
+    ClientInfo::ReadyConnection ready_connection;
+    ready_connection.connection = r_raw_connection.move_as_ok();
+    ready_connection.ready_at = Time::now_cached();
+    ready_connection.checked_at = ready_connection.ready_at;
+    ready_connection.handshake_time = max(ready_connection.ready_at - started_at, 0.0);
+    client.warm_connection_pool.on_connection_created(ready_connection.handshake_time);
+    client.ready_connections.push_back(std::move(ready_connection));
   } else {
     if (r_raw_connection.error().code() == -404 && client.auth_data &&
         client.auth_data_generation == auth_data_generation) {
@@ -1159,6 +1231,42 @@ void ConnectionCreator::client_add_connection(uint32 hash, Result<unique_ptr<mtp
   client_loop(client);
 }
 
+void ConnectionCreator::client_check_connection_health(ClientInfo &client,
+                                                       ClientInfo::ReadyConnection &&ready_connection) {
+  VLOG(connections) << "Check health of " << tag("connection", ready_connection.connection.get()) << " for "
+                    << tag("client", format::as_hex(client.hash));
+  client.warm_connection_pool.on_health_check_started();
+  auto promise = PromiseCreator::lambda([actor_id = actor_id(this), hash = client.hash,
+                                         ready_at = ready_connection.ready_at,
+                                         handshake_time = ready_connection.handshake_time](
+                                            Result<unique_ptr<mtproto::RawConnection>> result) mutable {
+    send_closure(actor_id, &ConnectionCreator::client_on_connection_health_checked, hash, std::move(result), ready_at,
+                 handshake_time);
+  });
+  auto debug_str = ready_connection.connection->extra().debug_str;
+  auto token = next_token();
+  children_[token] = {true, create_ping_actor(debug_str, std::move(ready_connection.connection), nullptr,
+                                              std::move(promise), create_reference(token))};
+}
+
+void ConnectionCreator::client_on_connection_health_checked(uint32 hash,
+                                                            Result<unique_ptr<mtproto::RawConnection>> r_raw_connection,
+                                                            double ready_at, double handshake_time) {
+  auto &client = clients_[hash];
+  if (client.warm_connection_pool.on_health_check_finished(r_raw_connection.is_ok())) {
+    ClientInfo::ReadyConnection ready_connection;
+    ready_connection.connection = r_raw_connection.move_as_ok();
+    ready_connection.ready_at = ready_at;
+    ready_connection.checked_at = Time::now_cached();
+    ready_connection.handshake_time = handshake_time;
+    client.ready_connections.push_back(std::move(ready_connection));
+  } else {
+    VLOG(connections) << "Drop dead connection for " << tag("client", format::as_hex(hash)) << ": "
+                      << r_raw_connection.error();
+  }
+  client_loop(client);
+}
+
 void ConnectionCreator::client_wakeup(uint32 hash) {
   VLOG(connections) << tag("hash", format::as_hex(hash)) << " wakeup";
   G()->save_server_time();
@@ -11,6 +11,7 @@
 #include "td/telegram/net/DcOptionsSet.h"
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/net/Proxy.h"
+#include "td/telegram/net/WarmConnectionPool.h"
 #include "td/telegram/td_api.h"
 
 #include "td/mtproto/AuthData.h"
@@ -34,6 +35,7 @@
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
+#include "td/utils/StringBuilder.h"
 #include "td/utils/Time.h"
 
 #include <map>
@@ -82,6 +84,8 @@ class ConnectionCreator final : public NetQueryCallback {
 
   void test_proxy(Proxy &&proxy, int32 dc_id, double timeout, Promise<Unit> &&promise);
 
+  void get_connection_pool_stats(Promise<vector<std::pair<string, ConnectionPoolStats>>> promise);
+
  private:
   ActorShared<> parent_;
   DcOptionsSet dc_options_set_;
@@ -139,8 +143,22 @@ class ConnectionCreator final : public NetQueryCallback {
     Slot slot;
     size_t pending_connections{0};
     size_t checking_connections{0};
-    std::vector<std::pair<unique_ptr<mtproto::RawConnection>, double>> ready_connections;
-    std::vector<Promise<unique_ptr<mtproto::RawConnection>>> queries;
+
+    struct ReadyConnection {
+      unique_ptr<mtproto::RawConnection> connection;
+      double ready_at = 0.0;
+      double checked_at = 0.0;
+      double handshake_time = 0.0;
+    };
+    std::vector<ReadyConnection> ready_connections;
+
+    struct Query {
+      Promise<unique_ptr<mtproto::RawConnection>> promise;
+      double requested_at = 0.0;
+    };
+    std::vector<Query> queries;
+
+    WarmConnectionPool warm_connection_pool;
 
     static constexpr double READY_CONNECTIONS_TIMEOUT = 10;
 
@@ -228,9 +246,12 @@ class ConnectionCreator final : public NetQueryCallback {
   void client_loop(ClientInfo &client);
   void client_create_raw_connection(Result<ConnectionData> r_connection_data, bool check_mode,
                                     mtproto::TransportType transport_type, uint32 hash, string debug_str,
-                                    uint32 network_generation);
+                                    uint32 network_generation, double started_at);
   void client_add_connection(uint32 hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection, bool check_flag,
-                             uint64 auth_data_generation, uint64 session_id);
+                             uint64 auth_data_generation, uint64 session_id, double started_at);
+  void client_check_connection_health(ClientInfo &client, ClientInfo::ReadyConnection &&ready_connection);
+  void client_on_connection_health_checked(uint32 hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection,
+                                           double ready_at, double handshake_time);
   void client_set_timeout_at(ClientInfo &client, double wakeup_at);
 
   void on_proxy_resolved(Result<IPAddress> ip_address, bool dummy);
@@ -82,7 +82,8 @@ void NetQuery::resend(DcId new_dc_id) {
 
 bool NetQuery::update_is_ready() {
   if (state_ == State::Query) {
-    if (cancellation_token_.load(std::memory_order_relaxed) == 0 || cancel_slot_.was_signal()) {
+    if (cancellation_token_.load(std::memory_order_relaxed) == 0 || cancel_slot_.was_signal() ||
+        is_cancellation_source_canceled()) {
       set_error_canceled();
       return true;
     }
@@ -91,6 +92,15 @@ bool NetQuery::update_is_ready() {
   return true;
 }
 
+bool NetQuery::is_cancellation_source_canceled() const {
+  if (cancellation_source_.empty()) {
+    return false;
+  }
+  auto is_canceled = cancellation_source_->cancellation_token_.load(std::memory_order_relaxed) == 0;
+  // the source query could have been already destroyed and its memory reused
+  return is_canceled && cancellation_source_.is_alive();
+}
+
 void NetQuery::set_ok(BufferSlice slice) {
   VLOG(net_query) << "Receive answer " << *this;
   CHECK(state_ == State::Query);
@@ -184,6 +184,10 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   void set_cancellation_token(int32 cancellation_token) {
     cancellation_token_.store(cancellation_token, std::memory_order_relaxed);
   }
+  // the query is considered canceled also if the source query is canceled
+  void set_cancellation_source(NetQueryRef source) {
+    cancellation_source_ = source;
+  }
 
   void clear();
 
@@ -287,8 +291,11 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   uint64 message_id_{0};
 
   movable_atomic<int32> cancellation_token_{-1};  // == 0 if query is canceled
+  NetQueryRef cancellation_source_;
   ActorShared<NetQueryCallback> callback_;
 
+  bool is_cancellation_source_canceled() const;
+
   void set_error_impl(Status status, string source = string());
 
   static int32 tl_magic(const BufferSlice &buffer_slice);
@@ -301,6 +308,7 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   string source_;                   // for NetQueryDelayer/SequenceDispatcher
   int32 dispatch_ttl_ = -1;         // for NetQueryDispatcher and to be set by caller
   int32 file_type_ = -1;            // to be set by caller
+  uint64 send_generation_ = 0;      // for SessionMultiProxy
   Slot cancel_slot_;                // for Session and to be set by caller
   Promise<> quick_ack_promise_;     // for Session and to be set by caller
   bool need_resend_on_503_ = true;  // for NetQueryDispatcher and to be set by caller
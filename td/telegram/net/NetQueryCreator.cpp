@@ -107,4 +107,18 @@ NetQueryPtr NetQueryCreator::create(uint64 id, const telegram_api::object_ptr<te
   return query;
 }
 
+NetQueryPtr NetQueryCreator::create_copy(NetQueryPtr &net_query) {
+  auto query = object_pool_.create(UniqueId::next(), net_query->query().clone(), net_query->dc_id(), net_query->type(),
+                                   net_query->auth_flag(), net_query->gzip_flag(), net_query->tl_constructor(),
+                                   net_query->total_timeout_limit_, net_query_stats_.get(), vector<ChainId>());
+  init_copy(query, net_query);
+  return query;
+}
+
+void NetQueryCreator::init_copy(NetQueryPtr &copy, NetQueryPtr &net_query) {
+  copy->set_cancellation_token(copy.generation());
+  copy->set_cancellation_source(net_query.get_weak());
+  copy->file_type_ = net_query->file_type_;
+}
+
 }  // namespace td
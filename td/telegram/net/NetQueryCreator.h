@@ -46,6 +46,13 @@ class NetQueryCreator {
                      const telegram_api::Function &function, vector<ChainId> &&chain_ids, DcId dc_id,
                      NetQuery::Type type, NetQuery::AuthFlag auth_flag);
 
+  // creates a query with a new identifier, which can be sent independently of the original query,
+  // but is canceled together with it
+  NetQueryPtr create_copy(NetQueryPtr &net_query);
+
+  // links a newly created copy with the original query
+  static void init_copy(NetQueryPtr &copy, NetQueryPtr &net_query);
+
  private:
   std::shared_ptr<NetQueryStats> net_query_stats_;
   ObjectPool<NetQuery> object_pool_;
@@ -172,6 +172,32 @@ void NetStatsManager::add_network_stats(const NetworkStatsEntry &entry) {
   add_network_stats_impl(files_stats_[file_type_n], entry);
 }
 
+void NetStatsManager::update_session_stats(string proxy_name, vector<SessionLoadBalancer::Stats> stats) {
+  LOG(DEBUG) << "Update statistics of sessions of " << proxy_name << ": " << stats;
+  if (stats.empty()) {
+    session_stats_.erase(proxy_name);
+  } else {
+    session_stats_[proxy_name] = std::move(stats);
+  }
+}
+
+void NetStatsManager::get_session_stats(Promise<vector<SessionStatsEntry>> promise) {
+  vector<SessionStatsEntry> result;
+  for (auto &it : session_stats_) {
+    for (size_t i = 0; i < it.second.size(); i++) {
+      SessionStatsEntry entry;
+      entry.name = PSTRING() << it.first << '#' << i;
+      entry.stats = it.second[i];
+      result.push_back(std::move(entry));
+    }
+  }
+  promise.set_value(std::move(result));
+}
+
+StringBuilder &operator<<(StringBuilder &string_builder, const SessionStatsEntry &entry) {
+  return string_builder << entry.name << ' ' << entry.stats;
+}
+
 void NetStatsManager::add_network_stats_impl(NetStatsInfo &info, const NetworkStatsEntry &entry) {
   auto net_type_i = static_cast<size_t>(entry.net_type);
   auto &data = info.stats_by_type[net_type_i].mem_stats;
@@ -8,6 +8,7 @@
 
 #include "td/telegram/files/FileType.h"
 #include "td/telegram/net/NetType.h"
+#include "td/telegram/net/SessionLoadBalancer.h"
 #include "td/telegram/td_api.h"
 
 #include "td/net/NetStats.h"
@@ -17,8 +18,10 @@
 #include "td/utils/common.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
+#include "td/utils/StringBuilder.h"
 
 #include <array>
+#include <map>
 #include <memory>
 
 namespace td {
@@ -61,6 +64,13 @@ struct NetworkStats {
   }
 };
 
+struct SessionStatsEntry {
+  string name;
+  SessionLoadBalancer::Stats stats;
+};
+
+StringBuilder &operator<<(StringBuilder &string_builder, const SessionStatsEntry &entry);
+
 class NetStatsManager final : public Actor {
  public:
   explicit NetStatsManager(ActorShared<> parent) : parent_(std::move(parent)) {
@@ -77,9 +87,15 @@ class NetStatsManager final : public Actor {
 
   void add_network_stats(const NetworkStatsEntry &entry);
 
+  void update_session_stats(string proxy_name, vector<SessionLoadBalancer::Stats> stats);
+
+  void get_session_stats(Promise<vector<SessionStatsEntry>> promise);
+
  private:
   ActorShared<> parent_;
 
+  std::map<string, vector<SessionLoadBalancer::Stats>> session_stats_;
+
   static constexpr size_t net_type_size() {
     return static_cast<size_t>(NetType::Size);
   }
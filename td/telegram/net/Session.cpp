@@ -703,6 +703,9 @@ void Session::on_closed(Status status) {
 
   current_info_->connection_.reset();
   current_info_->state_ = ConnectionInfo::State::Empty;
+  if (current_info_ == &main_connection_) {
+    callback_->on_connection_state_changed(false);
+  }
 }
 
 void Session::on_new_session_created(uint64 unique_id, mtproto::MessageId first_message_id) {
@@ -1307,6 +1310,9 @@ void Session::connection_open_finish(ConnectionInfo *info,
   info->state_ = ConnectionInfo::State::Ready;
   info->created_at_ = Time::now();
   info->wakeup_at_ = info->created_at_ + 10;
+  if (info == &main_connection_) {
+    callback_->on_connection_state_changed(true);
+  }
   if (unknown_queries_.size() > MAX_INFLIGHT_QUERIES) {
     LOG(ERROR) << "With current limits `Too many queries with unknown state` error must be impossible";
     on_session_failed(Status::Error("Too many queries with unknown state"));
@@ -0,0 +1,210 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/SessionLoadBalancer.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/Random.h"
+
+#include <cmath>
+
+namespace td {
+
+static constexpr double QUERY_WEIGHT_UNIT_SIZE = 16384.0;  // a query of 16 KB is twice heavier than an empty query
+static constexpr double DEFAULT_LATENCY = 0.1;             // 0.1s
+static constexpr double LATENCY_DECAY_TIME = 5.0;          // latency peaks are forgotten in several seconds
+static constexpr double MIN_CONNECTION_TIME = 0.1;         // 0.1s
+static constexpr double CONNECTION_LATENCY_FACTOR = 3.0;   // a new connection needs several round trips
+static constexpr double MIN_HEDGE_DELAY = 0.3;             // 0.3s
+static constexpr double HEDGE_LATENCY_FACTOR = 3.0;
+static constexpr double HEDGE_BUDGET_PER_QUERY = 0.05;  // no more than 5% of queries are duplicated
+static constexpr double MAX_HEDGE_BUDGET = 5.0;
+
+constexpr size_t SessionLoadBalancer::NO_SESSION;
+
+SessionLoadBalancer::SessionLoadBalancer(size_t session_count) : sessions_(session_count) {
+  CHECK(session_count > 0);
+}
+
+double SessionLoadBalancer::get_query_weight(size_t query_size) {
+  return 1.0 + static_cast<double>(query_size) / QUERY_WEIGHT_UNIT_SIZE;
+}
+
+double SessionLoadBalancer::get_decay_weight(const Session &session, double now) {
+  return std::exp(-max(now - session.latency_updated_at, 0.0) / LATENCY_DECAY_TIME);
+}
+
+double SessionLoadBalancer::get_latency(const Session &session, double now) const {
+  auto latency = DEFAULT_LATENCY;
+  if (session.latency_updated_at != 0.0) {
+    // the latency decays over time to give the session a chance to be chosen again after a peak
+    latency = session.latency * get_decay_weight(session, now);
+  }
+  if (!session.sent_queries.empty()) {
+    // the oldest unfinished query is waited for already longer than expected, so the session is stalled
+    const auto &oldest_query = *session.sent_queries.begin();
+    auto it = sent_queries_.find(oldest_query.second);
+    CHECK(it != sent_queries_.end());
+    latency = max(latency, (now - oldest_query.first) / it->second.weight);
+  }
+  return latency;
+}
+
+double SessionLoadBalancer::get_expected_time(const Session &session, double query_weight, double now) const {
+  auto latency = get_latency(session, now);
+  auto result = latency * (session.outstanding_weight + query_weight);
+  if (!session.is_connected) {
+    result += max(MIN_CONNECTION_TIME, latency * CONNECTION_LATENCY_FACTOR);
+  }
+  return result;
+}
+
+size_t SessionLoadBalancer::choose_session(size_t query_size, double now, size_t excluded_session_id) const {
+  auto query_weight = get_query_weight(query_size);
+  size_t result = NO_SESSION;
+  double min_expected_time = 0.0;
+  size_t equal_count = 0;
+  for (size_t i = 0; i < sessions_.size(); i++) {
+    if (i == excluded_session_id) {
+      continue;
+    }
+    auto expected_time = get_expected_time(sessions_[i], query_weight, now);
+    if (result == NO_SESSION || expected_time < min_expected_time) {
+      result = i;
+      min_expected_time = expected_time;
+      equal_count = 1;
+    } else if (expected_time == min_expected_time) {
+      equal_count++;
+      if (Random::fast_uint32() % equal_count == 0) {
+        result = i;
+      }
+    }
+  }
+  return result;
+}
+
+void SessionLoadBalancer::on_query_sent(uint64 query_id, uint64 send_generation, size_t session_id, size_t query_size,
+                                        double now) {
+  CHECK(session_id < sessions_.size());
+  auto it = sent_queries_.find(query_id);
+  if (it != sent_queries_.end()) {
+    LOG(INFO) << "Query " << query_id << " is sent before it is finished";
+    on_query_finished(query_id, it->second.send_generation, false, now);
+  }
+
+  SentQuery query;
+  query.send_generation = send_generation;
+  query.session_id = session_id;
+  query.size = query_size;
+  query.weight = get_query_weight(query_size);
+  query.sent_at = now;
+
+  auto &session = sessions_[session_id];
+  session.query_count++;
+  session.outstanding_bytes += query_size;
+  session.outstanding_weight += query.weight;
+  session.sent_queries.emplace(now, query_id);
+  session.sent_query_count++;
+  sent_queries_[query_id] = query;
+
+  hedge_budget_ = min(hedge_budget_ + HEDGE_BUDGET_PER_QUERY, MAX_HEDGE_BUDGET);
+}
+
+size_t SessionLoadBalancer::on_query_finished(uint64 query_id, uint64 send_generation, bool is_ok, double now) {
+  auto it = sent_queries_.find(query_id);
+  if (it == sent_queries_.end() || it->second.send_generation != send_generation) {
+    // the notification about a previous sending of the query can come after the query is sent again
+    return NO_SESSION;
+  }
+  auto query = it->second;
+  sent_queries_.erase(it);
+
+  auto &session = sessions_[query.session_id];
+  CHECK(session.query_count > 0);
+  CHECK(session.outstanding_bytes >= query.size);
+  session.query_count--;
+  session.outstanding_bytes -= query.size;
+  session.outstanding_weight = session.query_count == 0 ? 0.0 : max(session.outstanding_weight - query.weight, 0.0);
+  session.sent_queries.erase({query.sent_at, query_id});
+
+  // failed queries can be returned without waiting for the server, so they can't be used to estimate the latency
+  if (is_ok) {
+    // peaks of the latency are taken into account immediately
+    auto latency = max(now - query.sent_at, 0.0) / query.weight;
+    if (session.latency_updated_at == 0.0 || latency >= session.latency) {
+      session.latency = latency;
+    } else {
+      auto weight = get_decay_weight(session, now);
+      session.latency = session.latency * weight + latency * (1.0 - weight);
+    }
+    session.latency_updated_at = now;
+  }
+  return query.session_id;
+}
+
+size_t SessionLoadBalancer::get_query_session_id(uint64 query_id) const {
+  auto it = sent_queries_.find(query_id);
+  if (it == sent_queries_.end()) {
+    return NO_SESSION;
+  }
+  return it->second.session_id;
+}
+
+void SessionLoadBalancer::on_connection_state_changed(size_t session_id, bool is_connected) {
+  CHECK(session_id < sessions_.size());
+  sessions_[session_id].is_connected = is_connected;
+}
+
+double SessionLoadBalancer::get_hedge_at(uint64 query_id) const {
+  auto it = sent_queries_.find(query_id);
+  if (it == sent_queries_.end()) {
+    return 0.0;
+  }
+  const auto &query = it->second;
+  const auto &session = sessions_[query.session_id];
+  auto latency = session.latency_updated_at == 0.0 ? DEFAULT_LATENCY : session.latency;
+  return query.sent_at + max(MIN_HEDGE_DELAY, latency * query.weight * HEDGE_LATENCY_FACTOR);
+}
+
+bool SessionLoadBalancer::can_hedge() const {
+  return hedge_budget_ >= 1.0;
+}
+
+void SessionLoadBalancer::on_query_hedged(size_t session_id) {
+  CHECK(session_id < sessions_.size());
+  CHECK(can_hedge());
+  hedge_budget_ -= 1.0;
+  sessions_[session_id].hedged_query_count++;
+}
+
+void SessionLoadBalancer::on_hedged_query_won(size_t session_id) {
+  CHECK(session_id < sessions_.size());
+  sessions_[session_id].won_hedged_query_count++;
+}
+
+SessionLoadBalancer::Stats SessionLoadBalancer::get_stats(size_t session_id) const {
+  CHECK(session_id < sessions_.size());
+  const auto &session = sessions_[session_id];
+  Stats stats;
+  stats.query_count = session.query_count;
+  stats.outstanding_bytes = session.outstanding_bytes;
+  stats.latency = session.latency;
+  stats.is_connected = session.is_connected;
+  stats.sent_query_count = session.sent_query_count;
+  stats.hedged_query_count = session.hedged_query_count;
+  stats.won_hedged_query_count = session.won_hedged_query_count;
+  return stats;
+}
+
+StringBuilder &operator<<(StringBuilder &string_builder, const SessionLoadBalancer::Stats &stats) {
+  return string_builder << "[queries:" << stats.query_count << " outstanding:" << stats.outstanding_bytes
+                        << "B latency:" << stats.latency << (stats.is_connected ? " connected" : " disconnected")
+                        << " sent:" << stats.sent_query_count << " hedged:" << stats.hedged_query_count
+                        << " won_hedged:" << stats.won_hedged_query_count << ']';
+}
+
+}  // namespace td
@@ -0,0 +1,108 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/StringBuilder.h"
+
+#include <limits>
+#include <set>
+#include <utility>
+
+namespace td {
+
+// chooses a session for a query by expected time of its completion,
+// which is estimated from latency of previous queries, size of queries sent, but not finished yet,
+// waiting time of the oldest unfinished query and the connection state of the session
+class SessionLoadBalancer {
+ public:
+  struct Stats {
+    int32 query_count = 0;  // number of sent, but not finished queries
+    uint64 outstanding_bytes = 0;
+    double latency = 0.0;  // latency per query weight unit
+    bool is_connected = false;
+    uint64 sent_query_count = 0;
+    uint64 hedged_query_count = 0;      // number of duplicate queries sent to the session
+    uint64 won_hedged_query_count = 0;  // number of duplicate queries, which were answered first
+  };
+
+  static constexpr size_t NO_SESSION = std::numeric_limits<size_t>::max();
+
+  explicit SessionLoadBalancer(size_t session_count);
+
+  size_t get_session_count() const {
+    return sessions_.size();
+  }
+
+  // returns the session with the least expected time of completion of a query with the given size
+  size_t choose_session(size_t query_size, double now, size_t excluded_session_id = NO_SESSION) const;
+
+  // send_generation must be different for each sending of the query; if a query is sent again before it is finished,
+  // then the previous sending is considered failed
+  void on_query_sent(uint64 query_id, uint64 send_generation, size_t session_id, size_t query_size, double now);
+
+  // returns the session to which the query was sent, or NO_SESSION if the query is unknown
+  // or was sent again after the finished sending
+  size_t on_query_finished(uint64 query_id, uint64 send_generation, bool is_ok, double now);
+
+  // returns the session to which the unfinished query was sent, or NO_SESSION if the query is unknown
+  size_t get_query_session_id(uint64 query_id) const;
+
+  void on_connection_state_changed(size_t session_id, bool is_connected);
+
+  // returns time after which a duplicate of a query must be sent through another session
+  // if the query is still unfinished, or 0 if the query is unknown
+  double get_hedge_at(uint64 query_id) const;
+
+  // checks whether a duplicate query can be sent without exceeding the budget of duplicate queries
+  bool can_hedge() const;
+
+  void on_query_hedged(size_t session_id);
+
+  void on_hedged_query_won(size_t session_id);
+
+  Stats get_stats(size_t session_id) const;
+
+ private:
+  struct SentQuery {
+    uint64 send_generation = 0;
+    size_t session_id = 0;
+    size_t size = 0;
+    double weight = 0.0;
+    double sent_at = 0.0;
+  };
+
+  struct Session {
+    int32 query_count = 0;
+    uint64 outstanding_bytes = 0;
+    double outstanding_weight = 0.0;
+    std::set<std::pair<double, uint64>> sent_queries;  // sending time and identifier of unfinished queries
+    double latency = 0.0;
+    double latency_updated_at = 0.0;
+    bool is_connected = false;
+    uint64 sent_query_count = 0;
+    uint64 hedged_query_count = 0;
+    uint64 won_hedged_query_count = 0;
+  };
+
+  vector<Session> sessions_;
+  FlatHashMap<uint64, SentQuery> sent_queries_;
+  double hedge_budget_ = 0.0;
+
+  static double get_query_weight(size_t query_size);
+
+  static double get_decay_weight(const Session &session, double now);
+
+  double get_latency(const Session &session, double now) const;
+
+  double get_expected_time(const Session &session, double query_weight, double now) const;
+};
+
+StringBuilder &operator<<(StringBuilder &string_builder, const SessionLoadBalancer::Stats &stats);
+
+}  // namespace td
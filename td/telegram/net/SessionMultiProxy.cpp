@@ -6,18 +6,25 @@
 //
 #include "td/telegram/net/SessionMultiProxy.h"
 
+#include "td/telegram/Global.h"
+#include "td/telegram/net/NetQueryCreator.h"
+#include "td/telegram/net/NetQueryDispatcher.h"
+#include "td/telegram/net/NetStatsManager.h"
 #include "td/telegram/net/SessionProxy.h"
+#include "td/telegram/telegram_api.h"
 
 #include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
-#include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
 
 namespace td {
 
+static constexpr double STATS_UPDATE_DELAY = 10.0;  // statistics of sessions are updated at most once in 10 seconds
+
 SessionMultiProxy::~SessionMultiProxy() = default;
 
 SessionMultiProxy::SessionMultiProxy(int32 session_count, std::shared_ptr<AuthDataShared> shared_auth_data,
@@ -42,26 +49,217 @@ void SessionMultiProxy::send(NetQueryPtr query) {
     size_t session_rand = query->session_rand();
     if (session_rand) {
       pos = session_rand % sessions_.size();
+    } else if (copy_ids_.count(query->id()) == 0 && !query->update_is_ready() && can_hedge(*query)) {
+      // keep the query and send its copy instead, so that another copy can be sent if the session stalls
+      auto query_id = query->id();
+      if (!query->cancel_slot_.empty()) {
+        // cancellation of the query must be propagated to its copies immediately
+        query->cancel_slot_.set_event(EventCreator::raw(actor_id(this), query_id));
+      }
+      auto hedged_query = make_unique<HedgedQuery>();
+      hedged_query->query = std::move(query);
+      auto session_id = load_balancer_->choose_session(hedged_query->query->query().size(), Time::now());
+      send_copy(*hedged_query, session_id);
+      CHECK(hedged_queries_.count(query_id) == 0);
+      hedged_queries_.emplace(query_id, std::move(hedged_query));
+      update_timeout();
+      return;
+    } else {
+      pos = load_balancer_->choose_session(query->query().size(), Time::now());
+    }
+  }
+  send_to_session(pos, std::move(query));
+  if (!hedged_queries_.empty()) {
+    update_timeout();
+  }
+}
+
+void SessionMultiProxy::send_to_session(size_t session_id, NetQueryPtr query) {
+  // query->debug(PSTRING() << get_name() << ": send to proxy #" << session_id);
+  query->send_generation_ = ++last_send_generation_;
+  load_balancer_->on_query_sent(query->id(), query->send_generation_, session_id, query->query().size(), Time::now());
+  on_stats_changed();
+  send_closure(sessions_[session_id].proxy, &SessionProxy::send, std::move(query));
+}
+
+bool SessionMultiProxy::can_hedge(const NetQuery &query) const {
+  if (sessions_.size() <= 1 || !query.invoke_after().empty()) {
+    return false;
+  }
+  // file parts are downloaded by idempotent queries, so their copies can be sent through different sessions
+  switch (query.tl_constructor()) {
+    case telegram_api::upload_getFile::ID:
+    case telegram_api::upload_getCdnFile::ID:
+    case telegram_api::upload_getWebFile::ID:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void SessionMultiProxy::send_copy(HedgedQuery &hedged_query, size_t session_id) {
+  auto copy = G()->net_query_creator().create_copy(hedged_query.query);
+  copy->set_callback(actor_shared(this, hedged_query.query->id()));
+  HedgedQuery::Copy copy_info;
+  copy_info.id = copy->id();
+  copy_info.ref = copy.get_weak();
+  copy_info.cancel_signal = copy->cancel_slot_.get_signal_new();
+  copy_info.session_id = session_id;
+  hedged_query.copies.push_back(std::move(copy_info));
+  copy_ids_.insert(copy->id());
+  send_to_session(session_id, std::move(copy));
+}
+
+void SessionMultiProxy::on_result(NetQueryPtr query) {
+  auto copy_id = query->id();
+  CHECK(copy_ids_.count(copy_id) != 0);
+  copy_ids_.erase(copy_id);
+
+  auto it = hedged_queries_.find(get_link_token());
+  if (it == hedged_queries_.end()) {
+    // the query has already been answered by another copy
+    query->clear();
+    return;
+  }
+  if (query->is_error() && !it->second->query->update_is_ready()) {
+    for (auto &copy : it->second->copies) {
+      if (copy_ids_.count(copy.id) != 0) {
+        // another copy of the query can still succeed
+        LOG(INFO) << "Ignore error " << query->error() << " of a copy of query " << it->first;
+        query->clear();
+        return;
+      }
+    }
+  }
+
+  auto hedged_query = std::move(it->second);
+  hedged_queries_.erase(it);
+
+  auto &original_query = hedged_query->query;
+  if (hedged_query->is_hedged && hedged_query->copies.back().id == copy_id) {
+    auto session_id = hedged_query->copies.back().session_id;
+    if (session_id < load_balancer_->get_session_count()) {
+      load_balancer_->on_hedged_query_won(session_id);
+    }
+  }
+  if (!original_query->update_is_ready()) {
+    if (query->is_ok()) {
+      original_query->set_ok(query->move_as_ok());
     } else {
-      size_t equal_count = 1;
-      int min_query_count = sessions_[pos].query_count;
-      for (size_t i = 1; i < sessions_.size(); i++) {
-        if (sessions_[i].query_count < min_query_count) {
-          pos = i;
-          min_query_count = sessions_[pos].query_count;
-          equal_count = 1;
-        } else if (sessions_[i].query_count == min_query_count) {
-          equal_count++;
-          if (Random::fast_uint32() % equal_count == 0) {
-            pos = i;
-          }
-        }
+      original_query->set_error(query->move_as_error());
+    }
+  }
+  query->clear();
+  finish_hedged_query(std::move(hedged_query));
+  update_timeout();
+}
+
+void SessionMultiProxy::raw_event(const Event::Raw &event) {
+  auto query_id = event.u64;
+  auto it = hedged_queries_.find(query_id);
+  if (it == hedged_queries_.end() || !it->second->query->update_is_ready()) {
+    return;
+  }
+
+  // the query was canceled
+  auto hedged_query = std::move(it->second);
+  hedged_queries_.erase(it);
+  finish_hedged_query(std::move(hedged_query));
+  update_timeout();
+}
+
+void SessionMultiProxy::finish_hedged_query(unique_ptr<HedgedQuery> hedged_query) {
+  for (auto &copy : hedged_query->copies) {
+    cancel_query(copy.ref);
+    // the session drops the copy immediately after the signal is dropped
+    copy.cancel_signal.reset();
+  }
+  hedged_query->query->cancel_slot_.clear_event();
+  G()->net_query_dispatcher().dispatch(std::move(hedged_query->query));
+}
+
+void SessionMultiProxy::timeout_expired() {
+  auto now = Time::now();
+  if (stats_update_at_ != 0.0 && stats_update_at_ <= now) {
+    update_stats();
+  }
+
+  vector<uint64> canceled_query_ids;
+  for (auto &it : hedged_queries_) {
+    auto &hedged_query = *it.second;
+    if (hedged_query.query->update_is_ready()) {
+      canceled_query_ids.push_back(it.first);
+      continue;
+    }
+    if (hedged_query.is_hedged || !load_balancer_->can_hedge()) {
+      continue;
+    }
+    const auto &first_copy = hedged_query.copies[0];
+    auto hedge_at = load_balancer_->get_hedge_at(first_copy.id);
+    if (hedge_at == 0.0 || hedge_at > now) {
+      continue;
+    }
+
+    // the query is waited for too long, so send its copy through another session
+    hedged_query.is_hedged = true;
+    auto session_id = load_balancer_->choose_session(hedged_query.query->query().size(), now,
+                                                     load_balancer_->get_query_session_id(first_copy.id));
+    if (session_id == SessionLoadBalancer::NO_SESSION) {
+      continue;
+    }
+    LOG(INFO) << "Send a copy of query " << it.first << " to session " << session_id;
+    load_balancer_->on_query_hedged(session_id);
+    send_copy(hedged_query, session_id);
+  }
+  for (auto query_id : canceled_query_ids) {
+    auto it = hedged_queries_.find(query_id);
+    CHECK(it != hedged_queries_.end());
+    auto hedged_query = std::move(it->second);
+    hedged_queries_.erase(it);
+    finish_hedged_query(std::move(hedged_query));
+  }
+
+  update_timeout();
+}
+
+void SessionMultiProxy::update_timeout() {
+  auto timeout_at = stats_update_at_;
+  if (load_balancer_->can_hedge()) {
+    for (auto &it : hedged_queries_) {
+      if (it.second->is_hedged) {
+        continue;
+      }
+      auto hedge_at = load_balancer_->get_hedge_at(it.second->copies[0].id);
+      if (hedge_at != 0.0 && (timeout_at == 0.0 || hedge_at < timeout_at)) {
+        timeout_at = hedge_at;
       }
     }
   }
-  // query->debug(PSTRING() << get_name() << ": send to proxy #" << pos);
-  sessions_[pos].query_count++;
-  send_closure(sessions_[pos].proxy, &SessionProxy::send, std::move(query));
+  if (timeout_at == 0.0) {
+    cancel_timeout();
+  } else {
+    set_timeout_at(timeout_at);
+  }
+}
+
+void SessionMultiProxy::on_stats_changed() {
+  if (stats_update_at_ == 0.0) {
+    stats_update_at_ = Time::now() + STATS_UPDATE_DELAY;
+    update_timeout();
+  }
+}
+
+void SessionMultiProxy::update_stats() {
+  stats_update_at_ = 0.0;
+  vector<SessionLoadBalancer::Stats> stats;
+  for (size_t i = 0; i < sessions_.size(); i++) {
+    stats.push_back(load_balancer_->get_stats(i));
+  }
+  LOG(DEBUG) << "Sessions: " << stats;
+  auto net_stats_manager = G()->net_stats_manager();
+  if (!net_stats_manager.empty()) {
+    send_closure(net_stats_manager, &NetStatsManager::update_session_stats, get_name().str(), std::move(stats));
+  }
 }
 
 void SessionMultiProxy::update_main_flag(bool is_main) {
@@ -129,6 +327,13 @@ void SessionMultiProxy::start_up() {
   init();
 }
 
+void SessionMultiProxy::tear_down() {
+  for (auto &it : hedged_queries_) {
+    finish_hedged_query(std::move(it.second));
+  }
+  hedged_queries_.clear();
+}
+
 bool SessionMultiProxy::get_pfs_flag() const {
   return use_pfs_ && !is_cdn_;
 }
@@ -136,6 +341,7 @@ bool SessionMultiProxy::get_pfs_flag() const {
 void SessionMultiProxy::init() {
   sessions_generation_++;
   sessions_.clear();
+  load_balancer_ = make_unique<SessionLoadBalancer>(static_cast<size_t>(session_count_));
   if (is_main_ && session_count_ > 1) {
     LOG(WARNING) << tag("session_count", session_count_);
   }
@@ -149,8 +355,12 @@ void SessionMultiProxy::init() {
       Callback(ActorId<SessionMultiProxy> parent, uint32 generation, int32 session_id)
           : parent_(parent), generation_(generation), session_id_(session_id) {
       }
-      void on_query_finished() final {
-        send_closure(parent_, &SessionMultiProxy::on_query_finished, generation_, session_id_);
+      void on_query_finished(uint64 query_id, uint64 send_generation, bool is_ok) final {
+        send_closure(parent_, &SessionMultiProxy::on_query_finished, generation_, query_id, send_generation, is_ok);
+      }
+      void on_connection_state_changed(bool is_connected) final {
+        send_closure(parent_, &SessionMultiProxy::on_connection_state_changed, generation_, session_id_,
+                     is_connected);
       }
 
      private:
@@ -164,16 +374,23 @@ void SessionMultiProxy::init() {
                                    session_count_ > 1 && is_primary_, is_cdn_, need_destroy_auth_key_ && i == 0);
     sessions_.push_back(std::move(info));
   }
+  on_stats_changed();
+}
+
+void SessionMultiProxy::on_query_finished(uint32 generation, uint64 query_id, uint64 send_generation, bool is_ok) {
+  if (generation != sessions_generation_) {
+    return;
+  }
+  load_balancer_->on_query_finished(query_id, send_generation, is_ok, Time::now());
+  on_stats_changed();
 }
 
-void SessionMultiProxy::on_query_finished(uint32 generation, int session_id) {
+void SessionMultiProxy::on_connection_state_changed(uint32 generation, int32 session_id, bool is_connected) {
   if (generation != sessions_generation_) {
     return;
   }
-  CHECK(static_cast<size_t>(session_id) < sessions_.size());
-  auto &query_count = sessions_[session_id].query_count;
-  CHECK(query_count > 0);
-  query_count--;
+  load_balancer_->on_connection_state_changed(static_cast<size_t>(session_id), is_connected);
+  on_stats_changed();
 }
 
 }  // namespace td
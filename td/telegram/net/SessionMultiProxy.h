@@ -8,16 +8,21 @@
 
 #include "td/telegram/net/AuthDataShared.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/SessionLoadBalancer.h"
 
 #include "td/actor/actor.h"
 
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/FlatHashSet.h"
+
 #include <memory>
 
 namespace td {
 
 class SessionProxy;
 
-class SessionMultiProxy final : public Actor {
+class SessionMultiProxy final : public NetQueryCallback {
  public:
   SessionMultiProxy(int32 session_count, std::shared_ptr<AuthDataShared> shared_auth_data, bool is_primary,
                     bool is_main, bool use_pfs, bool allow_media_only, bool is_media, bool is_cdn);
@@ -47,17 +52,59 @@ class SessionMultiProxy final : public Actor {
   bool need_destroy_auth_key_ = false;
   struct SessionInfo {
     ActorOwn<SessionProxy> proxy;
-    int query_count{0};
   };
   uint32 sessions_generation_{0};
   std::vector<SessionInfo> sessions_;
+  unique_ptr<SessionLoadBalancer> load_balancer_;
+
+  // an idempotent query, copies of which are sent instead of it through one or two sessions,
+  // so that the query can be answered by the first finished copy
+  struct HedgedQuery {
+    struct Copy {
+      uint64 id = 0;
+      NetQueryRef ref;
+      ActorShared<> cancel_signal;
+      size_t session_id = 0;
+    };
+    NetQueryPtr query;
+    vector<Copy> copies;
+    bool is_hedged = false;
+  };
+  FlatHashMap<uint64, unique_ptr<HedgedQuery>> hedged_queries_;
+  FlatHashSet<uint64> copy_ids_;
+
+  uint64 last_send_generation_ = 0;
+
+  double stats_update_at_ = 0.0;
 
   void start_up() final;
+  void tear_down() final;
+  void timeout_expired() final;
   void init();
 
   bool get_pfs_flag() const;
 
-  void on_query_finished(uint32 generation, int session_id);
+  bool can_hedge(const NetQuery &query) const;
+
+  void send_to_session(size_t session_id, NetQueryPtr query);
+
+  void send_copy(HedgedQuery &hedged_query, size_t session_id);
+
+  void on_result(NetQueryPtr query) final;
+
+  void raw_event(const Event::Raw &event) final;
+
+  void finish_hedged_query(unique_ptr<HedgedQuery> hedged_query);
+
+  void on_query_finished(uint32 generation, uint64 query_id, uint64 send_generation, bool is_ok);
+
+  void on_connection_state_changed(uint32 generation, int32 session_id, bool is_connected);
+
+  void on_stats_changed();
+
+  void update_timeout();
+
+  void update_stats();
 };
 
 }  // namespace td
@@ -51,6 +51,9 @@ class SessionCallback final : public Session::Callback {
   void on_closed() final {
     send_closure(parent_, &SessionProxy::on_closed);
   }
+  void on_connection_state_changed(bool is_connected) final {
+    send_closure(parent_, &SessionProxy::on_connection_state_changed, is_connected);
+  }
   void request_raw_connection(unique_ptr<mtproto::AuthData> auth_data,
                               Promise<unique_ptr<mtproto::RawConnection>> promise) final {
     send_closure(G()->connection_creator(), &ConnectionCreator::request_raw_connection, dc_id_, allow_media_only_,
@@ -78,7 +81,7 @@ class SessionCallback final : public Session::Callback {
 
   void on_result(NetQueryPtr query) final {
     if (UniqueId::extract_type(query->id()) != UniqueId::BindKey) {
-      send_closure(parent_, &SessionProxy::on_query_finished);
+      send_closure(parent_, &SessionProxy::on_query_finished, query->id(), query->send_generation_, query->is_ok());
     }
     G()->net_query_dispatcher().dispatch(std::move(query));
   }
@@ -145,7 +148,7 @@ void SessionProxy::start_up() {
 void SessionProxy::tear_down() {
   for (auto &query : pending_queries_) {
     query->resend();
-    callback_->on_query_finished();
+    callback_->on_query_finished(query->id(), query->send_generation_, false);
     G()->net_query_dispatcher().dispatch(std::move(query));
   }
   pending_queries_.clear();
@@ -188,8 +191,18 @@ void SessionProxy::update_mtproto_header() {
 void SessionProxy::on_closed() {
 }
 
+void SessionProxy::on_connection_state_changed(bool is_connected) {
+  if (session_generation_ != get_link_token()) {
+    return;
+  }
+  callback_->on_connection_state_changed(is_connected);
+}
+
 void SessionProxy::close_session(const char *source) {
   LOG(INFO) << "Close session from " << source;
+  if (!session_.empty()) {
+    callback_->on_connection_state_changed(false);
+  }
   send_closure(std::move(session_), &Session::close);
   session_generation_++;
 }
@@ -274,8 +287,8 @@ void SessionProxy::on_server_salt_updated(std::vector<mtproto::ServerSalt> serve
   server_salts_ = std::move(server_salts);
 }
 
-void SessionProxy::on_query_finished() {
-  callback_->on_query_finished();
+void SessionProxy::on_query_finished(uint64 query_id, uint64 send_generation, bool is_ok) {
+  callback_->on_query_finished(query_id, send_generation, is_ok);
 }
 
 }  // namespace td
@@ -29,7 +29,8 @@ class SessionProxy final : public Actor {
   class Callback {
    public:
     virtual ~Callback() = default;
-    virtual void on_query_finished() = 0;
+    virtual void on_query_finished(uint64 query_id, uint64 send_generation, bool is_ok) = 0;
+    virtual void on_connection_state_changed(bool is_connected) = 0;
   };
 
   SessionProxy(unique_ptr<Callback> callback, std::shared_ptr<AuthDataShared> shared_auth_data, bool is_primary,
@@ -69,7 +70,9 @@ class SessionProxy final : public Actor {
   void on_tmp_auth_key_updated(mtproto::AuthKey auth_key);
   void on_server_salt_updated(std::vector<mtproto::ServerSalt> server_salts);
 
-  void on_query_finished();
+  void on_connection_state_changed(bool is_connected);
+
+  void on_query_finished(uint64 query_id, uint64 send_generation, bool is_ok);
 
   string tmp_auth_key_key() const;
 
@@ -0,0 +1,89 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/WarmConnectionPool.h"
+
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+
+#include <cmath>
+
+namespace td {
+
+constexpr double WarmConnectionPool::DEMAND_DECAY_TIME;
+constexpr double WarmConnectionPool::HEALTH_CHECK_PERIOD;
+
+StringBuilder &operator<<(StringBuilder &string_builder, const ConnectionPoolStats &stats) {
+  return string_builder << "[created:" << stats.created_connection_count
+                        << " preconnected:" << stats.preconnected_connection_count
+                        << " returned:" << stats.returned_connection_count << " warm:" << stats.warm_connection_count
+                        << " handshake_time:" << format::as_time(stats.handshake_time)
+                        << " saved_handshake_time:" << format::as_time(stats.saved_handshake_time)
+                        << " health_checks:" << stats.health_check_count
+                        << " failed_health_checks:" << stats.failed_health_check_count << ']';
+}
+
+double WarmConnectionPool::get_demand(double now) const {
+  return demand_ * std::exp(-max(now - demand_updated_at_, 0.0) / DEMAND_DECAY_TIME);
+}
+
+void WarmConnectionPool::on_request(double now) {
+  demand_ = get_demand(now) + 1.0;
+  demand_updated_at_ = now;
+}
+
+size_t WarmConnectionPool::get_warm_connection_count(double now, size_t max_count) const {
+  // keep a connection warm for each request expected soon, so a single request keeps a connection for 40 seconds
+  return min(max_count, static_cast<size_t>(get_demand(now) + 0.5));
+}
+
+bool WarmConnectionPool::can_drop_expired_connection(size_t ready_connection_count,
+                                                     size_t warm_connection_count) const {
+  return ready_connection_count + health_checking_connection_count_ > warm_connection_count;
+}
+
+size_t WarmConnectionPool::get_preconnect_count(size_t ready_connection_count, size_t warm_connection_count) const {
+  auto spare_connection_count = ready_connection_count + health_checking_connection_count_;
+  return warm_connection_count > spare_connection_count ? warm_connection_count - spare_connection_count : 0;
+}
+
+bool WarmConnectionPool::need_health_check(double checked_at, double now) const {
+  return checked_at < now - HEALTH_CHECK_PERIOD;
+}
+
+void WarmConnectionPool::on_health_check_started() {
+  health_checking_connection_count_++;
+  stats_.health_check_count++;
+}
+
+bool WarmConnectionPool::on_health_check_finished(bool is_alive) {
+  CHECK(health_checking_connection_count_ > 0);
+  health_checking_connection_count_--;
+  if (!is_alive) {
+    stats_.failed_health_check_count++;
+  }
+  return is_alive;
+}
+
+void WarmConnectionPool::on_connection_created(double handshake_time) {
+  stats_.created_connection_count++;
+  stats_.handshake_time += handshake_time;
+}
+
+void WarmConnectionPool::on_connection_preconnected() {
+  stats_.preconnected_connection_count++;
+}
+
+void WarmConnectionPool::on_connection_returned(bool is_warm, double handshake_time, double wait_time) {
+  stats_.returned_connection_count++;
+  if (is_warm) {
+    stats_.warm_connection_count++;
+  }
+  stats_.saved_handshake_time += max(handshake_time - wait_time, 0.0);
+}
+
+}  // namespace td
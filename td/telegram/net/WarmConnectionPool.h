@@ -0,0 +1,76 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/StringBuilder.h"
+
+namespace td {
+
+struct ConnectionPoolStats {
+  uint64 created_connection_count = 0;       // number of successfully created connections
+  uint64 preconnected_connection_count = 0;  // number of connections created in advance without a request
+  uint64 returned_connection_count = 0;      // number of connections returned to requesters
+  uint64 warm_connection_count = 0;          // number of connections, which were ready before the request
+  double handshake_time = 0.0;               // total time spent on connection establishment
+  double saved_handshake_time = 0.0;         // total time of connection establishment, which wasn't waited for
+  uint64 health_check_count = 0;
+  uint64 failed_health_check_count = 0;
+};
+
+StringBuilder &operator<<(StringBuilder &string_builder, const ConnectionPoolStats &stats);
+
+// decides how many ready connections of a ConnectionCreator client are kept warm
+// a client is created for each session, so the limit on the number of warm connections applies per session
+class WarmConnectionPool {
+ public:
+  static constexpr double DEMAND_DECAY_TIME = 60;
+  static constexpr double HEALTH_CHECK_PERIOD = 20;
+
+  void on_request(double now);
+
+  size_t get_warm_connection_count(double now, size_t max_count) const;
+
+  // returns whether an expired ready connection can be dropped, if ready_connection_count ready connections are left
+  bool can_drop_expired_connection(size_t ready_connection_count, size_t warm_connection_count) const;
+
+  size_t get_preconnect_count(size_t ready_connection_count, size_t warm_connection_count) const;
+
+  bool need_health_check(double checked_at, double now) const;
+
+  void on_health_check_started();
+
+  // returns whether the connection must be kept
+  bool on_health_check_finished(bool is_alive);
+
+  size_t get_health_checking_connection_count() const {
+    return health_checking_connection_count_;
+  }
+
+  void on_connection_created(double handshake_time);
+
+  void on_connection_preconnected();
+
+  void on_connection_returned(bool is_warm, double handshake_time, double wait_time);
+
+  const ConnectionPoolStats &get_stats() const {
+    return stats_;
+  }
+
+ private:
+  // exponentially decaying number of recent requests
+  double demand_ = 0.0;
+  double demand_updated_at_ = 0.0;
+
+  size_t health_checking_connection_count_ = 0;
+
+  ConnectionPoolStats stats_;
+
+  double get_demand(double now) const;
+};
+
+}  // namespace td
@@ -0,0 +1,50 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/td_binary_client.h"
+
+#include "td/telegram/ClientBinary.h"
+
+#include "td/utils/Slice.h"
+
+static td::Slice to_slice(const void *data, size_t length) {
+  if (data == nullptr) {
+    return td::Slice();
+  }
+  return td::Slice(static_cast<const char *>(data), length);
+}
+
+int td_binary_create_client_id() {
+  return td::binary_create_client_id();
+}
+
+void td_binary_send(int client_id, unsigned long long request_id, const void *request, size_t request_length) {
+  td::binary_send(client_id, request_id, to_slice(request, request_length));
+}
+
+const void *td_binary_receive(double timeout, int *client_id, unsigned long long *request_id, size_t *length) {
+  int response_client_id = 0;
+  td::uint64 response_request_id = 0;
+  auto result = td::binary_receive(timeout, response_client_id, response_request_id);
+  if (client_id != nullptr) {
+    *client_id = response_client_id;
+  }
+  if (request_id != nullptr) {
+    *request_id = response_request_id;
+  }
+  if (length != nullptr) {
+    *length = result.size();
+  }
+  return result.empty() ? nullptr : result.data();
+}
+
+const void *td_binary_execute(const void *request, size_t request_length, size_t *length) {
+  auto result = td::binary_execute(to_slice(request, request_length));
+  if (length != nullptr) {
+    *length = result.size();
+  }
+  return result.data();
+}
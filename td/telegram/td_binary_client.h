@@ -0,0 +1,87 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+/**
+ * \file
+ * C interface for interaction with TDLib via TL-serialized objects.
+ * Can be used to integrate TDLib with any programming language which supports calling C functions without the overhead
+ * of JSON serialization.
+ *
+ * Requests and returned objects are serialized as boxed TL objects: the 32-bit identifier of the object constructor
+ * followed by fields of the object in the order they are declared in td_api.tl. Fields of Bool type are stored as
+ * boxed boolTrue or boolFalse, fields of int32 and int53 types are stored as 32-bit and 64-bit little-endian integers
+ * respectively, fields of int64 and double types are stored as 64-bit values, fields of string and bytes types are
+ * stored as TL strings, fields of array type are stored as bare TL vectors, i.e. the 32-bit number of elements
+ * followed by the elements without the vector constructor identifier 0x1cb5c415, and fields of object types, including
+ * elements of arrays of objects, are stored as boxed objects. Null objects are stored as the 0 constructor identifier.
+ *
+ * The interface is independent of the JSON interface and has its own TDLib client instances. A client instance can be
+ * created through td_binary_create_client_id. Requests can be sent using td_binary_send with a non-zero request
+ * identifier, which will be returned with the response. New updates and responses to requests can be received through
+ * td_binary_receive, which must not be called simultaneously from two different threads. All updates and responses to
+ * requests must be applied in the order they were received for consistency. Some TDLib requests can be executed
+ * synchronously from any thread using td_binary_execute.
+ */
+
+#include "td/telegram/tdjson_export.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Returns an opaque identifier of a new TDLib instance for the binary interface.
+ * The TDLib instance will not send updates until the first request is sent to it.
+ * \return Opaque identifier of a new TDLib instance.
+ */
+TDJSON_EXPORT int td_binary_create_client_id();
+
+/**
+ * Sends request to the TDLib client. May be called from any thread.
+ * \param[in] client_id TDLib client identifier.
+ * \param[in] request_id Non-zero identifier of the request, which will be returned with the response.
+ * \param[in] request TL-serialized request to TDLib. The pointer doesn't need to be aligned, but requests aligned to
+ *                    4 bytes are parsed without copying.
+ * \param[in] request_length Length of the request in bytes.
+ */
+TDJSON_EXPORT void td_binary_send(int client_id, unsigned long long request_id, const void *request,
+                                  size_t request_length);
+
+/**
+ * Receives incoming updates and request responses. Must not be called simultaneously from two different threads.
+ * The returned pointer can be used until the next call to td_binary_receive or td_binary_execute, after which it will
+ * be deallocated by TDLib.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \param[out] client_id Pointer to a variable, which will receive identifier of the client for which a response or
+ *                       an update was received.
+ * \param[out] request_id Pointer to a variable, which will receive identifier of the request to which the response
+ *                        corresponds, or 0 for incoming updates.
+ * \param[out] length Pointer to a variable, which will receive length of the returned object in bytes.
+ * \return TL-serialized incoming update or request response. May be NULL if the timeout expires.
+ */
+TDJSON_EXPORT const void *td_binary_receive(double timeout, int *client_id, unsigned long long *request_id,
+                                            size_t *length);
+
+/**
+ * Synchronously executes a TDLib request.
+ * A request can be executed synchronously, only if it is documented with "Can be called synchronously".
+ * The returned pointer can be used until the next call to td_binary_receive or td_binary_execute, after which it will
+ * be deallocated by TDLib.
+ * \param[in] request TL-serialized request to TDLib. The pointer doesn't need to be aligned, but requests aligned to
+ *                    4 bytes are parsed without copying.
+ * \param[in] request_length Length of the request in bytes.
+ * \param[out] length Pointer to a variable, which will receive length of the returned object in bytes.
+ * \return TL-serialized request response.
+ */
+TDJSON_EXPORT const void *td_binary_execute(const void *request, size_t request_length, size_t *length);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
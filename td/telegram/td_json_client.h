@@ -50,6 +50,8 @@
 
 #include "td/telegram/tdjson_export.h"
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -76,6 +78,30 @@ TDJSON_EXPORT void td_send(int client_id, const char *request);
  */
 TDJSON_EXPORT const char *td_receive(double timeout);
 
+/**
+ * Receives incoming updates and request responses together with the length of their JSON representation.
+ * Works exactly like td_receive, but allows to avoid scanning the result for the terminating null character.
+ * The returned pointer can be used until the next call to td_receive or td_execute, after which it will be deallocated by TDLib.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \param[out] length Pointer to a variable, which will receive the length of the result without the terminating null
+ *                    character. Will be set to 0 if the timeout expires. May be NULL.
+ * \return JSON-serialized null-terminated incoming update or request response. May be NULL if the timeout expires.
+ */
+TDJSON_EXPORT const char *td_receive_with_length(double timeout, size_t *length);
+
+/**
+ * Receives all available incoming updates and request responses at once, but no more than max_count of them.
+ * Waits for new data only if there are no available updates and responses. Must not be called simultaneously from two
+ * different threads, including simultaneous calls with td_receive. Is much faster than td_receive if there are many updates.
+ * The returned pointer can be used until the next call to td_receive or td_execute, after which it will be deallocated by TDLib.
+ * \param[in] max_count The maximum number of returned updates and request responses. Must be positive.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \return JSON-serialized null-terminated array of incoming updates and request responses in the order they were
+ *         received. May be NULL if the timeout expires, but can also be NULL before the timeout expires, for example,
+ *         if only internal responses were received.
+ */
+TDJSON_EXPORT const char *td_receive_batch(int max_count, double timeout);
+
 /**
  * Synchronously executes a TDLib request.
  * A request can be executed synchronously, only if it is documented with "Can be called synchronously".
@@ -127,6 +127,20 @@ class TlFetchVector {
   }
 };
 
+// parses a boxed object, which is replaced with constructor identifier 0 if it is null
+template <class Func>
+class TlFetchNullable {
+ public:
+  template <class ParserT>
+  static auto parse(ParserT &parser) -> decltype(Func::parse(parser)) {
+    if (parser.can_prefetch_int() && parser.prefetch_int_unsafe() == 0) {
+      parser.fetch_int();
+      return decltype(Func::parse(parser))();
+    }
+    return Func::parse(parser);
+  }
+};
+
 template <class T>
 class TlFetchObject {
  public:
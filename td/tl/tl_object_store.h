@@ -36,6 +36,22 @@ class TlStoreBoxedUnknown {
   }
 };
 
+// stores a boxed object or constructor identifier 0 if the object is null
+template <class Func>
+class TlStoreNullableBoxedUnknown {
+ public:
+  template <class T, class StorerT>
+  static void store(const T &x, StorerT &storer) {
+    const TlObject *object = x.get();  // get_id can be private in the object class
+    if (object == nullptr) {
+      storer.store_binary(static_cast<std::int32_t>(0));
+      return;
+    }
+    storer.store_binary(object->get_id());
+    Func::store(x, storer);
+  }
+};
+
 class TlStoreBool {
  public:
   template <class StorerT>
@@ -0,0 +1,146 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/actor/ActorStatistics.h"
+
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/port/Clocks.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace td {
+
+std::atomic<bool> ActorStatistics::is_enabled_{false};
+
+namespace {
+
+struct ActorStatisticsStorage {
+  std::mutex mutex;
+  int32 since_date = 0;
+  FlatHashMap<string, unique_ptr<ActorStatistics::Record>> records;
+};
+
+ActorStatisticsStorage &get_storage() {
+  static ActorStatisticsStorage storage;
+  return storage;
+}
+
+uint64 to_nanoseconds(double seconds) {
+  if (seconds <= 0) {
+    return 0;
+  }
+  return static_cast<uint64>(seconds * 1e9);
+}
+
+double to_seconds(uint64 nanoseconds) {
+  return static_cast<double>(nanoseconds) * 1e-9;
+}
+
+void update_max(std::atomic<uint64> &max_value, uint64 value) {
+  auto old_value = max_value.load(std::memory_order_relaxed);
+  while (old_value < value && !max_value.compare_exchange_weak(old_value, value, std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+void ActorStatistics::Record::on_event(double duration, double wait_time) {
+  event_count_.fetch_add(1, std::memory_order_relaxed);
+  auto duration_ns = to_nanoseconds(duration);
+  total_duration_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+  update_max(max_duration_ns_, duration_ns);
+  if (wait_time >= 0) {
+    auto wait_time_ns = to_nanoseconds(wait_time);
+    waited_event_count_.fetch_add(1, std::memory_order_relaxed);
+    total_wait_time_ns_.fetch_add(wait_time_ns, std::memory_order_relaxed);
+    update_max(max_wait_time_ns_, wait_time_ns);
+  }
+}
+
+void ActorStatistics::Record::on_mailbox_size(size_t mailbox_size) {
+  update_max(max_mailbox_size_, static_cast<uint64>(mailbox_size));
+}
+
+void ActorStatistics::Record::reset() {
+  event_count_ = 0;
+  total_duration_ns_ = 0;
+  max_duration_ns_ = 0;
+  waited_event_count_ = 0;
+  total_wait_time_ns_ = 0;
+  max_wait_time_ns_ = 0;
+  max_mailbox_size_ = 0;
+}
+
+void ActorStatistics::set_enabled(bool is_enabled) {
+  auto &storage = get_storage();
+  std::lock_guard<std::mutex> lock(storage.mutex);
+  if (is_enabled == is_enabled_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (is_enabled) {
+    // records can't be deleted, because they are referenced by actors
+    for (auto &it : storage.records) {
+      it.second->reset();
+    }
+    storage.since_date = static_cast<int32>(Clocks::system());
+  } else {
+    storage.since_date = 0;
+  }
+  is_enabled_.store(is_enabled, std::memory_order_relaxed);
+}
+
+int32 ActorStatistics::get_since_date() {
+  auto &storage = get_storage();
+  std::lock_guard<std::mutex> lock(storage.mutex);
+  return storage.since_date;
+}
+
+ActorStatistics::Record *ActorStatistics::get_record(Slice name) {
+  if (name.empty()) {
+    // actors can be created with an empty name
+    name = Slice("Unknown");
+  }
+  auto &storage = get_storage();
+  std::lock_guard<std::mutex> lock(storage.mutex);
+  auto &record = storage.records[name.str()];
+  if (record == nullptr) {
+    record = make_unique<Record>();
+  }
+  return record.get();
+}
+
+vector<ActorStatistics::Entry> ActorStatistics::get_entries() {
+  vector<Entry> result;
+  {
+    auto &storage = get_storage();
+    std::lock_guard<std::mutex> lock(storage.mutex);
+    for (auto &it : storage.records) {
+      const auto &record = *it.second;
+      Entry entry;
+      entry.name = it.first;
+      entry.event_count = record.event_count_.load(std::memory_order_relaxed);
+      if (entry.event_count == 0) {
+        continue;
+      }
+      entry.total_duration = to_seconds(record.total_duration_ns_.load(std::memory_order_relaxed));
+      entry.max_duration = to_seconds(record.max_duration_ns_.load(std::memory_order_relaxed));
+      auto waited_event_count = record.waited_event_count_.load(std::memory_order_relaxed);
+      if (waited_event_count != 0) {
+        entry.average_wait_time = to_seconds(record.total_wait_time_ns_.load(std::memory_order_relaxed)) /
+                                  static_cast<double>(waited_event_count);
+      }
+      entry.max_wait_time = to_seconds(record.max_wait_time_ns_.load(std::memory_order_relaxed));
+      entry.max_mailbox_size = record.max_mailbox_size_.load(std::memory_order_relaxed);
+      result.push_back(std::move(entry));
+    }
+  }
+  std::sort(result.begin(), result.end(),
+            [](const Entry &lhs, const Entry &rhs) { return lhs.total_duration > rhs.total_duration; });
+  return result;
+}
+
+}  // namespace td
@@ -0,0 +1,70 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+#include <atomic>
+
+namespace td {
+
+// Process-wide statistics about events processed by actors, aggregated by actor name.
+// Collection is disabled by default; while it is disabled, schedulers check only one atomic flag per event.
+class ActorStatistics {
+ public:
+  // accumulated statistics for all actors with the same name; can be updated concurrently from different schedulers
+  class Record {
+   public:
+    void on_event(double duration, double wait_time);
+
+    void on_mailbox_size(size_t mailbox_size);
+
+   private:
+    friend class ActorStatistics;
+
+    std::atomic<uint64> event_count_{0};
+    std::atomic<uint64> total_duration_ns_{0};
+    std::atomic<uint64> max_duration_ns_{0};
+    std::atomic<uint64> waited_event_count_{0};
+    std::atomic<uint64> total_wait_time_ns_{0};
+    std::atomic<uint64> max_wait_time_ns_{0};
+    std::atomic<uint64> max_mailbox_size_{0};
+
+    void reset();
+  };
+
+  struct Entry {
+    string name;
+    uint64 event_count = 0;
+    double total_duration = 0.0;
+    double max_duration = 0.0;
+    double average_wait_time = 0.0;
+    double max_wait_time = 0.0;
+    uint64 max_mailbox_size = 0;
+  };
+
+  static bool is_enabled() {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  // enabling of the statistics resets all previously collected values
+  static void set_enabled(bool is_enabled);
+
+  // returns Unix time, from which the statistics is collected, or 0 if the statistics is disabled
+  static int32 get_since_date();
+
+  static Record *get_record(Slice name);
+
+  // returns statistics sorted by decreasing total duration of events
+  static vector<Entry> get_entries();
+
+ private:
+  static std::atomic<bool> is_enabled_;
+};
+
+}  // namespace td
@@ -27,7 +27,7 @@ ConcurrentScheduler::ConcurrentScheduler(int32 additional_thread_count, uint64 t
     queue->init();
     outbound[i] = queue;
   }
-  thread_affinity_mask_ = thread_affinity_mask;
+  thread_affinity_masks_.assign(static_cast<size_t>(additional_thread_count - 1), thread_affinity_mask);
 #endif
 
   // +1 for extra scheduler for IOCP and send_closure from unrelated threads
@@ -70,6 +70,55 @@ void ConcurrentScheduler::test_one_thread_run() {
   } while (!is_finished_.load(std::memory_order_relaxed));
 }
 
+void ConcurrentScheduler::set_thread_affinity_mask(int32 sched_id, uint64 thread_affinity_mask) {
+  CHECK(state_ == State::Start);
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  auto thread_pos = static_cast<size_t>(sched_id - 1);
+  CHECK(thread_pos < thread_affinity_masks_.size());
+  thread_affinity_masks_[thread_pos] = thread_affinity_mask;
+#else
+  (void)sched_id;
+  (void)thread_affinity_mask;
+#endif
+}
+
+void ConcurrentScheduler::enable_work_stealing() {
+  CHECK(state_ == State::Start);
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  auto sched_count = static_cast<int32>(schedulers_.size()) - extra_scheduler_;
+  if (sched_count <= 1) {
+    return;
+  }
+  auto work_stealing_info = std::make_shared<Scheduler::WorkStealingInfo>(sched_count);
+  for (int32 i = 0; i < sched_count; i++) {
+    schedulers_[i]->set_work_stealing_info(work_stealing_info);
+  }
+#endif
+}
+
+void ConcurrentScheduler::enable_timer_wheel() {
+  CHECK(state_ == State::Start);
+  for (auto &sched : schedulers_) {
+    sched->set_use_timer_wheel(true);
+  }
+}
+
+uint64 ConcurrentScheduler::get_stolen_actor_count() const {
+  uint64 result = 0;
+  for (auto &sched : schedulers_) {
+    result += sched->get_stolen_actor_count();
+  }
+  return result;
+}
+
+uint64 ConcurrentScheduler::get_saved_publication_count() const {
+  uint64 result = 0;
+  for (auto &sched : schedulers_) {
+    result += sched->get_saved_publication_count();
+  }
+  return result;
+}
+
 #if !TD_THREAD_UNSUPPORTED
 thread::id ConcurrentScheduler::get_scheduler_thread_id(int32 sched_id) {
   auto thread_pos = static_cast<size_t>(sched_id - 1);
@@ -84,7 +133,7 @@ void ConcurrentScheduler::start() {
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
   for (size_t i = 1; i + extra_scheduler_ < schedulers_.size(); i++) {
     auto &sched = schedulers_[i];
-    threads_.push_back(td::thread([&, thread_affinity_mask = thread_affinity_mask_] {
+    threads_.push_back(td::thread([&, thread_affinity_mask = thread_affinity_masks_[i - 1]] {
 #if TD_PORT_WINDOWS
       detail::Iocp::Guard iocp_guard(iocp_.get());
 #endif
@@ -46,6 +46,19 @@ class ConcurrentScheduler final : private Scheduler::Callback {
 
   void test_one_thread_run();
 
+  // changes CPU affinity mask of the thread of an additional scheduler; must be called before start()
+  void set_thread_affinity_mask(int32 sched_id, uint64 thread_affinity_mask);
+
+  // allows idle schedulers to take ready migratable actors from busy ones; must be called before start()
+  void enable_work_stealing();
+
+  uint64 get_stolen_actor_count() const;
+
+  // stores actor timeouts and timeouts of MultiTimeout in timing wheels; must be called before start()
+  void enable_timer_wheel();
+
+  uint64 get_saved_publication_count() const;
+
   bool is_finished() const {
     return is_finished_.load(std::memory_order_relaxed);
   }
@@ -100,7 +113,7 @@ class ConcurrentScheduler final : private Scheduler::Callback {
   std::atomic<bool> is_finished_{false};
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
   vector<td::thread> threads_;
-  uint64 thread_affinity_mask_ = 0;
+  vector<uint64> thread_affinity_masks_;
 #endif
 #if TD_PORT_WINDOWS
   unique_ptr<detail::Iocp> iocp_;
@@ -18,20 +18,8 @@ void MultiTimeout::set_timeout_at(int64 key, double timeout) {
   LOG(DEBUG) << "Set " << get_name() << " for " << key << " in " << timeout - Time::now();
   auto item = items_.emplace(key);
   auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item.first));
-  if (heap_node->in_heap()) {
-    CHECK(!item.second);
-    bool need_update_timeout = heap_node->is_top();
-    timeout_queue_.fix(timeout, heap_node);
-    if (need_update_timeout || heap_node->is_top()) {
-      update_timeout("set_timeout");
-    }
-  } else {
-    CHECK(item.second);
-    timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
-      update_timeout("set_timeout 2");
-    }
-  }
+  CHECK(heap_node->in_heap() != item.second);
+  set_item_timeout_at(heap_node, timeout, "set_timeout");
 }
 
 void MultiTimeout::add_timeout_at(int64 key, double timeout) {
@@ -42,10 +30,16 @@ void MultiTimeout::add_timeout_at(int64 key, double timeout) {
     CHECK(!item.second);
   } else {
     CHECK(item.second);
-    timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
-      update_timeout("add_timeout");
-    }
+    set_item_timeout_at(heap_node, timeout, "add_timeout");
+  }
+}
+
+void MultiTimeout::set_item_timeout_at(HeapNode *heap_node, double timeout, const char *source) {
+  bool was_empty = timeout_queue_.empty();
+  double old_wakeup_time = was_empty ? 0.0 : timeout_queue_.get_wakeup_time();
+  timeout_queue_.set_timeout_at(timeout, heap_node);
+  if (was_empty || timeout_queue_.get_wakeup_time() != old_wakeup_time) {
+    update_timeout(source);
   }
 }
 
@@ -55,11 +49,11 @@ void MultiTimeout::cancel_timeout(int64 key, const char *source) {
   if (item != items_.end()) {
     auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item));
     CHECK(heap_node->in_heap());
-    bool need_update_timeout = heap_node->is_top();
+    double old_wakeup_time = timeout_queue_.get_wakeup_time();
     timeout_queue_.erase(heap_node);
     items_.erase(item);
 
-    if (need_update_timeout) {
+    if (timeout_queue_.empty() || timeout_queue_.get_wakeup_time() != old_wakeup_time) {
       update_timeout(source);
     }
   }
@@ -71,25 +65,26 @@ void MultiTimeout::update_timeout(const char *source) {
     LOG_CHECK(timeout_queue_.empty()) << get_name() << ' ' << source;
     if (!Actor::has_timeout()) {
       bool has_pending_timeout = false;
-      for (auto &event : get_info()->mailbox_) {
+      get_info()->mailbox_.for_each([&](const Event &event) {
         if (event.type == Event::Type::Timeout) {
           has_pending_timeout = true;
         }
-      }
+      });
       LOG_CHECK(has_pending_timeout) << get_name() << ' ' << get_info()->mailbox_.size() << ' ' << source;
     } else {
       Actor::cancel_timeout();
     }
   } else {
-    LOG(DEBUG) << "Set timeout of " << get_name() << " in " << timeout_queue_.top_key() - Time::now_cached();
-    Actor::set_timeout_at(timeout_queue_.top_key());
+    auto wakeup_time = timeout_queue_.get_wakeup_time();
+    LOG(DEBUG) << "Set timeout of " << get_name() << " in " << wakeup_time - Time::now_cached();
+    Actor::set_timeout_at(wakeup_time);
   }
 }
 
 vector<int64> MultiTimeout::get_expired_keys(double now) {
   vector<int64> expired_keys;
-  while (!timeout_queue_.empty() && timeout_queue_.top_key() < now) {
-    int64 key = static_cast<Item *>(timeout_queue_.pop())->key;
+  while (HeapNode *heap_node = timeout_queue_.pop_expired(now)) {
+    int64 key = static_cast<Item *>(heap_node)->key;
     items_.erase(Item(key));
     expired_keys.push_back(key);
   }
@@ -107,7 +102,13 @@ void MultiTimeout::timeout_expired() {
 }
 
 void MultiTimeout::run_all() {
-  vector<int64> expired_keys = get_expired_keys(Time::now_cached() + 1e10);
+  vector<int64> expired_keys;
+  while (!timeout_queue_.empty()) {
+    // the timing wheel can't be advanced to the future, so all timeouts are popped regardless of the current time
+    int64 key = static_cast<Item *>(timeout_queue_.pop())->key;
+    items_.erase(Item(key));
+    expired_keys.push_back(key);
+  }
   if (!expired_keys.empty()) {
     update_timeout("run_all");
   }
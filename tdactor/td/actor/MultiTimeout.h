@@ -7,6 +7,7 @@
 #pragma once
 
 #include "td/actor/actor.h"
+#include "td/actor/impl/TimeoutQueue.h"
 
 #include "td/utils/common.h"
 #include "td/utils/Heap.h"
@@ -35,6 +36,7 @@ class MultiTimeout final : public Actor {
   using Callback = void (*)(Data, int64);
   explicit MultiTimeout(Slice name) {
     register_actor(name, this).release();
+    timeout_queue_.set_use_timer_wheel(Scheduler::instance()->is_timer_wheel_used());
   }
 
   void set_callback(Callback callback) {
@@ -68,9 +70,11 @@ class MultiTimeout final : public Actor {
   Callback callback_;
   Data data_;
 
-  KHeap<double> timeout_queue_;
+  TimeoutQueue timeout_queue_;
   std::set<Item> items_;
 
+  void set_item_timeout_at(HeapNode *heap_node, double timeout, const char *source);
+
   void update_timeout(const char *source);
 
   void timeout_expired() final;
@@ -75,6 +75,10 @@ class Actor : public ObserverBase {
   void migrate(int32 sched_id);
   void do_migrate(int32 sched_id);
 
+  // allows the scheduler to move the actor to an idle scheduler if work stealing is enabled;
+  // the actor must not depend on its scheduler, for example, it must not have subscribed file descriptors
+  void set_migratable(bool is_migratable);
+
   uint64 get_link_token();
   std::weak_ptr<ActorContext> get_context_weak_ptr() const;
   std::shared_ptr<ActorContext> set_context(std::shared_ptr<ActorContext> context);
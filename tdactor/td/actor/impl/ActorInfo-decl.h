@@ -6,8 +6,10 @@
 //
 #pragma once
 
+#include "td/actor/ActorStatistics.h"
 #include "td/actor/impl/ActorId-decl.h"
 #include "td/actor/impl/Event.h"
+#include "td/actor/impl/Mailbox.h"
 
 #include "td/utils/common.h"
 #include "td/utils/Heap.h"
@@ -103,23 +105,31 @@ class ActorInfo final
   bool is_running() const;
   void finish_run();
 
-  vector<Event> mailbox_;
+  Mailbox mailbox_;
+
+  // events, sent to the actor by the destination scheduler before the migration has finished
+  Mailbox pending_mailbox_;
 
   bool need_context() const;
   bool need_start_up() const;
 
+  void set_migratable(bool is_migratable);
+  bool is_migratable() const;
+
+  ActorStatistics::Record *get_statistics_record();
+
  private:
   Deleter deleter_ = Deleter::None;
   bool need_context_ = true;
   bool need_start_up_ = true;
   bool is_running_ = false;
+  bool is_migratable_ = false;
 
   std::atomic<int32> sched_id_{0};
   Actor *actor_ = nullptr;
+  ActorStatistics::Record *statistics_record_ = nullptr;
 
-#ifdef TD_DEBUG
   string name_;
-#endif
   std::shared_ptr<ActorContext> context_;
 };
 
@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/actor/ActorStatistics.h"
 #include "td/actor/impl/Actor-decl.h"
 #include "td/actor/impl/ActorInfo-decl.h"
 #include "td/actor/impl/Scheduler-decl.h"
@@ -41,15 +42,19 @@ inline void ActorInfo::init(int32 sched_id, Slice name, ObjectPool<ActorInfo>::O
     context_ = Scheduler::context()->this_ptr_.lock();
     VLOG(actor) << "Set context " << context_.get() << " for " << name;
   }
-#ifdef TD_DEBUG
+  // the name is kept even if the statistics is disabled, because it can be enabled after the actor is created;
+  // ActorInfo objects are reused, so the assignment usually doesn't allocate memory and is much cheaper than creation
+  // of the actor itself
   name_.assign(name.data(), name.size());
-#endif
+  // the statistics record is looked up on the first event processed while the statistics is enabled
+  statistics_record_ = nullptr;
 
   actor_->set_info(std::move(this_ptr));
   deleter_ = deleter;
   need_context_ = need_context;
   need_start_up_ = need_start_up;
   is_running_ = false;
+  is_migratable_ = false;
 }
 
 inline bool ActorInfo::need_context() const {
@@ -60,12 +65,28 @@ inline bool ActorInfo::need_start_up() const {
   return need_start_up_;
 }
 
+inline void ActorInfo::set_migratable(bool is_migratable) {
+  is_migratable_ = is_migratable;
+}
+
+inline bool ActorInfo::is_migratable() const {
+  return is_migratable_;
+}
+
+inline ActorStatistics::Record *ActorInfo::get_statistics_record() {
+  if (statistics_record_ == nullptr) {
+    statistics_record_ = ActorStatistics::get_record(get_name());
+  }
+  return statistics_record_;
+}
+
 inline void ActorInfo::on_actor_moved(Actor *actor_new_ptr) {
   actor_ = actor_new_ptr;
 }
 
 inline void ActorInfo::clear() {
   CHECK(mailbox_.empty());
+  CHECK(pending_mailbox_.empty());
   CHECK(!actor_);
   CHECK(!is_running());
   CHECK(!is_migrating());
@@ -88,7 +109,6 @@ inline void ActorInfo::destroy_actor() {
       break;
   }
   actor_ = nullptr;
-  mailbox_.clear();
 }
 
 template <class ActorT>
@@ -164,11 +184,7 @@ inline ActorContext *ActorInfo::get_context() {
 }
 
 inline CSlice ActorInfo::get_name() const {
-#ifdef TD_DEBUG
   return name_;
-#else
-  return "";
-#endif
 }
 
 inline void ActorInfo::start_run() {
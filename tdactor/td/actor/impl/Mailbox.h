@@ -0,0 +1,162 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/actor/impl/Event.h"
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+
+#include <utility>
+
+namespace td {
+
+struct MailboxNode {
+  MailboxNode *next = nullptr;
+  double enqueue_time = 0.0;  // set only if actor statistics is enabled
+  Event event;
+};
+
+// Per-scheduler free list of mailbox nodes. Must be used only by the owning scheduler.
+// Nodes can be allocated by one scheduler and released by another one after actor migration.
+class MailboxNodePool {
+ public:
+  MailboxNodePool() = default;
+  MailboxNodePool(const MailboxNodePool &) = delete;
+  MailboxNodePool &operator=(const MailboxNodePool &) = delete;
+  MailboxNodePool(MailboxNodePool &&) = delete;
+  MailboxNodePool &operator=(MailboxNodePool &&) = delete;
+  ~MailboxNodePool() {
+    while (free_list_ != nullptr) {
+      auto node = free_list_;
+      free_list_ = node->next;
+      delete node;
+    }
+  }
+
+  MailboxNode *create(Event &&event) {
+    MailboxNode *node = free_list_;
+    if (node == nullptr) {
+      node = new MailboxNode();
+    } else {
+      free_list_ = node->next;
+      free_node_count_--;
+      node->next = nullptr;
+      node->enqueue_time = 0.0;
+    }
+    node->event = std::move(event);
+    return node;
+  }
+
+  void release(MailboxNode *node) {
+    // destruction of the event can create new nodes
+    node->event.clear();
+    if (free_node_count_ >= MAX_FREE_NODE_COUNT) {
+      delete node;
+      return;
+    }
+    node->next = free_list_;
+    free_list_ = node;
+    free_node_count_++;
+  }
+
+ private:
+  static constexpr size_t MAX_FREE_NODE_COUNT = 1 << 14;
+
+  MailboxNode *free_list_ = nullptr;
+  size_t free_node_count_ = 0;
+};
+
+// Intrusive FIFO queue of events. Must be used only by the scheduler, which owns the actor.
+class Mailbox {
+ public:
+  Mailbox() = default;
+  Mailbox(const Mailbox &) = delete;
+  Mailbox &operator=(const Mailbox &) = delete;
+  Mailbox(Mailbox &&) = delete;
+  Mailbox &operator=(Mailbox &&) = delete;
+  ~Mailbox() = default;
+
+  bool empty() const {
+    return head_ == nullptr;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  MailboxNode *back() const {
+    return tail_;
+  }
+
+  void push(MailboxNode *node) {
+    CHECK(node->next == nullptr);
+    if (tail_ == nullptr) {
+      head_ = node;
+    } else {
+      tail_->next = node;
+    }
+    tail_ = node;
+    size_++;
+  }
+
+  MailboxNode *pop() {
+    auto node = head_;
+    CHECK(node != nullptr);
+    head_ = node->next;
+    if (head_ == nullptr) {
+      tail_ = nullptr;
+    }
+    node->next = nullptr;
+    size_--;
+    return node;
+  }
+
+  // moves all events from other to the end of the mailbox
+  void append(Mailbox &other) {
+    if (other.empty()) {
+      return;
+    }
+    if (tail_ == nullptr) {
+      head_ = other.head_;
+    } else {
+      tail_->next = other.head_;
+    }
+    tail_ = other.tail_;
+    size_ += other.size_;
+    other.head_ = nullptr;
+    other.tail_ = nullptr;
+    other.size_ = 0;
+  }
+
+  void clear(MailboxNodePool &pool) {
+    while (!empty()) {
+      pool.release(pop());
+    }
+  }
+
+  template <class F>
+  void for_each(F &&f) {
+    for (auto node = head_; node != nullptr; node = node->next) {
+      f(node->event);
+    }
+  }
+
+  template <class F>
+  void for_each(F &&f) const {
+    for (const MailboxNode *node = head_; node != nullptr; node = node->next) {
+      f(node->event);
+    }
+  }
+
+ private:
+  MailboxNode *head_ = nullptr;
+  MailboxNode *tail_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace td
@@ -9,11 +9,11 @@
 #include "td/actor/impl/Actor-decl.h"
 #include "td/actor/impl/ActorId-decl.h"
 #include "td/actor/impl/EventFull-decl.h"
+#include "td/actor/impl/Mailbox.h"
+#include "td/actor/impl/TimeoutQueue.h"
 
 #include "td/utils/Closure.h"
 #include "td/utils/common.h"
-#include "td/utils/FlatHashMap.h"
-#include "td/utils/Heap.h"
 #include "td/utils/List.h"
 #include "td/utils/logging.h"
 #include "td/utils/MovableValue.h"
@@ -28,6 +28,7 @@
 #include "td/utils/Time.h"
 #include "td/utils/type_traits.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <type_traits>
@@ -69,6 +70,23 @@ class Scheduler {
     virtual void on_finish() = 0;
     virtual void register_at_finish(std::function<void()>) = 0;
   };
+
+  // shared between schedulers, which are allowed to steal migratable actors from each other
+  class WorkStealingInfo {
+   public:
+    explicit WorkStealingInfo(int32 sched_count) : schedulers_(static_cast<size_t>(sched_count)) {
+    }
+
+   private:
+    struct SchedulerInfo {
+      std::atomic<bool> is_idle{false};
+      std::atomic<uint64> stolen_actor_count{0};
+    };
+    vector<SchedulerInfo> schedulers_;
+
+    friend class Scheduler;
+  };
+
   Scheduler() = default;
   Scheduler(const Scheduler &) = delete;
   Scheduler &operator=(const Scheduler &) = delete;
@@ -78,6 +96,19 @@ class Scheduler {
 
   void init(int32 id, std::vector<std::shared_ptr<MpscPollableQueue<EventFull>>> outbound, Callback *callback);
 
+  void set_work_stealing_info(std::shared_ptr<WorkStealingInfo> work_stealing_info);
+
+  // returns number of actors, which were taken from the scheduler by other schedulers
+  uint64 get_stolen_actor_count() const;
+
+  // returns number of publications to other schedulers' queues, which were avoided by batching events
+  uint64 get_saved_publication_count() const;
+
+  // stores actor timeouts in a timing wheel instead of a heap; must be called before any timeout is set
+  void set_use_timer_wheel(bool use_timer_wheel);
+
+  bool is_timer_wheel_used() const;
+
   int32 sched_id() const;
   int32 sched_count() const;
 
@@ -214,6 +245,10 @@ class Scheduler {
 
   Timestamp run_timeout();
   void run_mailbox();
+  void flush_outbound_batches();
+  bool can_give_away_actor(const ActorInfo *actor_info) const;
+  int32 give_away_actors(int32 dest_sched_id, int32 max_actor_count);
+  void share_work();
   Timestamp run_events(Timestamp timeout);
   void run_poll(Timestamp timeout);
 
@@ -230,9 +265,9 @@ class Scheduler {
   int32 actor_count_ = 0;
   ListNode pending_actors_list_;
   ListNode ready_actors_list_;
-  KHeap<double> timeout_queue_;
+  TimeoutQueue timeout_queue_;
 
-  FlatHashMap<ActorInfo *, std::vector<Event>> pending_events_;
+  MailboxNodePool mailbox_node_pool_;
 
   ServiceActor service_actor_;
   Poll poll_;
@@ -246,6 +281,14 @@ class Scheduler {
   std::shared_ptr<MpscPollableQueue<EventFull>> inbound_queue_;
   std::vector<std::shared_ptr<MpscPollableQueue<EventFull>>> outbound_queues_;
 
+  // events for other schedulers are batched during run_events and published together
+  bool is_batching_outbound_events_ = false;
+  std::vector<std::vector<EventFull>> outbound_batches_;
+  std::vector<int32> outbound_batch_sched_ids_;
+  std::atomic<uint64> saved_publication_count_{0};
+
+  std::shared_ptr<WorkStealingInfo> work_stealing_info_;
+
   std::shared_ptr<ActorContext> save_context_;
 
   struct EventContext {
@@ -6,13 +6,13 @@
 //
 #include "td/actor/impl/Scheduler.h"
 
+#include "td/actor/ActorStatistics.h"
 #include "td/actor/impl/Actor.h"
 #include "td/actor/impl/ActorId.h"
 #include "td/actor/impl/ActorInfo.h"
 #include "td/actor/impl/Event.h"
 #include "td/actor/impl/EventFull.h"
 
-#include "td/utils/algorithm.h"
 #include "td/utils/common.h"
 #include "td/utils/ExitGuard.h"
 #include "td/utils/format.h"
@@ -229,10 +229,35 @@ void Scheduler::init(int32 id, std::vector<std::shared_ptr<MpscPollableQueue<Eve
   outbound_queues_ = std::move(outbound);
   sched_id_ = id;
   sched_n_ = static_cast<int32>(outbound_queues_.size());
+  outbound_batches_.resize(outbound_queues_.size());
   service_actor_.set_queue(inbound_queue_);
   register_actor(PSLICE() << "ServiceActor" << id, &service_actor_).release();
 }
 
+void Scheduler::set_work_stealing_info(std::shared_ptr<WorkStealingInfo> work_stealing_info) {
+  CHECK(work_stealing_info == nullptr || static_cast<size_t>(sched_id_) < work_stealing_info->schedulers_.size());
+  work_stealing_info_ = std::move(work_stealing_info);
+}
+
+uint64 Scheduler::get_saved_publication_count() const {
+  return saved_publication_count_.load(std::memory_order_relaxed);
+}
+
+void Scheduler::set_use_timer_wheel(bool use_timer_wheel) {
+  timeout_queue_.set_use_timer_wheel(use_timer_wheel);
+}
+
+bool Scheduler::is_timer_wheel_used() const {
+  return timeout_queue_.is_timer_wheel_used();
+}
+
+uint64 Scheduler::get_stolen_actor_count() const {
+  if (work_stealing_info_ == nullptr) {
+    return 0;
+  }
+  return work_stealing_info_->schedulers_[sched_id_].stolen_actor_count.load(std::memory_order_relaxed);
+}
+
 void Scheduler::clear() {
   if (service_actor_.empty()) {
     return;
@@ -338,14 +363,8 @@ void Scheduler::register_migrated_actor(ActorInfo *actor_info) {
   CHECK(sched_id_ == actor_info->migrate_dest());
   // CHECK(!actor_info->is_running());
   actor_info->finish_migrate();
-  for (auto &event : actor_info->mailbox_) {
-    finish_migrate(event);
-  }
-  auto it = pending_events_.find(actor_info);
-  if (it != pending_events_.end()) {
-    append(actor_info->mailbox_, std::move(it->second));
-    pending_events_.erase(it);
-  }
+  actor_info->mailbox_.for_each([](Event &event) { finish_migrate(event); });
+  actor_info->mailbox_.append(actor_info->pending_mailbox_);
   if (actor_info->mailbox_.empty()) {
     pending_actors_list_.put(actor_info->get_list_node());
   } else {
@@ -363,11 +382,36 @@ void Scheduler::send_to_other_scheduler(int32 sched_id, const ActorId<> &actor_i
       VLOG(actor) << "Send to scheduler " << sched_id << ": " << event;
     }
     start_migrate(event, sched_id);
+    if (is_batching_outbound_events_) {
+      auto &batch = outbound_batches_[sched_id];
+      if (batch.empty()) {
+        outbound_batch_sched_ids_.push_back(sched_id);
+      }
+      batch.push_back(EventCreator::event_unsafe(actor_id, std::move(event)));
+      return;
+    }
     outbound_queues_[sched_id]->writer_put(EventCreator::event_unsafe(actor_id, std::move(event)));
     outbound_queues_[sched_id]->writer_flush();
   }
 }
 
+void Scheduler::flush_outbound_batches() {
+  uint64 saved_publication_count = 0;
+  for (auto sched_id : outbound_batch_sched_ids_) {
+    auto &batch = outbound_batches_[sched_id];
+    CHECK(!batch.empty());
+    saved_publication_count += batch.size() - 1;
+    outbound_queues_[sched_id]->writer_put_batch(batch);
+    outbound_queues_[sched_id]->writer_flush();
+  }
+  outbound_batch_sched_ids_.clear();
+  if (saved_publication_count != 0) {
+    saved_publication_count_.store(
+        saved_publication_count_.load(std::memory_order_relaxed) + saved_publication_count,
+        std::memory_order_relaxed);
+  }
+}
+
 void Scheduler::run_on_scheduler(int32 sched_id, Promise<Unit> action) {
   if (sched_id >= 0 && sched_id_ != sched_id) {
     class Worker final : public Actor {
@@ -412,7 +456,18 @@ void Scheduler::add_to_mailbox(ActorInfo *actor_info, Event &&event) {
     ready_actors_list_.put(node);
   }
   VLOG(actor) << "Add to mailbox: " << *actor_info << " " << event;
-  actor_info->mailbox_.push_back(std::move(event));
+  auto node = mailbox_node_pool_.create(std::move(event));
+  if (unlikely(ActorStatistics::is_enabled())) {
+    node->enqueue_time = Time::now();
+    actor_info->mailbox_.push(node);
+    actor_info->get_statistics_record()->on_mailbox_size(actor_info->mailbox_.size());
+    return;
+  }
+  actor_info->mailbox_.push(node);
+}
+
+void Scheduler::clear_mailbox(ActorInfo *actor_info) {
+  actor_info->mailbox_.clear(mailbox_node_pool_);
 }
 
 void Scheduler::do_stop_actor(Actor *actor) {
@@ -429,10 +484,12 @@ void Scheduler::do_stop_actor(ActorInfo *actor_info) {
     owner_ptr = actor_info->get_actor_unsafe()->clear();
     // Actor context is visible in destructor
     actor_info->destroy_actor();
+    clear_mailbox(actor_info);
     event_context_ptr_->flags = 0;
   } else {
     owner_ptr = actor_info->get_actor_unsafe()->clear();
     actor_info->destroy_actor();
+    clear_mailbox(actor_info);
   }
   destroy_actor(actor_info);
 }
@@ -475,9 +532,7 @@ void Scheduler::start_migrate_actor(ActorInfo *actor_info, int32 dest_sched_id)
   actor_count_--;
   CHECK(actor_count_ >= 0);
   actor_info->get_actor_unsafe()->on_start_migrate(dest_sched_id);
-  for (auto &event : actor_info->mailbox_) {
-    start_migrate(event, dest_sched_id);
-  }
+  actor_info->mailbox_.for_each([dest_sched_id](Event &event) { start_migrate(event, dest_sched_id); });
   actor_info->start_migrate(dest_sched_id);
   actor_info->get_list_node()->remove();
   cancel_actor_timeout(actor_info);
@@ -502,11 +557,7 @@ void Scheduler::set_actor_timeout_in(ActorInfo *actor_info, double timeout) {
 void Scheduler::set_actor_timeout_at(ActorInfo *actor_info, double timeout_at) {
   HeapNode *heap_node = actor_info->get_heap_node();
   VLOG(actor) << "Set actor " << *actor_info << " timeout in " << timeout_at - Time::now_cached();
-  if (heap_node->in_heap()) {
-    timeout_queue_.fix(timeout_at, heap_node);
-  } else {
-    timeout_queue_.insert(timeout_at, heap_node);
-  }
+  timeout_queue_.set_timeout_at(timeout_at, heap_node);
 }
 
 void Scheduler::run_poll(Timestamp timeout) {
@@ -523,14 +574,27 @@ void Scheduler::run_poll(Timestamp timeout) {
 
 void Scheduler::flush_mailbox(ActorInfo *actor_info) {
   auto &mailbox = actor_info->mailbox_;
-  size_t mailbox_size = mailbox.size();
-  CHECK(mailbox_size != 0);
+  CHECK(!mailbox.empty());
   EventGuard guard(this, actor_info);
-  size_t i = 0;
-  for (; i < mailbox_size && guard.can_run(); i++) {
-    do_event(actor_info, std::move(mailbox[i]));
+  // events added during the flush will be processed only during the next flush
+  auto last_node = mailbox.back();
+  bool need_statistics = ActorStatistics::is_enabled();
+  while (guard.can_run()) {
+    auto node = mailbox.pop();
+    bool is_last = node == last_node;
+    if (unlikely(need_statistics)) {
+      auto start_time = Time::now();
+      auto wait_time = node->enqueue_time > 0 ? start_time - node->enqueue_time : -1.0;
+      do_event(actor_info, std::move(node->event));
+      actor_info->get_statistics_record()->on_event(Time::now() - start_time, wait_time);
+    } else {
+      do_event(actor_info, std::move(node->event));
+    }
+    mailbox_node_pool_.release(node);
+    if (is_last) {
+      break;
+    }
   }
-  mailbox.erase(mailbox.begin(), mailbox.begin() + i);
 }
 
 void Scheduler::run_mailbox() {
@@ -562,11 +626,60 @@ void Scheduler::run_mailbox() {
   //LOG_CHECK(cnt == actor_count_) << cnt << " vs " << actor_count_;
 }
 
+bool Scheduler::can_give_away_actor(const ActorInfo *actor_info) const {
+  // actors with a timeout aren't given away, because migration cancels the timeout
+  return actor_info->is_migratable() && !actor_info->is_running() && !actor_info->get_heap_node()->in_heap();
+}
+
+int32 Scheduler::give_away_actors(int32 dest_sched_id, int32 max_actor_count) {
+  int32 actor_count = 0;
+  for (ListNode *it = ready_actors_list_.next; actor_count < max_actor_count && it != &ready_actors_list_;) {
+    auto actor_info = ActorInfo::from_list_node(it);
+    it = it->next;
+    if (can_give_away_actor(actor_info)) {
+      VLOG(actor) << "Give away " << *actor_info << " to scheduler " << dest_sched_id;
+      do_migrate_actor(actor_info, dest_sched_id);
+      actor_count++;
+    }
+  }
+  return actor_count;
+}
+
+void Scheduler::share_work() {
+  auto &schedulers = work_stealing_info_->schedulers_;
+  int32 migratable_actor_count = -1;
+  for (size_t i = 0; i < schedulers.size(); i++) {
+    auto thief_sched_id = static_cast<int32>(i);
+    if (thief_sched_id == sched_id_ || !schedulers[i].is_idle.load(std::memory_order_relaxed)) {
+      continue;
+    }
+    if (migratable_actor_count == -1) {
+      migratable_actor_count = 0;
+      for (ListNode *end = &ready_actors_list_, *it = ready_actors_list_.next; it != end; it = it->next) {
+        if (can_give_away_actor(ActorInfo::from_list_node(it))) {
+          migratable_actor_count++;
+        }
+      }
+    }
+    if (migratable_actor_count < 2) {
+      return;
+    }
+    if (!schedulers[i].is_idle.exchange(false, std::memory_order_acq_rel)) {
+      // the scheduler has already found some work
+      continue;
+    }
+
+    // give away a half of ready migratable actors
+    auto actor_count = give_away_actors(thief_sched_id, migratable_actor_count / 2);
+    migratable_actor_count -= actor_count;
+    schedulers[sched_id_].stolen_actor_count.fetch_add(actor_count, std::memory_order_relaxed);
+  }
+}
+
 Timestamp Scheduler::run_timeout() {
   double now = Time::now();
   //TODO: use Timestamp().is_in_past()
-  while (!timeout_queue_.empty() && timeout_queue_.top_key() < now) {
-    HeapNode *node = timeout_queue_.pop();
+  while (HeapNode *node = timeout_queue_.pop_expired(now)) {
     ActorInfo *actor_info = ActorInfo::from_heap_node(node);
     send_immediately(actor_info->actor_id(), Event::timeout());
   }
@@ -575,12 +688,17 @@ Timestamp Scheduler::run_timeout() {
 
 Timestamp Scheduler::run_events(Timestamp timeout) {
   Timestamp res;
-  VLOG(actor) << "Run events " << sched_id_ << " " << tag("pending", pending_events_.size())
-              << tag("actors", actor_count_);
+  VLOG(actor) << "Run events " << sched_id_ << " " << tag("actors", actor_count_);
+  is_batching_outbound_events_ = true;
   do {
     run_mailbox();
+    if (work_stealing_info_ != nullptr) {
+      share_work();
+    }
     res = run_timeout();
+    flush_outbound_batches();
   } while (!ready_actors_list_.empty() && !timeout.is_in_past());
+  is_batching_outbound_events_ = false;
   return res;
 }
 
@@ -594,7 +712,15 @@ void Scheduler::run_no_guard(Timestamp timeout) {
   if (yield_flag_) {
     return;
   }
+  bool is_idle = work_stealing_info_ != nullptr && ready_actors_list_.empty();
+  if (is_idle) {
+    // busy schedulers will migrate some actors to the scheduler and wake it up
+    work_stealing_info_->schedulers_[sched_id_].is_idle.store(true, std::memory_order_release);
+  }
   run_poll(timeout);
+  if (is_idle) {
+    work_stealing_info_->schedulers_[sched_id_].is_idle.store(false, std::memory_order_relaxed);
+  }
   run_events(timeout);
 }
 
@@ -605,7 +731,7 @@ Timestamp Scheduler::get_timeout() {
   if (timeout_queue_.empty()) {
     return Timestamp::in(10000);
   }
-  return Timestamp::at(timeout_queue_.top_key());
+  return Timestamp::at(timeout_queue_.get_wakeup_time());
 }
 
 }  // namespace td
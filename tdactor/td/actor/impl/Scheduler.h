@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/actor/ActorStatistics.h"
 #include "td/actor/impl/ActorInfo-decl.h"
 #include "td/actor/impl/Scheduler-decl.h"
 
@@ -142,8 +143,9 @@ inline void Scheduler::destroy_actor(ActorInfo *actor_info) {
 
 inline void Scheduler::send_to_scheduler(int32 sched_id, const ActorId<Actor> &actor_id, Event &&event) {
   if (sched_id == sched_id_) {
+    // the actor is migrating to the current scheduler
     ActorInfo *actor_info = actor_id.get_actor_info();
-    pending_events_[actor_info].push_back(std::move(event));
+    actor_info->pending_mailbox_.push(mailbox_node_pool_.create(std::move(event)));
   } else {
     send_to_other_scheduler(sched_id, actor_id, std::move(event));
   }
@@ -193,7 +195,13 @@ void Scheduler::send_immediately_impl(const ActorId<> &actor_id, const RunFuncT
 
   if (likely(can_send_immediately)) {  // run immediately
     EventGuard guard(this, actor_info);
-    run_func(actor_info);
+    if (unlikely(ActorStatistics::is_enabled())) {
+      auto start_time = Time::now();
+      run_func(actor_info);
+      actor_info->get_statistics_record()->on_event(Time::now() - start_time, 0.0);
+    } else {
+      run_func(actor_info);
+    }
   } else {
     if (on_current_sched) {
       add_to_mailbox(actor_info, event_func());
@@ -0,0 +1,94 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Heap.h"
+#include "td/utils/logging.h"
+#include "td/utils/TimerWheel.h"
+
+namespace td {
+
+// Queue of timeouts, stored either in a heap, or in a timing wheel.
+// The heap returns timeouts exactly in order; the timing wheel batches timeouts by ticks of about 1 millisecond,
+// but is much faster when there are many timeouts.
+class TimeoutQueue {
+ public:
+  bool is_timer_wheel_used() const {
+    return timer_wheel_ != nullptr;
+  }
+
+  void set_use_timer_wheel(bool use_timer_wheel) {
+    CHECK(empty());
+    if (use_timer_wheel) {
+      if (timer_wheel_ == nullptr) {
+        timer_wheel_ = make_unique<TimerWheel>();
+      }
+    } else {
+      timer_wheel_ = nullptr;
+    }
+  }
+
+  bool empty() const {
+    return timer_wheel_ != nullptr ? timer_wheel_->empty() : heap_.empty();
+  }
+
+  double get_key(const HeapNode *node) const {
+    return timer_wheel_ != nullptr ? timer_wheel_->get_key(node) : heap_.get_key(node);
+  }
+
+  void set_timeout_at(double timeout_at, HeapNode *node) {
+    if (timer_wheel_ != nullptr) {
+      if (node->in_heap()) {
+        timer_wheel_->fix(timeout_at, node);
+      } else {
+        timer_wheel_->insert(timeout_at, node);
+      }
+    } else {
+      if (node->in_heap()) {
+        heap_.fix(timeout_at, node);
+      } else {
+        heap_.insert(timeout_at, node);
+      }
+    }
+  }
+
+  void erase(HeapNode *node) {
+    if (timer_wheel_ != nullptr) {
+      timer_wheel_->erase(node);
+    } else {
+      heap_.erase(node);
+    }
+  }
+
+  // returns time, before which no timeout can expire; the queue must be non-empty
+  double get_wakeup_time() const {
+    return timer_wheel_ != nullptr ? timer_wheel_->get_wakeup_time() : heap_.top_key();
+  }
+
+  // returns a node, which timeout expired before now, or nullptr if there are no such nodes
+  HeapNode *pop_expired(double now) {
+    if (timer_wheel_ != nullptr) {
+      return timer_wheel_->pop_expired(now);
+    }
+    if (heap_.empty() || !(heap_.top_key() < now)) {
+      return nullptr;
+    }
+    return heap_.pop();
+  }
+
+  // returns a node with one of the earliest timeouts regardless of the current time; the queue must be non-empty
+  HeapNode *pop() {
+    return timer_wheel_ != nullptr ? timer_wheel_->pop() : heap_.pop();
+  }
+
+ private:
+  KHeap<double> heap_;
+  unique_ptr<TimerWheel> timer_wheel_;  // the timing wheel is big, so it is allocated only if used
+};
+
+}  // namespace td
@@ -12,6 +12,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/Random.h"
 #include "td/utils/tests.h"
+#include "td/utils/Time.h"
 
 TEST(MultiTimeout, bug) {
   td::ConcurrentScheduler sched(0, 0);
@@ -110,3 +111,46 @@ TEST(MultiTimeout, Destroy) {
   }
   sched.finish();
 }
+
+TEST(MultiTimeout, timer_wheel) {
+  td::ConcurrentScheduler sched(0, 0);
+  sched.enable_timer_wheel();
+
+  sched.start();
+  td::unique_ptr<td::MultiTimeout> multi_timeout;
+  struct Data {
+    td::vector<double> expires_at;
+    td::int32 left_timeout_count = 0;
+  };
+  Data data;
+
+  {
+    auto guard = sched.get_main_guard();
+    ASSERT_TRUE(td::Scheduler::instance()->is_timer_wheel_used());
+    multi_timeout = td::make_unique<td::MultiTimeout>("MultiTimeout");
+    multi_timeout->set_callback([](void *void_data, td::int64 key) {
+      auto &data = *static_cast<Data *>(void_data);
+      ASSERT_TRUE(data.expires_at[static_cast<size_t>(key)] <= td::Time::now());
+      data.expires_at[static_cast<size_t>(key)] = 1e100;
+      if (--data.left_timeout_count == 0) {
+        td::Scheduler::instance()->finish();
+      }
+    });
+    multi_timeout->set_callback_data(&data);
+    for (td::int64 key = 0; key < 100; key++) {
+      auto timeout = td::Random::fast(1, 50) / 1000.0;
+      data.expires_at.push_back(td::Time::now() + timeout);
+      multi_timeout->set_timeout_in(key, timeout);
+      data.left_timeout_count++;
+    }
+    for (td::int64 key = 0; key < 100; key += 10) {
+      multi_timeout->cancel_timeout(key);
+      data.left_timeout_count--;
+    }
+  }
+
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+}
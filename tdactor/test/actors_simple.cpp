@@ -5,6 +5,7 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 #include "td/actor/actor.h"
+#include "td/actor/ActorStatistics.h"
 #include "td/actor/ConcurrentScheduler.h"
 #include "td/actor/MultiPromise.h"
 #include "td/actor/PromiseFuture.h"
@@ -494,6 +495,30 @@ TEST(Actors, later) {
   ASSERT_STREQ(sb.as_cslice().c_str(), "AAABBB");
 }
 
+TEST(Actors, statistics) {
+  td::ActorStatistics::set_enabled(true);
+  sb.clear();
+  td::ConcurrentScheduler scheduler(0, 0);
+  scheduler.create_actor_unsafe<LaterMasterActor>(0, "A").release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+  ASSERT_STREQ(sb.as_cslice().c_str(), "AAABBB");
+
+  auto entries = td::ActorStatistics::get_entries();
+  td::ActorStatistics::set_enabled(false);
+  bool has_slave_entry = false;
+  for (auto &entry : entries) {
+    if (entry.name == "B") {
+      has_slave_entry = true;
+      ASSERT_TRUE(entry.event_count >= 6u);
+      ASSERT_TRUE(entry.max_mailbox_size >= 1u);
+    }
+  }
+  ASSERT_TRUE(has_slave_entry);
+}
+
 class MultiPromise2 final : public td::Actor {
  public:
   void start_up() final {
@@ -638,6 +663,64 @@ TEST(Actors, send_from_other_threads) {
   }
   scheduler.finish();
 }
+
+TEST(Actors, send_batched_to_other_schedulers) {
+  static constexpr int QUERY_COUNT = 1000;
+  class Receiver final : public td::Actor {
+   public:
+    explicit Receiver(td::Promise<td::Unit> promise) : promise_(std::move(promise)) {
+    }
+    void receive(int query_id) {
+      CHECK(query_id == next_query_id_);
+      if (++next_query_id_ == QUERY_COUNT) {
+        promise_.set_value(td::Unit());
+      }
+    }
+
+   private:
+    td::Promise<td::Unit> promise_;
+    int next_query_id_ = 0;
+  };
+  class Sender final : public td::Actor {
+   public:
+    void on_received() {
+      if (++received_count_ == 2) {
+        td::Scheduler::instance()->finish();
+      }
+    }
+
+   private:
+    int received_count_ = 0;
+
+    td::Promise<td::Unit> create_promise() {
+      return td::PromiseCreator::lambda(
+          [actor_id = actor_id(this)](td::Unit) { td::send_closure(actor_id, &Sender::on_received); });
+    }
+
+    void start_up() final {
+      yield();
+    }
+
+    void wakeup() final {
+      // all events are sent during a single run of the mailbox and are published in one batch per scheduler
+      auto first = td::create_actor_on_scheduler<Receiver>("Receiver", 0, create_promise()).release();
+      auto second = td::create_actor_on_scheduler<Receiver>("Receiver", 2, create_promise()).release();
+      for (int i = 0; i < QUERY_COUNT; i++) {
+        td::send_closure(first, &Receiver::receive, i);
+        td::send_closure(second, &Receiver::receive, i);
+      }
+    }
+  };
+
+  td::ConcurrentScheduler scheduler(2, 0);
+  scheduler.create_actor_unsafe<Sender>(1, "Sender").release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  // schedulers are destroyed by finish
+  ASSERT_TRUE(scheduler.get_saved_publication_count() >= static_cast<td::uint64>(2 * (QUERY_COUNT - 1)));
+  scheduler.finish();
+}
 #endif
 
 class DelayedCall final : public td::Actor {
@@ -680,3 +763,47 @@ TEST(Actors, MultiPromiseSendClosureLater) {
   }
   scheduler.finish();
 }
+
+TEST(Actors, statistics_enabled_later) {
+  class Worker final : public td::Actor {
+   public:
+    void ping(bool is_last) {
+      if (is_last) {
+        td::Scheduler::instance()->finish();
+        stop();
+      }
+    }
+  };
+  class Main final : public td::Actor {
+    void start_up() final {
+      auto worker = td::create_actor<Worker>("StatisticsWorker").release();
+      send_closure(worker, &Worker::ping, false);
+
+      // the statistics is enabled after the actor is created
+      td::ActorStatistics::set_enabled(true);
+      for (int i = 0; i < 3; i++) {
+        send_closure_later(worker, &Worker::ping, i == 2);
+      }
+      stop();
+    }
+  };
+
+  td::ActorStatistics::set_enabled(false);
+  td::ConcurrentScheduler scheduler(0, 0);
+  scheduler.create_actor_unsafe<Main>(0, "Main").release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+
+  auto entries = td::ActorStatistics::get_entries();
+  td::ActorStatistics::set_enabled(false);
+  bool has_worker_entry = false;
+  for (auto &entry : entries) {
+    if (entry.name == "StatisticsWorker") {
+      has_worker_entry = true;
+      ASSERT_TRUE(entry.event_count >= 3u);
+    }
+  }
+  ASSERT_TRUE(has_worker_entry);
+}
@@ -106,13 +106,20 @@ class Manager final : public td::Actor {
   int query_size_;
 };
 
-static void test_workers(int threads_n, int workers_n, int queries_n, int query_size) {
+static void test_workers(int threads_n, int workers_n, int queries_n, int query_size,
+                         bool use_work_stealing = false) {
   td::ConcurrentScheduler sched(threads_n, 0);
+  if (use_work_stealing) {
+    sched.enable_work_stealing();
+  }
 
   td::vector<td::ActorId<PowerWorker>> workers;
   for (int i = 0; i < workers_n; i++) {
-    int thread_id = threads_n ? i % (threads_n - 1) + 2 : 0;
+    int thread_id = threads_n ? (use_work_stealing ? 2 : i % (threads_n - 1) + 2) : 0;
     workers.push_back(sched.create_actor_unsafe<PowerWorker>(thread_id, PSLICE() << "worker" << i).release());
+    if (use_work_stealing) {
+      workers.back().get_actor_unsafe()->set_migratable(true);
+    }
   }
   sched.create_actor_unsafe<Manager>(threads_n ? 1 : 0, "Manager", queries_n, query_size, std::move(workers)).release();
 
@@ -149,6 +156,14 @@ TEST(Actors, workers_small_query_nine_threads) {
   test_workers(9, 10, 10000, 1);
 }
 
+TEST(Actors, workers_big_query_work_stealing) {
+  test_workers(3, 10, 1000, 300000, true);
+}
+
+TEST(Actors, workers_small_query_work_stealing) {
+  test_workers(3, 10, 10000, 1, true);
+}
+
 class SenderActor;
 
 class ReceiverActor final : public td::Actor {
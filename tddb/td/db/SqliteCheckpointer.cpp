@@ -0,0 +1,78 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/db/SqliteCheckpointer.h"
+
+#include "td/actor/actor.h"
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+
+namespace td {
+
+class SqliteCheckpointer final : public SqliteCheckpointerInterface {
+ public:
+  SqliteCheckpointer(std::shared_ptr<SqliteConnectionSafe> connection, int32 scheduler_id) {
+    impl_ = create_actor_on_scheduler<Impl>("SqliteCheckpointer", scheduler_id, std::move(connection));
+  }
+
+  void close(Promise<Unit> promise) final {
+    send_closure_later(impl_, &Impl::close, std::move(promise));
+  }
+
+ private:
+  class Impl final : public Actor {
+   public:
+    explicit Impl(std::shared_ptr<SqliteConnectionSafe> connection) : connection_(std::move(connection)) {
+    }
+
+    void close(Promise<Unit> promise) {
+      connection_.reset();
+      stop();
+      promise.set_value(Unit());
+    }
+
+   private:
+    static constexpr double CHECK_DELAY = 1.0;
+
+    std::shared_ptr<SqliteConnectionSafe> connection_;
+
+    void start_up() final {
+      connection_->set_checkpointer(actor_id());
+
+      // the database could have been changed before the checkpointer was created
+      if (connection_->arm_checkpointer()) {
+        set_timeout_in(CHECK_DELAY);
+      }
+    }
+
+    void wakeup() final {
+      // the database was changed after the last checkpoint
+      set_timeout_in(CHECK_DELAY);
+    }
+
+    void timeout_expired() final {
+      auto r_was_changed = connection_->checkpoint_if_idle();
+      if (r_was_changed.is_error()) {
+        LOG(ERROR) << "Failed to checkpoint database: " << r_was_changed.error();
+      }
+
+      // the checkpointer sleeps until the next commit after the database was checkpointed
+      if ((r_was_changed.is_ok() && r_was_changed.ok()) || connection_->disarm_checkpointer()) {
+        set_timeout_in(CHECK_DELAY);
+      }
+    }
+  };
+
+  ActorOwn<Impl> impl_;
+};
+
+unique_ptr<SqliteCheckpointerInterface> create_sqlite_checkpointer(std::shared_ptr<SqliteConnectionSafe> connection,
+                                                                   int32 scheduler_id) {
+  return td::make_unique<SqliteCheckpointer>(std::move(connection), scheduler_id);
+}
+
+}  // namespace td
@@ -0,0 +1,29 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/db/SqliteConnectionSafe.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Promise.h"
+
+#include <memory>
+
+namespace td {
+
+class SqliteCheckpointerInterface {
+ public:
+  virtual ~SqliteCheckpointerInterface() = default;
+
+  virtual void close(Promise<Unit> promise) = 0;
+};
+
+// checkpoints WAL file of the database on the scheduler, when the database isn't changed for some time after a commit
+unique_ptr<SqliteCheckpointerInterface> create_sqlite_checkpointer(std::shared_ptr<SqliteConnectionSafe> connection,
+                                                                   int32 scheduler_id);
+
+}  // namespace td
@@ -9,24 +9,110 @@
 #include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/SliceBuilder.h"
+
+#include "sqlite/sqlite3.h"
 
 namespace td {
 
-SqliteConnectionSafe::SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version)
+SqliteConnectionSettings SqliteConnectionSettings::low_memory() {
+  SqliteConnectionSettings settings;
+  settings.cache_size = -512;
+  settings.max_wal_page_count = 250;
+  settings.journal_size_limit = 1 << 20;
+  return settings;
+}
+
+SqliteConnectionSettings SqliteConnectionSettings::high_performance() {
+  SqliteConnectionSettings settings;
+  settings.mmap_size = static_cast<int64>(1) << 28;
+  settings.cache_size = -65536;
+  settings.use_memory_temp_store = true;
+  settings.max_wal_page_count = 10000;
+  return settings;
+}
+
+SqliteConnectionSafe::SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version,
+                                           SqliteConnectionSettings settings)
     : path_(std::move(path))
-    , lsls_connection_([path = path_, close_state_ptr = &close_state_, key = std::move(key),
-                        cipher_version = std::move(cipher_version)] {
+    , settings_(settings)
+    , lsls_connection_([this, path = path_, key = std::move(key), cipher_version = std::move(cipher_version)] {
       auto r_db = SqliteDb::open_with_key(path, false, key, cipher_version.copy());
       if (r_db.is_error()) {
-        LOG(FATAL) << "Can't open database in state " << close_state_ptr->load() << ": " << r_db.error().message();
+        LOG(FATAL) << "Can't open database in state " << close_state_.load() << ": " << r_db.error().message();
       }
       auto db = r_db.move_as_ok();
-      db.exec("PRAGMA journal_mode=WAL").ensure();
-      db.exec("PRAGMA secure_delete=1").ensure();
+      init_connection(db).ensure();
       return db;
     }) {
 }
 
+Status SqliteConnectionSafe::init_connection(SqliteDb &db) {
+  TRY_STATUS(db.exec("PRAGMA journal_mode=WAL"));
+  TRY_STATUS(db.exec("PRAGMA secure_delete=1"));
+  TRY_STATUS(db.exec(PSLICE() << "PRAGMA cache_size=" << settings_.cache_size));
+  if (settings_.mmap_size != 0) {
+    // ignored by SQLCipher for encrypted databases
+    TRY_STATUS(db.exec(PSLICE() << "PRAGMA mmap_size=" << settings_.mmap_size));
+  }
+  if (settings_.use_memory_temp_store) {
+    TRY_STATUS(db.exec("PRAGMA temp_store=MEMORY"));
+  }
+  if (settings_.journal_size_limit != -1) {
+    TRY_STATUS(db.exec(PSLICE() << "PRAGMA journal_size_limit=" << settings_.journal_size_limit));
+  }
+
+  // replaces the default automatic checkpoint
+  tdsqlite3_wal_hook(db.get_native(), on_wal_commit, this);
+  return Status::OK();
+}
+
+int SqliteConnectionSafe::on_wal_commit(void *connection_ptr, tdsqlite3 *db, const char *db_name, int page_count) {
+  auto connection = static_cast<SqliteConnectionSafe *>(connection_ptr);
+  connection->commit_count_.fetch_add(1);
+  if (connection->has_checkpointer_.load(std::memory_order_acquire) && Scheduler::instance() != nullptr &&
+      !connection->is_checkpointer_armed_.exchange(true)) {
+    send_event_later(connection->checkpointer_, Event::yield());
+  }
+  if (page_count >= connection->settings_.max_wal_page_count) {
+    // WAL file grows too fast to wait for an idle period
+    tdsqlite3_wal_checkpoint(db, db_name);
+  }
+  return SQLITE_OK;
+}
+
+Result<bool> SqliteConnectionSafe::checkpoint_if_idle() {
+  auto commit_count = commit_count_.load();
+  if (commit_count != last_seen_commit_count_) {
+    last_seen_commit_count_ = commit_count;
+    return true;
+  }
+  if (commit_count != last_checkpoint_commit_count_) {
+    last_checkpoint_commit_count_ = commit_count;
+    TRY_STATUS(get().exec("PRAGMA wal_checkpoint(PASSIVE)"));
+  }
+  return false;
+}
+
+void SqliteConnectionSafe::set_checkpointer(ActorId<> checkpointer) {
+  CHECK(!has_checkpointer_.load());
+  checkpointer_ = std::move(checkpointer);
+  has_checkpointer_.store(true, std::memory_order_release);
+}
+
+bool SqliteConnectionSafe::arm_checkpointer() {
+  return !is_checkpointer_armed_.exchange(true);
+}
+
+bool SqliteConnectionSafe::disarm_checkpointer() {
+  is_checkpointer_armed_.store(false);
+  if (commit_count_.load() == last_seen_commit_count_) {
+    return false;
+  }
+  // the commit could have been done before the checkpointer was disarmed and not woken it up
+  return arm_checkpointer();
+}
+
 void SqliteConnectionSafe::set(SqliteDb &&db) {
   lsls_connection_.set(std::move(db));
 }
@@ -9,31 +9,81 @@
 #include "td/db/DbKey.h"
 #include "td/db/SqliteDb.h"
 
+#include "td/actor/actor.h"
 #include "td/actor/SchedulerLocalStorage.h"
 
 #include "td/utils/common.h"
 #include "td/utils/optional.h"
+#include "td/utils/Status.h"
 
 #include <atomic>
 
+struct tdsqlite3;
+
 namespace td {
 
+// applied to all connections to the database
+struct SqliteConnectionSettings {
+  int64 mmap_size = 0;                 // maximum number of bytes of the database accessed through mmap
+  int32 cache_size = -2000;            // maximum number of cached pages; KiB of cached pages if negative
+  bool use_memory_temp_store = false;  // whether temporary tables and indices are kept in memory
+  int32 max_wal_page_count = 1000;     // number of pages in WAL file after which a checkpoint is done on commit
+  int64 journal_size_limit = -1;       // maximum size of WAL file left after a checkpoint; -1 if unlimited
+
+  // small page cache and small WAL file
+  static SqliteConnectionSettings low_memory();
+
+  // big page cache, memory-mapped I/O and rare inline checkpoints
+  static SqliteConnectionSettings high_performance();
+};
+
 class SqliteConnectionSafe {
  public:
   SqliteConnectionSafe() = default;
-  SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version = {});
+  SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version = {},
+                       SqliteConnectionSettings settings = {});
 
   SqliteDb &get();
   void set(SqliteDb &&db);
 
+  // must be called for a connection before it is passed to set
+  Status init_connection(SqliteDb &db) TD_WARN_UNUSED_RESULT;
+
+  // checkpoints WAL file if the database was changed after the last checkpoint, but wasn't changed since the previous
+  // call; returns whether the database was changed since the previous call; must be called from the same scheduler
+  Result<bool> checkpoint_if_idle() TD_WARN_UNUSED_RESULT;
+
+  // the checkpointer is woken up by the first commit after it was disarmed; must be called once
+  void set_checkpointer(ActorId<> checkpointer);
+
+  // returns whether the checkpointer was disarmed and must arm itself
+  bool arm_checkpointer();
+
+  // returns whether the database was changed after the last call to checkpoint_if_idle and the checkpointer must stay
+  // armed, because a commit didn't wake it up
+  bool disarm_checkpointer();
+
+  bool is_checkpointer_armed() const {
+    return is_checkpointer_armed_.load();
+  }
+
   void close();
 
   void close_and_destroy();
 
  private:
   string path_;
+  SqliteConnectionSettings settings_;
   std::atomic<uint32> close_state_{0};
+  std::atomic<uint64> commit_count_{0};
+  uint64 last_seen_commit_count_ = 0;
+  uint64 last_checkpoint_commit_count_ = 0;
+  ActorId<> checkpointer_;
+  std::atomic<bool> has_checkpointer_{false};
+  std::atomic<bool> is_checkpointer_armed_{false};
   LazySchedulerLocalStorage<SqliteDb> lsls_connection_;
+
+  static int on_wal_commit(void *connection_ptr, tdsqlite3 *db, const char *db_name, int page_count);
 };
 
 }  // namespace td
@@ -69,7 +69,10 @@ string db_key_to_sqlcipher_key(const DbKey &db_key) {
 }
 }  // namespace
 
-SqliteDb::~SqliteDb() = default;
+SqliteDb::~SqliteDb() {
+  // statements must be finalized before the database is closed
+  cached_statements_.clear();
+}
 
 Status SqliteDb::init(CSlice path, bool allow_creation) {
   // if database does not exist, delete all other files which could have been left from the old database
@@ -139,42 +142,55 @@ Status SqliteDb::exec(CSlice cmd) {
   return Status::OK();
 }
 
+Status SqliteDb::exec_cached(CSlice cmd) {
+  TRY_RESULT(stmt, get_cached_statement(cmd));
+  auto guard = stmt->guard();
+  do {
+    TRY_STATUS_PREFIX(stmt->step(), PSLICE() << tag("query", cmd) << " failed: ");
+  } while (stmt->can_step());
+  return Status::OK();
+}
+
 Result<bool> SqliteDb::has_table(Slice table) {
-  TRY_RESULT(stmt, get_statement(PSLICE() << "SELECT count(*) FROM sqlite_master WHERE type='table' AND name='" << table
-                                          << "'"));
-  TRY_STATUS(stmt.step());
-  CHECK(stmt.has_row());
-  auto cnt = stmt.view_int32(0);
+  TRY_RESULT(stmt, get_cached_statement("SELECT count(*) FROM sqlite_master WHERE type='table' AND name=?1"));
+  auto guard = stmt->guard();
+  TRY_STATUS(stmt->bind_string(1, table));
+  TRY_STATUS(stmt->step());
+  CHECK(stmt->has_row());
+  auto cnt = stmt->view_int32(0);
   return cnt == 1;
 }
 
 Result<string> SqliteDb::get_pragma(Slice name) {
-  TRY_RESULT(stmt, get_statement(PSLICE() << "PRAGMA " << name));
-  TRY_STATUS(stmt.step());
-  CHECK(stmt.has_row());
-  auto res = stmt.view_blob(0).str();
-  TRY_STATUS(stmt.step());
-  CHECK(!stmt.can_step());
+  TRY_RESULT(stmt, get_cached_statement(PSLICE() << "PRAGMA " << name));
+  auto guard = stmt->guard();
+  TRY_STATUS(stmt->step());
+  CHECK(stmt->has_row());
+  auto res = stmt->view_blob(0).str();
+  TRY_STATUS(stmt->step());
+  CHECK(!stmt->can_step());
   return std::move(res);
 }
 
 Result<string> SqliteDb::get_pragma_string(Slice name) {
-  TRY_RESULT(stmt, get_statement(PSLICE() << "PRAGMA " << name));
-  TRY_STATUS(stmt.step());
-  CHECK(stmt.has_row());
-  auto res = stmt.view_string(0).str();
-  TRY_STATUS(stmt.step());
-  CHECK(!stmt.can_step());
+  TRY_RESULT(stmt, get_cached_statement(PSLICE() << "PRAGMA " << name));
+  auto guard = stmt->guard();
+  TRY_STATUS(stmt->step());
+  CHECK(stmt->has_row());
+  auto res = stmt->view_string(0).str();
+  TRY_STATUS(stmt->step());
+  CHECK(!stmt->can_step());
   return std::move(res);
 }
 
 Result<int32> SqliteDb::user_version() {
-  TRY_RESULT(get_version_stmt, get_statement("PRAGMA user_version"));
-  TRY_STATUS(get_version_stmt.step());
-  if (!get_version_stmt.has_row()) {
+  TRY_RESULT(get_version_stmt, get_cached_statement("PRAGMA user_version"));
+  auto guard = get_version_stmt->guard();
+  TRY_STATUS(get_version_stmt->step());
+  if (!get_version_stmt->has_row()) {
     return Status::Error(PSLICE() << "PRAGMA user_version failed for database \"" << raw_->path() << '"');
   }
-  return get_version_stmt.view_int32(0);
+  return get_version_stmt->view_int32(0);
 }
 
 Status SqliteDb::set_user_version(int32 version) {
@@ -183,14 +199,14 @@ Status SqliteDb::set_user_version(int32 version) {
 
 Status SqliteDb::begin_read_transaction() {
   if (raw_->on_begin()) {
-    return exec("BEGIN");
+    return exec_cached("BEGIN");
   }
   return Status::OK();
 }
 
 Status SqliteDb::begin_write_transaction() {
   if (raw_->on_begin()) {
-    return exec("BEGIN IMMEDIATE");
+    return exec_cached("BEGIN IMMEDIATE");
   }
   return Status::OK();
 }
@@ -198,7 +214,7 @@ Status SqliteDb::begin_write_transaction() {
 Status SqliteDb::commit_transaction() {
   TRY_RESULT(need_commit, raw_->on_commit());
   if (need_commit) {
-    return exec("COMMIT");
+    return exec_cached("COMMIT");
   }
   return Status::OK();
 }
@@ -320,4 +336,35 @@ Result<SqliteStatement> SqliteDb::get_statement(CSlice statement) {
   return SqliteStatement(stmt, raw_);
 }
 
+Result<SqliteStatement *> SqliteDb::get_cached_statement(CSlice statement) {
+  CHECK(!empty());
+  cached_statement_generation_++;
+  for (auto &cached_statement : cached_statements_) {
+    if (cached_statement->sql_ == statement) {
+      cached_statement->last_used_ = cached_statement_generation_;
+      cached_statement->stmt_.reset();
+      return &cached_statement->stmt_;
+    }
+  }
+
+  TRY_RESULT(stmt, get_statement(statement));
+  // statements are stored by pointer to keep returned pointers valid when the vector grows
+  CachedStatement *cached_statement = nullptr;
+  if (cached_statements_.size() < MAX_CACHED_STATEMENTS) {
+    cached_statements_.push_back(make_unique<CachedStatement>());
+    cached_statement = cached_statements_.back().get();
+  } else {
+    cached_statement = cached_statements_[0].get();
+    for (auto &other_statement : cached_statements_) {
+      if (other_statement->last_used_ < cached_statement->last_used_) {
+        cached_statement = other_statement.get();
+      }
+    }
+  }
+  cached_statement->sql_ = statement.str();
+  cached_statement->stmt_ = std::move(stmt);
+  cached_statement->last_used_ = cached_statement_generation_;
+  return &cached_statement->stmt_;
+}
+
 }  // namespace td
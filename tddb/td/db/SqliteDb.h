@@ -70,6 +70,11 @@ class SqliteDb {
 
   Result<SqliteStatement> get_statement(CSlice statement) TD_WARN_UNUSED_RESULT;
 
+  // returns a statement from the LRU cache of prepared statements of the object
+  // the statement must be reset after usage; the pointer stays valid until the database is closed or the statement is
+  // evicted from the cache, which can happen only when another statement is added to the full cache
+  Result<SqliteStatement *> get_cached_statement(CSlice statement) TD_WARN_UNUSED_RESULT;
+
   template <class F>
   static void with_db_path(Slice main_path, F &&f) {
     detail::RawSqliteDb::with_db_path(main_path, f);
@@ -81,9 +86,21 @@ class SqliteDb {
   SqliteDb(std::shared_ptr<detail::RawSqliteDb> raw, bool enable_logging)
       : raw_(std::move(raw)), enable_logging_(enable_logging) {
   }
+  struct CachedStatement {
+    string sql_;
+    SqliteStatement stmt_;
+    uint64 last_used_ = 0;
+  };
+  static constexpr size_t MAX_CACHED_STATEMENTS = 16;
+  // statements must be finalized before the database is closed, so they are declared before raw_ to be replaced first
+  vector<unique_ptr<CachedStatement>> cached_statements_;
+  uint64 cached_statement_generation_ = 0;
+
   std::shared_ptr<detail::RawSqliteDb> raw_;
   bool enable_logging_ = false;
 
+  Status exec_cached(CSlice cmd) TD_WARN_UNUSED_RESULT;
+
   Status init(CSlice path, bool allow_creation) TD_WARN_UNUSED_RESULT;
 
   Status check_encryption();
@@ -62,8 +62,12 @@ void SqliteKeyValue::set(Slice key, Slice value) {
 
 void SqliteKeyValue::set_all(const FlatHashMap<string, string> &key_values) {
   begin_write_transaction().ensure();
-  for (auto &key_value : key_values) {
-    set(key_value.first, key_value.second);
+  auto status = set_stmt_.execute_batch(key_values, [](SqliteStatement &stmt, const auto &key_value) {
+    TRY_STATUS(stmt.bind_blob(1, key_value.first));
+    return stmt.bind_blob(2, key_value.second);
+  });
+  if (status.is_error()) {
+    LOG(FATAL) << "Failed to set " << key_values.size() << " keys: " << status;
   }
   commit_transaction().ensure();
 }
@@ -89,9 +93,11 @@ void SqliteKeyValue::erase(Slice key) {
 }
 
 void SqliteKeyValue::erase_batch(vector<string> keys) {
-  for (auto &key : keys) {
-    erase(key);
-  }
+  erase_stmt_
+      .execute_batch(keys, [](SqliteStatement &stmt, const string &key) {
+        return stmt.bind_blob(1, key);
+      })
+      .ensure();
 }
 
 void SqliteKeyValue::erase_by_prefix(Slice prefix) {
@@ -11,6 +11,7 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
+#include "td/utils/List.h"
 #include "td/utils/optional.h"
 #include "td/utils/Time.h"
 
@@ -18,8 +19,8 @@ namespace td {
 
 class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
  public:
-  explicit SqliteKeyValueAsync(std::shared_ptr<SqliteKeyValueSafe> kv_safe, int32 scheduler_id = -1) {
-    impl_ = create_actor_on_scheduler<Impl>("KV", scheduler_id, std::move(kv_safe));
+  SqliteKeyValueAsync(std::shared_ptr<SqliteKeyValueSafe> kv_safe, int32 scheduler_id, bool is_adaptive) {
+    impl_ = create_actor_on_scheduler<Impl>("KV", scheduler_id, std::move(kv_safe), is_adaptive);
   }
   void set(string key, string value, Promise<Unit> promise) final {
     send_closure_later(impl_, &Impl::set, std::move(key), std::move(value), std::move(promise));
@@ -36,6 +37,9 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
   void get(string key, Promise<string> promise) final {
     send_closure_later(impl_, &Impl::get, std::move(key), std::move(promise));
   }
+  void get_stats(Promise<Stats> promise) final {
+    send_closure_later(impl_, &Impl::get_stats, std::move(promise));
+  }
   void close(Promise<Unit> promise) final {
     send_closure_later(impl_, &Impl::close, std::move(promise));
   }
@@ -43,12 +47,15 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
  private:
   class Impl final : public Actor {
    public:
-    explicit Impl(std::shared_ptr<SqliteKeyValueSafe> kv_safe) : kv_safe_(std::move(kv_safe)) {
+    Impl(std::shared_ptr<SqliteKeyValueSafe> kv_safe, bool is_adaptive)
+        : kv_safe_(std::move(kv_safe)), is_adaptive_(is_adaptive) {
     }
 
     void set(string key, string value, Promise<Unit> promise) {
+      stats_.write_count++;
       auto it = buffer_.find(key);
       if (it != buffer_.end()) {
+        stats_.coalesced_write_count++;
         it->second = std::move(value);
       } else {
         CHECK(!key.empty());
@@ -64,12 +71,19 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
     void set_all(FlatHashMap<string, string> key_values, Promise<Unit> promise) {
       do_flush(true /*force*/);
       kv_->set_all(key_values);
+      stats_.write_count += key_values.size();
+      stats_.commit_count++;
+      for (auto &it : key_values) {
+        update_cache(it.first, it.second);
+      }
       promise.set_value(Unit());
     }
 
     void erase(string key, Promise<Unit> promise) {
+      stats_.write_count++;
       auto it = buffer_.find(key);
       if (it != buffer_.end()) {
+        stats_.coalesced_write_count++;
         it->second = optional<string>();
       } else {
         CHECK(!key.empty());
@@ -85,19 +99,43 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
     void erase_by_prefix(string key_prefix, Promise<Unit> promise) {
       do_flush(true /*force*/);
       kv_->erase_by_prefix(key_prefix);
+      stats_.commit_count++;
+      clear_cache();
       promise.set_value(Unit());
     }
 
     void get(const string &key, Promise<string> promise) {
+      stats_.get_count++;
       auto it = buffer_.find(key);
       if (it != buffer_.end()) {
+        stats_.cache_hit_count++;
         return promise.set_value(it->second ? it->second.value() : "");
       }
-      promise.set_value(kv_->get(key));
+      if (!is_adaptive_) {
+        return promise.set_value(kv_->get(key));
+      }
+
+      auto cache_it = cache_.find(key);
+      if (cache_it != cache_.end()) {
+        stats_.cache_hit_count++;
+        auto *entry = cache_it->second.get();
+        entry->remove();
+        cache_lru_list_.put(entry);
+        return promise.set_value(string(entry->value_));
+      }
+      auto value = kv_->get(key);
+      update_cache(key, value);
+      promise.set_value(std::move(value));
+    }
+
+    void get_stats(Promise<Stats> promise) {
+      stats_.max_pending_write_count = max_pending_count_;
+      promise.set_value(Stats(stats_));
     }
 
     void close(Promise<Unit> promise) {
       do_flush(true /*force*/);
+      clear_cache();
       kv_safe_.reset();
       kv_ = nullptr;
       stop();
@@ -107,12 +145,74 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
    private:
     std::shared_ptr<SqliteKeyValueSafe> kv_safe_;
     SqliteKeyValue *kv_ = nullptr;
+    bool is_adaptive_ = false;
 
     static constexpr double MAX_PENDING_QUERIES_DELAY = 0.01;
-    static constexpr size_t MAX_PENDING_QUERIES_COUNT = 100;
+    static constexpr size_t MIN_PENDING_QUERIES_COUNT = 100;
+    static constexpr size_t MAX_PENDING_QUERIES_COUNT = 10000;
+    static constexpr double MAX_COMMIT_TIME = 0.005;
     FlatHashMap<string, optional<string>> buffer_;
     vector<Promise<Unit>> buffer_promises_;
     size_t cnt_ = 0;
+    size_t max_pending_count_ = MIN_PENDING_QUERIES_COUNT;
+
+    // bounded LRU cache of committed values; an empty value means that the key is absent
+    static constexpr size_t MAX_CACHE_SIZE = 1 << 22;
+    struct CacheEntry final : public ListNode {
+      string key_;
+      string value_;
+    };
+    FlatHashMap<string, unique_ptr<CacheEntry>> cache_;
+    ListNode cache_lru_list_;
+    size_t cache_size_ = 0;
+
+    Stats stats_;
+
+    static size_t get_cache_entry_size(const string &key, const string &value) {
+      return key.size() * 2 + value.size() + sizeof(CacheEntry);
+    }
+
+    void update_cache(const string &key, const string &value) {
+      if (!is_adaptive_) {
+        return;
+      }
+      auto &entry = cache_[key];
+      if (entry == nullptr) {
+        entry = make_unique<CacheEntry>();
+        entry->key_ = key;
+      } else {
+        cache_size_ -= get_cache_entry_size(key, entry->value_);
+        entry->remove();
+      }
+      entry->value_ = value;
+      cache_size_ += get_cache_entry_size(key, value);
+      cache_lru_list_.put(entry.get());
+
+      while (cache_size_ > MAX_CACHE_SIZE) {
+        auto *oldest_entry = static_cast<CacheEntry *>(cache_lru_list_.get());
+        CHECK(oldest_entry != nullptr);
+        cache_size_ -= get_cache_entry_size(oldest_entry->key_, oldest_entry->value_);
+        cache_.erase(oldest_entry->key_);  // destroys the entry
+      }
+    }
+
+    void clear_cache() {
+      cache_.clear();
+      cache_size_ = 0;
+    }
+
+    // batches grow while they are committed fast enough and shrink if commits become slow or the load decreases
+    void update_max_pending_count(bool is_full, double commit_time) {
+      if (commit_time > MAX_COMMIT_TIME) {
+        max_pending_count_ = max(max_pending_count_ / 2, MIN_PENDING_QUERIES_COUNT);
+      } else if (is_full) {
+        if (commit_time < MAX_COMMIT_TIME / 2) {
+          max_pending_count_ = min(max_pending_count_ * 2, MAX_PENDING_QUERIES_COUNT);
+        }
+      } else if (cnt_ < max_pending_count_ / 4) {
+        max_pending_count_ = max(max_pending_count_ / 2, MIN_PENDING_QUERIES_COUNT);
+      }
+    }
 
     double wakeup_at_ = 0;
     void do_flush(bool force) {
@@ -125,15 +225,13 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
         if (wakeup_at_ == 0) {
           wakeup_at_ = now + MAX_PENDING_QUERIES_DELAY;
         }
-        if (now < wakeup_at_ && cnt_ < MAX_PENDING_QUERIES_COUNT) {
+        if (now < wakeup_at_ && cnt_ < max_pending_count_) {
           set_timeout_at(wakeup_at_);
           return;
         }
       }
 
-      wakeup_at_ = 0;
-      cnt_ = 0;
-
+      auto start_time = Time::now();
       kv_->begin_write_transaction().ensure();
       for (auto &it : buffer_) {
         if (it.second) {
@@ -143,6 +241,18 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
         }
       }
       kv_->commit_transaction().ensure();
+      stats_.commit_count++;
+      if (is_adaptive_) {
+        if (!force) {
+          update_max_pending_count(cnt_ >= max_pending_count_, Time::now() - start_time);
+        }
+        for (auto &it : buffer_) {
+          update_cache(it.first, it.second ? it.second.value() : string());
+        }
+      }
+
+      wakeup_at_ = 0;
+      cnt_ = 0;
       buffer_.clear();
       set_promises(buffer_promises_);
     }
@@ -158,9 +268,16 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
   ActorOwn<Impl> impl_;
 };
 
+StringBuilder &operator<<(StringBuilder &string_builder, const SqliteKeyValueAsyncInterface::Stats &stats) {
+  return string_builder << "[writes:" << stats.write_count << " coalesced:" << stats.coalesced_write_count
+                        << " commits:" << stats.commit_count << " gets:" << stats.get_count
+                        << " cache_hits:" << stats.cache_hit_count
+                        << " max_pending_writes:" << stats.max_pending_write_count << ']';
+}
+
 unique_ptr<SqliteKeyValueAsyncInterface> create_sqlite_key_value_async(std::shared_ptr<SqliteKeyValueSafe> kv,
-                                                                       int32 scheduler_id) {
-  return td::make_unique<SqliteKeyValueAsync>(std::move(kv), scheduler_id);
+                                                                       int32 scheduler_id, bool is_adaptive) {
+  return td::make_unique<SqliteKeyValueAsync>(std::move(kv), scheduler_id, is_adaptive);
 }
 
 }  // namespace td
@@ -11,6 +11,7 @@
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/Promise.h"
+#include "td/utils/StringBuilder.h"
 
 #include <memory>
 
@@ -18,6 +19,15 @@ namespace td {
 
 class SqliteKeyValueAsyncInterface {
  public:
+  struct Stats {
+    uint64 write_count = 0;
+    uint64 coalesced_write_count = 0;  // writes, which were overwritten by a later write to the same key before commit
+    uint64 commit_count = 0;
+    uint64 get_count = 0;
+    uint64 cache_hit_count = 0;  // get queries answered without accessing the database
+    size_t max_pending_write_count = 0;
+  };
+
   virtual ~SqliteKeyValueAsyncInterface() = default;
 
   virtual void set(string key, string value, Promise<Unit> promise) = 0;
@@ -30,9 +40,15 @@ class SqliteKeyValueAsyncInterface {
 
   virtual void get(string key, Promise<string> promise) = 0;
 
+  virtual void get_stats(Promise<Stats> promise) = 0;
+
   virtual void close(Promise<Unit> promise) = 0;
 };
 
+StringBuilder &operator<<(StringBuilder &string_builder, const SqliteKeyValueAsyncInterface::Stats &stats);
+
+// if is_adaptive, then the maximum number of pending writes depends on the load and get queries are cached;
+// otherwise, pending writes are committed after 100 writes or 10 milliseconds
 unique_ptr<SqliteKeyValueAsyncInterface> create_sqlite_key_value_async(std::shared_ptr<SqliteKeyValueSafe> kv,
-                                                                       int32 scheduler_id = 1);
+                                                                       int32 scheduler_id, bool is_adaptive = true);
 }  // namespace td
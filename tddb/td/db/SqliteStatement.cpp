@@ -194,6 +194,17 @@ Status SqliteStatement::step() {
   return last_error();
 }
 
+Status SqliteStatement::step_batch_row() {
+  auto rc = tdsqlite3_step(stmt_.get());
+  if (rc != SQLITE_DONE) {
+    auto status = rc == SQLITE_ROW ? Status::Error("Batch statement must not return rows") : last_error();
+    tdsqlite3_reset(stmt_.get());
+    return status;
+  }
+  tdsqlite3_reset(stmt_.get());
+  return Status::OK();
+}
+
 void SqliteStatement::StmtDeleter::operator()(tdsqlite3_stmt *stmt) {
   tdsqlite3_finalize(stmt);
 }
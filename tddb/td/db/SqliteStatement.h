@@ -59,6 +59,18 @@ class SqliteStatement {
 
   void reset();
 
+  // for each row calls bind_row(*this, row) and executes the statement, which must not return rows
+  template <class RowsT, class F>
+  Status execute_batch(const RowsT &rows, F &&bind_row) {
+    reset();
+    auto guard = this->guard();
+    for (auto &row : rows) {
+      TRY_STATUS(bind_row(*this, row));
+      TRY_STATUS(step_batch_row());
+    }
+    return Status::OK();
+  }
+
   auto guard() {
     return ScopeExit{} + [this] {
       this->reset();
@@ -83,6 +95,8 @@ class SqliteStatement {
   std::shared_ptr<detail::RawSqliteDb> db_;
 
   Status last_error();
+
+  Status step_batch_row() TD_WARN_UNUSED_RESULT;
 };
 
 }  // namespace td
@@ -12,15 +12,19 @@
 #include "td/db/binlog/BinlogInterface.h"
 
 #include "td/utils/FlatHashMap.h"
+#include "td/utils/HashTableUtils.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/Random.h"
+#include "td/utils/Slice.h"
 #include "td/utils/StorerBase.h"
 #include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_storers.h"
 
+#include <mutex>
 #include <set>
 
 namespace td {
@@ -478,6 +482,177 @@ unique_ptr<TQueue> TQueue::create() {
   return make_unique<TQueueImpl>();
 }
 
+struct ShardedTQueue::Shard {
+  mutable std::mutex mutex;
+  TQueueImpl queue;
+};
+
+ShardedTQueue::ShardedTQueue(size_t shard_count) {
+  CHECK(shard_count > 0);
+  shards_.reserve(shard_count);
+  for (size_t i = 0; i < shard_count; i++) {
+    shards_.push_back(make_unique<Shard>());
+  }
+}
+
+ShardedTQueue::~ShardedTQueue() = default;
+
+size_t ShardedTQueue::get_shard_id(QueueId queue_id) const {
+  return Hash<QueueId>()(queue_id) % shards_.size();
+}
+
+ShardedTQueue::Shard &ShardedTQueue::get_shard(QueueId queue_id) {
+  return *shards_[get_shard_id(queue_id)];
+}
+
+const ShardedTQueue::Shard &ShardedTQueue::get_shard(QueueId queue_id) const {
+  return *shards_[get_shard_id(queue_id)];
+}
+
+void ShardedTQueue::set_shard_callback(size_t shard_id, unique_ptr<StorageCallback> callback) {
+  CHECK(shard_id < shards_.size());
+  auto &shard = *shards_[shard_id];
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  shard.queue.set_callback(std::move(callback));
+}
+
+unique_ptr<TQueue::StorageCallback> ShardedTQueue::extract_shard_callback(size_t shard_id) {
+  CHECK(shard_id < shards_.size());
+  auto &shard = *shards_[shard_id];
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  return shard.queue.extract_callback();
+}
+
+std::pair<int64, bool> ShardedTQueue::run_shard_gc(size_t shard_id, int32 unix_time_now) {
+  CHECK(shard_id < shards_.size());
+  auto &shard = *shards_[shard_id];
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  return shard.queue.run_gc(unix_time_now);
+}
+
+void ShardedTQueue::set_callback(unique_ptr<StorageCallback> callback) {
+  CHECK(shards_.size() == 1);
+  set_shard_callback(0, std::move(callback));
+}
+
+unique_ptr<TQueue::StorageCallback> ShardedTQueue::extract_callback() {
+  CHECK(shards_.size() == 1);
+  return extract_shard_callback(0);
+}
+
+bool ShardedTQueue::do_push(QueueId queue_id, RawEvent &&raw_event) {
+  auto &shard = get_shard(queue_id);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  return shard.queue.do_push(queue_id, std::move(raw_event));
+}
+
+Result<TQueue::EventId> ShardedTQueue::push(QueueId queue_id, string data, int32 expires_at, int64 extra,
+                                            EventId hint_new_id) {
+  auto &shard = get_shard(queue_id);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  return shard.queue.push(queue_id, std::move(data), expires_at, extra, hint_new_id);
+}
+
+void ShardedTQueue::forget(QueueId queue_id, EventId event_id) {
+  auto &shard = get_shard(queue_id);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  shard.queue.forget(queue_id, event_id);
+}
+
+std::map<TQueue::EventId, TQueue::RawEvent> ShardedTQueue::clear(QueueId queue_id, size_t keep_count) {
+  auto &shard = get_shard(queue_id);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  return shard.queue.clear(queue_id, keep_count);
+}
+
+TQueue::EventId ShardedTQueue::get_head(QueueId queue_id) const {
+  auto &shard = get_shard(queue_id);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  return shard.queue.get_head(queue_id);
+}
+
+TQueue::EventId ShardedTQueue::get_tail(QueueId queue_id) const {
+  auto &shard = get_shard(queue_id);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  return shard.queue.get_tail(queue_id);
+}
+
+Result<size_t> ShardedTQueue::get(QueueId queue_id, EventId from_id, bool forget_previous, int32 unix_time_now,
+                                  MutableSpan<Event> &result_events) {
+  auto &shard = get_shard(queue_id);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto result = shard.queue.get(queue_id, from_id, forget_previous, unix_time_now, result_events);
+  if (result.is_error()) {
+    return result;
+  }
+
+  // the events can be deleted by another thread after the lock is released, so their data is copied
+  static TD_THREAD_LOCAL string *data_buffer;
+  init_thread_local<string>(data_buffer);
+  size_t total_size = 0;
+  for (auto &event : result_events) {
+    total_size += event.data.size();
+  }
+  data_buffer->resize(total_size);
+  size_t offset = 0;
+  for (auto &event : result_events) {
+    auto size = event.data.size();
+    MutableSlice(&(*data_buffer)[offset], size).copy_from(event.data);
+    event.data = Slice(data_buffer->data() + offset, size);
+    offset += size;
+  }
+  return result;
+}
+
+size_t ShardedTQueue::get_size(QueueId queue_id) const {
+  auto &shard = get_shard(queue_id);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  return shard.queue.get_size(queue_id);
+}
+
+std::pair<int64, bool> ShardedTQueue::run_gc(int32 unix_time_now) {
+  int64 deleted_events = 0;
+  auto first_shard_id = next_gc_shard_id_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < shards_.size(); i++) {
+    auto shard_id = (first_shard_id + i) % shards_.size();
+    auto result = run_shard_gc(shard_id, unix_time_now);
+    deleted_events += result.first;
+    if (!result.second) {
+      next_gc_shard_id_ = shard_id;
+      return {deleted_events, false};
+    }
+  }
+  next_gc_shard_id_ = first_shard_id;
+  return {deleted_events, true};
+}
+
+void ShardedTQueue::close(Promise<> promise) {
+  struct CloseState {
+    std::atomic<size_t> left_count;
+    Promise<> promise;
+  };
+  auto state = std::make_shared<CloseState>();
+  state->left_count = shards_.size() + 1;
+  state->promise = std::move(promise);
+  auto on_closed = [state] {
+    if (--state->left_count == 0) {
+      state->promise.set_value(Unit());
+    }
+  };
+  for (auto &shard : shards_) {
+    auto callback = [&] {
+      std::lock_guard<std::mutex> guard(shard->mutex);
+      return shard->queue.extract_callback();
+    }();
+    if (callback == nullptr) {
+      on_closed();
+    } else {
+      callback->close(PromiseCreator::lambda([on_closed](Unit) { on_closed(); }));
+    }
+  }
+  on_closed();
+}
+
 struct TQueueLogEvent final : public Storer {
   int64 queue_id;
   int32 event_id;
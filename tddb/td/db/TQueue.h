@@ -13,6 +13,7 @@
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <utility>
@@ -122,6 +123,66 @@ class TQueue {
 
 StringBuilder &operator<<(StringBuilder &string_builder, TQueue::EventId id);
 
+// thread-safe TQueue, which distributes queues between independent shards, each with its own lock, storage and
+// garbage collection; methods for different queues can be called concurrently,
+// but methods for the same queue must not be called from different threads simultaneously
+// data of events returned by get are valid until the next call to get from the same thread
+// shard storages must be replayed with the same number of shards as the one used to fill them
+class ShardedTQueue final : public TQueue {
+ public:
+  explicit ShardedTQueue(size_t shard_count);
+  ShardedTQueue(const ShardedTQueue &) = delete;
+  ShardedTQueue &operator=(const ShardedTQueue &) = delete;
+  ShardedTQueue(ShardedTQueue &&) = delete;
+  ShardedTQueue &operator=(ShardedTQueue &&) = delete;
+  ~ShardedTQueue() final;
+
+  size_t get_shard_count() const {
+    return shards_.size();
+  }
+
+  size_t get_shard_id(QueueId queue_id) const;
+
+  void set_shard_callback(size_t shard_id, unique_ptr<StorageCallback> callback);
+  unique_ptr<StorageCallback> extract_shard_callback(size_t shard_id);
+
+  // garbage collection of different shards can be run concurrently
+  std::pair<int64, bool> run_shard_gc(size_t shard_id, int32 unix_time_now);
+
+  // can be used only if there is exactly one shard
+  void set_callback(unique_ptr<StorageCallback> callback) final;
+  unique_ptr<StorageCallback> extract_callback() final;
+
+  bool do_push(QueueId queue_id, RawEvent &&raw_event) final;
+
+  Result<EventId> push(QueueId queue_id, string data, int32 expires_at, int64 extra, EventId hint_new_id) final;
+
+  void forget(QueueId queue_id, EventId event_id) final;
+
+  std::map<EventId, RawEvent> clear(QueueId queue_id, size_t keep_count) final;
+
+  EventId get_head(QueueId queue_id) const final;
+  EventId get_tail(QueueId queue_id) const final;
+
+  Result<size_t> get(QueueId queue_id, EventId from_id, bool forget_previous, int32 unix_time_now,
+                     MutableSpan<Event> &result_events) final;
+
+  size_t get_size(QueueId queue_id) const final;
+
+  // runs garbage collection of the shards one by one, resuming from the shard on which the previous call was stopped
+  std::pair<int64, bool> run_gc(int32 unix_time_now) final;
+
+  void close(Promise<> promise) final;
+
+ private:
+  struct Shard;
+  vector<unique_ptr<Shard>> shards_;
+  std::atomic<size_t> next_gc_shard_id_{0};
+
+  Shard &get_shard(QueueId queue_id);
+  const Shard &get_shard(QueueId queue_id) const;
+};
+
 struct BinlogEvent;
 
 template <class BinlogT>
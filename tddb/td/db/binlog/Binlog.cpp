@@ -18,6 +18,7 @@
 #include "td/utils/port/PollFlags.h"
 #include "td/utils/port/sleep.h"
 #include "td/utils/port/Stat.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
@@ -26,6 +27,10 @@
 #include "td/utils/tl_helpers.h"
 #include "td/utils/tl_parsers.h"
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
 namespace td {
 namespace detail {
 struct AesCtrEncryptionEvent {
@@ -138,10 +143,10 @@ class BinlogReader {
       return size_;
     }
 
+    // the event must be validated by the caller
     event->debug_info_ = BinlogDebugInfo{__FILE__, __LINE__};
     auto buffer_slice = input_->cut_head(size_).move_as_buffer_slice();
     event->init(buffer_slice.as_slice().str());
-    TRY_STATUS(event->validate());
     offset_ += size_;
     event->offset_ = offset_;
     state_ = State::ReadLength;
@@ -158,6 +163,304 @@ class BinlogReader {
   bool is_encrypted_{false};
 };
 
+// rereads events, which were already written to a binlog file;
+// pread moves the file position on Windows, so it must be restored before anything is appended to the file
+class BinlogEventReader {
+ public:
+  BinlogEventReader(const FileFd &fd, bool is_encrypted, const UInt256 &key, const UInt128 &iv, int64 encrypted_from)
+      : fd_(&fd), is_encrypted_(is_encrypted), key_(key), iv_(iv), encrypted_from_(encrypted_from) {
+  }
+
+  Slice read_raw_event(const BinlogEventsProcessor::EventInfo &event_info) {
+    auto begin = event_info.offset_ - static_cast<int64>(event_info.size_);
+    CHECK(begin >= 0);
+    if (begin < window_begin_ || event_info.offset_ > window_begin_ + static_cast<int64>(window_.size())) {
+      load_window(begin, event_info.size_);
+    }
+    return Slice(window_).substr(static_cast<size_t>(begin - window_begin_), event_info.size_);
+  }
+
+  // the event isn't validated, because it was already validated when it was read or written for the first time
+  BinlogEvent read_event(const BinlogEventsProcessor::EventInfo &event_info) {
+    BinlogEvent event;
+    event.init(read_raw_event(event_info).str());
+    event.offset_ = event_info.offset_;
+    event.flags_ &= ~(BinlogEvent::Flags::Rewrite | BinlogEvent::Flags::Partial);
+    return event;
+  }
+
+ private:
+  static constexpr size_t MIN_WINDOW_SIZE = 1 << 16;
+
+  const FileFd *fd_;
+  bool is_encrypted_;
+  UInt256 key_;
+  UInt128 iv_;
+  int64 encrypted_from_;
+  string window_;
+  int64 window_begin_{0};
+
+  void load_window(int64 begin, size_t min_size) {
+    window_.resize(max(min_size, MIN_WINDOW_SIZE));
+    size_t read_size = 0;
+    while (read_size < window_.size()) {
+      auto r_size = fd_->pread(MutableSlice(window_).substr(read_size), begin + static_cast<int64>(read_size));
+      LOG_IF(FATAL, r_size.is_error()) << "Failed to reread binlog: " << r_size.error();
+      if (r_size.ok() == 0) {
+        break;
+      }
+      read_size += r_size.ok();
+    }
+    LOG_CHECK(read_size >= min_size) << begin << ' ' << min_size << ' ' << read_size;
+    window_.resize(read_size);
+    window_begin_ = begin;
+
+    auto end = begin + static_cast<int64>(read_size);
+    if (!is_encrypted_ || end <= encrypted_from_) {
+      return;
+    }
+    auto encrypted_begin = max(begin, encrypted_from_);
+    auto position = static_cast<uint64>(encrypted_begin - encrypted_from_);
+
+    // AES-CTR counter is a big-endian 128-bit number, which is incremented for every 16 bytes
+    UInt128 counter = iv_;
+    auto carry = position / 16;
+    for (int i = 15; i >= 0 && carry != 0; i--) {
+      carry += counter.raw[i];
+      counter.raw[i] = static_cast<unsigned char>(carry & 255);
+      carry >>= 8;
+    }
+    AesCtrState aes_ctr_state;
+    aes_ctr_state.init(as_slice(key_), as_slice(counter));
+    auto skipped_size = static_cast<size_t>(position % 16);
+    if (skipped_size != 0) {
+      char skipped[16];
+      aes_ctr_state.decrypt(Slice(skipped, skipped_size), MutableSlice(skipped, skipped_size));
+    }
+    auto data = MutableSlice(window_).substr(static_cast<size_t>(encrypted_begin - begin));
+    aes_ctr_state.decrypt(data, data);
+  }
+};
+
+#if !TD_THREAD_UNSUPPORTED
+// writes live events of the binlog to a new file in a separate thread;
+// events added after the snapshot was taken are written by finish() in the caller thread
+class BinlogReindexWriter {
+ public:
+  BinlogReindexWriter(FileFd fd, BinlogEventReader event_reader, vector<BinlogEventsProcessor::EventInfo> snapshot,
+                      int64 snapshot_offset, string encryption_event, Slice key, const UInt128 &iv)
+      : fd_(std::move(fd))
+      , event_reader_(std::move(event_reader))
+      , snapshot_(std::move(snapshot))
+      , snapshot_offset_(snapshot_offset)
+      , encryption_event_(std::move(encryption_event))
+      , iv_(iv) {
+    if (!encryption_event_.empty()) {
+      aes_ctr_state_.init(key, as_slice(iv_));
+      events_count_++;
+    }
+    size_ = static_cast<int64>(encryption_event_.size());
+    for (auto &event_info : snapshot_) {
+      size_ += static_cast<int64>(event_info.size_);
+    }
+    events_count_ += snapshot_.size();
+    new_events_offset_ = size_;
+    snapshot_new_offset_ = get_encrypted_from();
+  }
+  BinlogReindexWriter(const BinlogReindexWriter &) = delete;
+  BinlogReindexWriter &operator=(const BinlogReindexWriter &) = delete;
+  BinlogReindexWriter(BinlogReindexWriter &&) = delete;
+  BinlogReindexWriter &operator=(BinlogReindexWriter &&) = delete;
+  ~BinlogReindexWriter() {
+    is_cancelled_.store(true, std::memory_order_relaxed);
+    thread_.join();
+  }
+
+  void start(bool need_sync) {
+    need_sync_ = need_sync;
+    thread_ = td::thread([this] {
+      status_ = write_snapshot();
+      is_finished_.store(true, std::memory_order_release);
+    });
+  }
+
+  bool is_finished() const {
+    return is_finished_.load(std::memory_order_acquire);
+  }
+
+  void add_event(Slice raw_event) {
+    new_events_.append(raw_event.begin(), raw_event.size());
+    size_ += static_cast<int64>(raw_event.size());
+    events_count_++;
+  }
+
+  Status finish() {
+    CHECK(is_finished());
+    thread_.join();
+    TRY_STATUS(std::move(status_));
+    buffer_ = std::move(new_events_);
+    TRY_STATUS(flush_buffer());
+    if (need_sync_) {
+      TRY_STATUS(fd_.sync_barrier());
+    }
+    return Status::OK();
+  }
+
+  // must be called for all live events in the order of their identifiers
+  int64 get_new_offset(int64 old_offset) {
+    if (old_offset > snapshot_offset_) {
+      // the event was added after the snapshot was taken
+      return new_events_offset_ + (old_offset - snapshot_offset_);
+    }
+    while (true) {
+      CHECK(snapshot_pos_ < snapshot_.size());
+      auto &event_info = snapshot_[snapshot_pos_++];
+      snapshot_new_offset_ += static_cast<int64>(event_info.size_);
+      if (event_info.offset_ == old_offset) {
+        return snapshot_new_offset_;
+      }
+    }
+  }
+
+  // appends pending data to the old binlog file, from which events are concurrently reread by the writing thread;
+  // pread moves the file position on Windows, so the position is restored before the append
+  Result<size_t> flush_old_fd(BufferedFdBase<FileFd> &old_fd) {
+    std::lock_guard<std::mutex> guard(old_fd_mutex_);
+    TRY_RESULT(old_fd_size, old_fd.get_size());
+    TRY_STATUS(old_fd.seek(old_fd_size));
+    return old_fd.flush_write();
+  }
+
+  FileFd move_fd() {
+    return std::move(fd_);
+  }
+
+  AesCtrState move_aes_ctr_state() {
+    return std::move(aes_ctr_state_);
+  }
+
+  const UInt128 &get_iv() const {
+    return iv_;
+  }
+
+  int64 get_encrypted_from() const {
+    return static_cast<int64>(encryption_event_.size());
+  }
+
+  int64 get_size() const {
+    return size_;
+  }
+
+  uint64 get_events_count() const {
+    return events_count_;
+  }
+
+ private:
+  static constexpr size_t MAX_BUFFER_SIZE = 1 << 20;
+
+  FileFd fd_;
+  BinlogEventReader event_reader_;
+  std::mutex old_fd_mutex_;
+  vector<BinlogEventsProcessor::EventInfo> snapshot_;
+  int64 snapshot_offset_;
+  string encryption_event_;
+  UInt128 iv_;
+  string new_events_;
+  string buffer_;
+  AesCtrState aes_ctr_state_;
+  bool is_encrypted_ = false;
+  bool need_sync_ = false;
+  int64 size_{0};
+  uint64 events_count_{0};
+  int64 new_events_offset_{0};
+  size_t snapshot_pos_{0};
+  int64 snapshot_new_offset_{0};
+  Status status_;
+  std::atomic<bool> is_finished_{false};
+  std::atomic<bool> is_cancelled_{false};
+  td::thread thread_;
+
+  Status write_snapshot() {
+    if (!encryption_event_.empty()) {
+      // the encryption event itself isn't encrypted
+      buffer_ = encryption_event_;
+      TRY_STATUS(flush_buffer());
+      is_encrypted_ = true;
+    }
+    for (auto &event_info : snapshot_) {
+      if (is_cancelled_.load(std::memory_order_relaxed)) {
+        return Status::Error("Binlog reindex was cancelled");
+      }
+      {
+        std::lock_guard<std::mutex> guard(old_fd_mutex_);
+        auto raw_event = event_reader_.read_raw_event(event_info);
+        buffer_.append(raw_event.begin(), raw_event.size());
+      }
+      if (buffer_.size() >= MAX_BUFFER_SIZE) {
+        TRY_STATUS(flush_buffer());
+      }
+    }
+    TRY_STATUS(flush_buffer());
+    if (need_sync_) {
+      TRY_STATUS(fd_.sync_barrier());
+    }
+    return Status::OK();
+  }
+
+  Status flush_buffer() {
+    if (is_encrypted_) {
+      aes_ctr_state_.encrypt(buffer_, MutableSlice(buffer_));
+    }
+    Slice data = buffer_;
+    while (!data.empty()) {
+      TRY_RESULT(written, fd_.write(data));
+      data.remove_prefix(written);
+    }
+    buffer_.clear();
+    return Status::OK();
+  }
+};
+#endif
+
+// validates the events, possibly in parallel; returns the number of events before the first invalid event
+static size_t validate_events(const vector<BinlogEvent> &events, size_t events_size, Status &error) {
+  size_t thread_count = 1;
+#if !TD_THREAD_UNSUPPORTED
+  constexpr size_t MIN_THREAD_VALIDATION_SIZE = 1 << 18;
+  thread_count = clamp(static_cast<size_t>(thread::hardware_concurrency()), static_cast<size_t>(1),
+                       min(static_cast<size_t>(4), events_size / MIN_THREAD_VALIDATION_SIZE + 1));
+#endif
+  vector<size_t> first_invalid(thread_count, events.size());
+  auto validate_part = [&](size_t part) {
+    auto begin = events.size() * part / thread_count;
+    auto end = events.size() * (part + 1) / thread_count;
+    for (auto i = begin; i < end; i++) {
+      if (events[i].validate().is_error()) {
+        first_invalid[part] = i;
+        break;
+      }
+    }
+  };
+#if !TD_THREAD_UNSUPPORTED
+  vector<td::thread> threads;
+  for (size_t part = 1; part < thread_count; part++) {
+    threads.emplace_back(validate_part, part);
+  }
+  validate_part(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+#else
+  validate_part(0);
+#endif
+
+  auto result = *std::min_element(first_invalid.begin(), first_invalid.end());
+  if (result < events.size()) {
+    error = events[result].validate();
+  }
+  return result;
+}
+
 static int64 file_size(CSlice path) {
   auto r_stat = stat(path);
   if (r_stat.is_error()) {
@@ -237,8 +540,9 @@ void Binlog::add_event(BinlogEvent &&event) {
     events_buffer_->add_event(std::move(event));
   }
   lazy_flush();
+  try_finish_background_reindex();
 
-  if (state_ == State::Run) {
+  if (state_ == State::Run && reindex_writer_ == nullptr) {
     auto fd_size = fd_size_;
     if (events_buffer_) {
       fd_size += events_buffer_->size();
@@ -249,7 +553,7 @@ void Binlog::add_event(BinlogEvent &&event) {
     if (need_reindex(50000, 5) || need_reindex(100000, 4) || need_reindex(300000, 3) || need_reindex(500000, 2)) {
       LOG(INFO) << tag("fd_size", format::as_size(fd_size))
                 << tag("total events size", format::as_size(processor_->total_raw_events_size()));
-      do_reindex();
+      start_background_reindex();
     }
   }
 }
@@ -285,6 +589,7 @@ Status Binlog::close(bool need_sync) {
   if (fd_.empty()) {
     return Status::OK();
   }
+  cancel_background_reindex();
   if (need_sync) {
     sync("close");
   } else {
@@ -335,6 +640,10 @@ void Binlog::do_event(BinlogEvent &&event) {
     VLOG(binlog) << "Write binlog event: " << format::cond(state_ == State::Reindex, "[reindex] ")
                  << event.public_to_string();
     buffer_writer_.append(as_slice(event.raw_event_));
+    if (reindex_writer_ != nullptr) {
+      // the event must be written also to the binlog being regenerated
+      reindex_writer_->add_event(event.raw_event_);
+    }
   }
 
   if (event.type_ < 0) {
@@ -367,6 +676,7 @@ void Binlog::do_event(BinlogEvent &&event) {
 
       aes_ctr_key_salt_ = encryption_event.key_salt_;
       update_encryption(key, encryption_event.iv_);
+      aes_ctr_offset_ = fd_size_ + static_cast<int64>(event_size);
 
       if (state_ == State::Load) {
         update_read_encryption();
@@ -381,6 +691,9 @@ void Binlog::do_event(BinlogEvent &&event) {
   }
 
   if (state_ != State::Reindex) {
+    if (state_ == State::Run) {
+      event.offset_ = fd_size_ + static_cast<int64>(event_size);
+    }
     auto status = processor_->add_event(std::move(event));
     if (status.is_error()) {
       auto old_size = detail::file_size(path_);
@@ -408,7 +721,7 @@ void Binlog::sync(const char *source) {
   flush(source);
   if (need_sync_) {
     LOG(INFO) << "Sync binlog from " << source;
-    auto status = fd_.sync();
+    auto status = fd_.sync_data();
     LOG_IF(FATAL, status.is_error()) << "Failed to sync binlog: " << status;
     need_sync_ = false;
   }
@@ -419,12 +732,20 @@ void Binlog::flush(const char *source) {
     return;
   }
   LOG(DEBUG) << "Flush binlog from " << source;
+  try_finish_background_reindex();
   flush_events_buffer(true);
   // NB: encryption happens during flush
   if (byte_flow_flag_) {
     byte_flow_source_.wakeup();
   }
-  auto r_written = fd_.flush_write();
+  auto r_written = [&] {
+#if !TD_THREAD_UNSUPPORTED
+    if (reindex_writer_ != nullptr) {
+      return reindex_writer_->flush_old_fd(fd_);
+    }
+#endif
+    return fd_.flush_write();
+  }();
   r_written.ensure();
   auto written = r_written.ok();
   if (written > 0) {
@@ -514,10 +835,38 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
 
   fd_.get_poll_info().add_flags(PollFlags::Read());
   info_.wrong_password = false;
+  // events are read in big chunks and are validated in batches in parallel
+  constexpr size_t READ_AHEAD_SIZE = 1 << 20;
+  constexpr size_t MAX_EVENTS_BATCH_SIZE = 1 << 22;
+  vector<BinlogEvent> events;
+  size_t events_size = 0;
+  auto process_events = [&] {
+    Status error;
+    auto valid_event_count = detail::validate_events(events, events_size, error);
+    size_t processed_event_count = 0;
+    while (processed_event_count < valid_event_count && !info_.wrong_password) {
+      auto &event = events[processed_event_count++];
+      if (debug_callback) {
+        debug_callback(event);
+      }
+      do_add_event(std::move(event));
+    }
+    bool is_valid = processed_event_count == events.size();
+    if (valid_event_count < events.size() && !info_.wrong_password) {
+      LOG(ERROR) << error;
+    }
+    events.clear();
+    events_size = 0;
+    return is_valid;
+  };
+
   while (true) {
     BinlogEvent event;
     auto r_need_size = reader.read_next(&event);
     if (r_need_size.is_error()) {
+      if (!process_events()) {
+        break;
+      }
       if (r_need_size.error().code() == -2) {
         auto old_size = detail::file_size(path_);
         auto offset = reader.offset();
@@ -536,15 +885,15 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
     auto need_size = r_need_size.move_as_ok();
     // LOG(ERROR) << "Need size = " << need_size;
     if (need_size == 0) {
-      if (debug_callback) {
-        debug_callback(event);
-      }
-      do_add_event(std::move(event));
-      if (info_.wrong_password) {
-        return Status::OK();
+      // encryption event changes decryption of the following events, so it must be processed immediately
+      bool need_process = event.type_ == BinlogEvent::ServiceTypes::AesCtrEncryption;
+      events_size += event.raw_event_.size();
+      events.push_back(std::move(event));
+      if ((need_process || events_size >= MAX_EVENTS_BATCH_SIZE) && !process_events()) {
+        break;
       }
     } else {
-      TRY_STATUS(fd_.flush_read(max(need_size, static_cast<size_t>(4096))));
+      TRY_STATUS(fd_.flush_read(max(need_size, READ_AHEAD_SIZE)));
       buffer_reader_.sync_with_writer();
       if (byte_flow_flag_) {
         byte_flow_source_.wakeup();
@@ -554,20 +903,31 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
       }
     }
   }
+  if (!events.empty()) {
+    process_events();
+  }
+  if (info_.wrong_password) {
+    return Status::OK();
+  }
 
   auto offset = processor_->offset();
   CHECK(offset >= 0);
-  processor_->for_each([&](BinlogEvent &event) {
-    VLOG(binlog) << "Replay binlog event: " << event.public_to_string();
-    if (callback) {
+  if (callback) {
+    detail::BinlogEventReader event_reader(fd_, encryption_type_ == EncryptionType::AesCtr, aes_ctr_key_, aes_ctr_iv_,
+                                           aes_ctr_offset_);
+    processor_->for_each([&](const detail::BinlogEventsProcessor::EventInfo &event_info) {
+      auto event = event_reader.read_event(event_info);
+      VLOG(binlog) << "Replay binlog event: " << event.public_to_string();
       callback(event);
-    }
-  });
+    });
+  }
 
   TRY_RESULT(fd_size, fd_.get_size());
+  // events were reread using pread, which moves the file position on Windows, so new events must be appended to
+  // the explicitly set position
+  fd_.seek(offset).ensure();
   if (offset != fd_size) {
     LOG(ERROR) << "Truncate " << tag("path", path_) << tag("old_size", fd_size) << tag("new_size", offset);
-    fd_.seek(offset).ensure();
     fd_.truncate_to_current_position(offset).ensure();
     db_key_used_ = false;  // force reindex
   }
@@ -589,9 +949,8 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
 
 void Binlog::update_encryption(Slice key, Slice iv) {
   as_mutable_slice(aes_ctr_key_).copy_from(key);
-  UInt128 aes_ctr_iv;
-  as_mutable_slice(aes_ctr_iv).copy_from(iv);
-  aes_ctr_state_.init(as_slice(aes_ctr_key_), as_slice(aes_ctr_iv));
+  as_mutable_slice(aes_ctr_iv_).copy_from(iv);
+  aes_ctr_state_.init(as_slice(aes_ctr_key_), as_slice(aes_ctr_iv_));
 }
 
 void Binlog::reset_encryption() {
@@ -627,6 +986,7 @@ void Binlog::reset_encryption() {
 }
 
 void Binlog::do_reindex() {
+  cancel_background_reindex();
   flush_events_buffer(true);
   // start reindex
   CHECK(state_ == State::Run);
@@ -641,13 +1001,18 @@ void Binlog::do_reindex() {
 
   string new_path = path_ + ".new";
 
-  auto r_opened_file = open_binlog(new_path, FileFd::Flags::Write | FileFd::Flags::Create | FileFd::Truncate);
+  // the new file must be readable, because events are reread from it during the next reindex
+  auto r_opened_file =
+      open_binlog(new_path, FileFd::Flags::Read | FileFd::Flags::Write | FileFd::Flags::Create | FileFd::Truncate);
   if (r_opened_file.is_error()) {
     LOG(ERROR) << "Can't open new binlog for regenerate: " << r_opened_file.error();
     return;
   }
+  flush("start_reindex");  // all events must be written to the old file to be reread from it
   auto old_fd = std::move(fd_);  // can't close fd_ now, because it will release file lock
   fd_ = BufferedFdBase<FileFd>(r_opened_file.move_as_ok());
+  detail::BinlogEventReader event_reader(old_fd, encryption_type_ == EncryptionType::AesCtr, aes_ctr_key_,
+                                         aes_ctr_iv_, aes_ctr_offset_);
 
   buffer_writer_ = ChainBufferWriter();
   buffer_reader_ = buffer_writer_.extract_reader();
@@ -658,8 +1023,9 @@ void Binlog::do_reindex() {
   fd_size_ = 0;
   fd_events_ = 0;
   reset_encryption();
-  processor_->for_each([&](BinlogEvent &event) {
-    do_event(std::move(event));  // NB: no move is actually happens
+  processor_->for_each([&](detail::BinlogEventsProcessor::EventInfo &event_info) {
+    do_event(event_reader.read_event(event_info));
+    event_info.offset_ = fd_size_;
   });
   {
     flush("do_reindex");
@@ -670,7 +1036,20 @@ void Binlog::do_reindex() {
     need_sync_ = false;
   }
 
-  // finish_reindex
+  finish_reindex(std::move(old_fd), new_path, start_time, start_size, start_events);
+
+  buffer_writer_ = ChainBufferWriter();
+  buffer_reader_ = buffer_writer_.extract_reader();
+
+  // reuse aes_ctr_state_
+  if (encryption_type_ == EncryptionType::AesCtr) {
+    aes_ctr_state_ = aes_xcode_byte_flow_.move_aes_ctr_state();
+  }
+  update_write_encryption();
+}
+
+void Binlog::finish_reindex(BufferedFdBase<FileFd> old_fd, const string &new_path, double start_time,
+                            int64 start_size, uint64 start_events) {
   auto status = unlink(path_);
   LOG_IF(FATAL, status.is_error()) << "Failed to unlink old binlog: " << status;
   old_fd.close();  // now we can close old file and release the system lock
@@ -707,15 +1086,115 @@ void Binlog::do_reindex() {
   }(PSLICE() << "Regenerate index " << tag("name", path_) << tag("time", format::as_time(finish_time - start_time))
              << tag("before_size", format::as_size(start_size)) << tag("after_size", format::as_size(finish_size))
              << tag("ratio", ratio) << tag("before_events", start_events) << tag("after_events", finish_events));
+}
+
+void Binlog::start_background_reindex() {
+#if TD_THREAD_UNSUPPORTED
+  do_reindex();
+#else
+  flush_events_buffer(true);
+  CHECK(state_ == State::Run);
+  CHECK(reindex_writer_ == nullptr);
+  if (db_key_.is_empty() != (encryption_type_ == EncryptionType::None) ||
+      (encryption_type_ == EncryptionType::AesCtr && aes_ctr_key_salt_.empty())) {
+    // encryption must be changed synchronously
+    do_reindex();
+    return;
+  }
+
+  string new_path = path_ + ".new";
+  auto r_opened_file =
+      open_binlog(new_path, FileFd::Flags::Read | FileFd::Flags::Write | FileFd::Flags::Create | FileFd::Truncate);
+  if (r_opened_file.is_error()) {
+    LOG(ERROR) << "Can't open new binlog for regenerate: " << r_opened_file.error();
+    return;
+  }
+
+  // the new file uses the same key, but a new IV
+  string encryption_event;
+  UInt128 iv;
+  if (encryption_type_ == EncryptionType::AesCtr) {
+    using EncryptionEvent = detail::AesCtrEncryptionEvent;
+    EncryptionEvent event;
+    event.key_salt_ = aes_ctr_key_salt_;
+    event.iv_.resize(EncryptionEvent::iv_size());
+    Random::secure_bytes(event.iv_);
+    event.key_hash_ = EncryptionEvent::generate_hash(as_slice(aes_ctr_key_));
+    as_mutable_slice(iv).copy_from(event.iv_);
+    encryption_event =
+        BinlogEvent::create_raw(0, BinlogEvent::ServiceTypes::AesCtrEncryption, 0, create_default_storer(event))
+            .as_slice()
+            .str();
+  }
+
+  // the snapshot contains only locations of the events, which are reread from the old file in the writing thread
+  flush("start_background_reindex");
+  vector<detail::BinlogEventsProcessor::EventInfo> snapshot;
+  processor_->for_each(
+      [&](const detail::BinlogEventsProcessor::EventInfo &event_info) { snapshot.push_back(event_info); });
+  detail::BinlogEventReader event_reader(fd_, encryption_type_ == EncryptionType::AesCtr, aes_ctr_key_, aes_ctr_iv_,
+                                         aes_ctr_offset_);
+
+  reindex_start_time_ = Clocks::monotonic();
+  reindex_start_size_ = detail::file_size(path_);
+  reindex_start_events_ = fd_events_;
+  reindex_writer_ = td::make_unique<detail::BinlogReindexWriter>(
+      r_opened_file.move_as_ok(), std::move(event_reader), std::move(snapshot), fd_size_, std::move(encryption_event),
+      as_slice(aes_ctr_key_), iv);
+  reindex_writer_->start(reindex_start_size_ != 0);
+#endif
+}
+
+void Binlog::try_finish_background_reindex() {
+#if !TD_THREAD_UNSUPPORTED
+  if (reindex_writer_ == nullptr || !reindex_writer_->is_finished()) {
+    return;
+  }
+  auto reindex_writer = std::move(reindex_writer_);
+  CHECK(state_ == State::Run);
+
+  string new_path = path_ + ".new";
+  auto status = reindex_writer->finish();
+  if (status.is_error()) {
+    LOG(ERROR) << "Failed to regenerate binlog: " << status;
+    unlink(new_path).ignore();
+    reindex_writer = nullptr;
+    FileFd::remove_local_lock(new_path);
+    return;
+  }
+
+  // all events are already written to the new file, so unflushed data of the old file can be dropped
+  auto old_fd = std::move(fd_);  // can't close fd_ now, because it will release file lock
+  fd_ = BufferedFdBase<FileFd>(reindex_writer->move_fd());
+  fd_size_ = reindex_writer->get_size();
+  fd_events_ = reindex_writer->get_events_count();
+  processor_->for_each([&](detail::BinlogEventsProcessor::EventInfo &event_info) {
+    event_info.offset_ = reindex_writer->get_new_offset(event_info.offset_);
+  });
+  need_sync_ = false;
+  need_flush_since_ = 0;
+
+  finish_reindex(std::move(old_fd), new_path, reindex_start_time_, reindex_start_size_, reindex_start_events_);
 
   buffer_writer_ = ChainBufferWriter();
   buffer_reader_ = buffer_writer_.extract_reader();
-
-  // reuse aes_ctr_state_
   if (encryption_type_ == EncryptionType::AesCtr) {
-    aes_ctr_state_ = aes_xcode_byte_flow_.move_aes_ctr_state();
+    aes_ctr_iv_ = reindex_writer->get_iv();
+    aes_ctr_offset_ = reindex_writer->get_encrypted_from();
+    aes_ctr_state_ = reindex_writer->move_aes_ctr_state();
   }
   update_write_encryption();
+#endif
+}
+
+void Binlog::cancel_background_reindex() {
+  if (reindex_writer_ == nullptr) {
+    return;
+  }
+  string new_path = path_ + ".new";
+  unlink(new_path).ignore();
+  reindex_writer_ = nullptr;  // waits for the writing thread and closes the file
+  FileFd::remove_local_lock(new_path);
 }
 
 string Binlog::debug_get_binlog_data(int64 begin_offset, int64 end_offset) {
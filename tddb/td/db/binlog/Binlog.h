@@ -41,6 +41,7 @@ namespace detail {
 class BinlogReader;
 class BinlogEventsProcessor;
 class BinlogEventsBuffer;
+class BinlogReindexWriter;
 }  // namespace detail
 
 class Binlog {
@@ -145,6 +146,8 @@ class Binlog {
   // AesCtrEncryption
   string aes_ctr_key_salt_;
   UInt256 aes_ctr_key_;
+  UInt128 aes_ctr_iv_;
+  int64 aes_ctr_offset_{0};  // offset in the binlog file, from which encryption with aes_ctr_iv_ starts
   AesCtrState aes_ctr_state_;
 
   bool byte_flow_flag_ = false;
@@ -163,6 +166,10 @@ class Binlog {
   double need_flush_since_ = 0;
   double next_buffer_flush_time_ = 0;
   bool need_sync_{false};
+  unique_ptr<detail::BinlogReindexWriter> reindex_writer_;
+  double reindex_start_time_ = 0;
+  int64 reindex_start_size_{0};
+  uint64 reindex_start_events_{0};
   enum class State { Empty, Load, Reindex, Run } state_{State::Empty};
 
   static Result<FileFd> open_binlog(const string &path, int32 flags);
@@ -171,6 +178,12 @@ class Binlog {
   void do_event(BinlogEvent &&event);
   Status load_binlog(const Callback &callback, const Callback &debug_callback = Callback()) TD_WARN_UNUSED_RESULT;
   void do_reindex();
+  void finish_reindex(BufferedFdBase<FileFd> old_fd, const string &new_path, double start_time, int64 start_size,
+                      uint64 start_events);
+
+  void start_background_reindex();
+  void try_finish_background_reindex();
+  void cancel_background_reindex();
 
   void update_encryption(Slice key, Slice iv);
   void reset_encryption();
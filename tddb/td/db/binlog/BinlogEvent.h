@@ -75,11 +75,12 @@ struct BinlogEvent {
     return raw_event_.empty();
   }
 
+  // the event isn't validated again, because it must have been validated when it was read or created
   BinlogEvent clone() const {
     BinlogEvent result;
     result.debug_info_ = BinlogDebugInfo{__FILE__, __LINE__};
     result.init(raw_event_);
-    result.validate().ensure();
+    result.offset_ = offset_;
     return result;
   }
 
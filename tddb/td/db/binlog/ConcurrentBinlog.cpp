@@ -82,6 +82,14 @@ class BinlogActor final : public Actor {
     promise.set_value(Unit());
   }
 
+  void set_sync_options(ConcurrentBinlog::SyncOptions options) {
+    sync_options_ = options;
+  }
+
+  void get_sync_stats(Promise<ConcurrentBinlog::SyncStats> promise) {
+    promise.set_value(ConcurrentBinlog::SyncStats(sync_stats_));
+  }
+
  private:
   unique_ptr<Binlog> binlog_;
 
@@ -89,11 +97,15 @@ class BinlogActor final : public Actor {
 
   std::multimap<uint64, Promise<>> immediate_sync_promises_;
   std::vector<Promise<>> sync_promises_;
+  size_t force_sync_request_count_ = 0;
   bool force_sync_flag_ = false;
   bool lazy_sync_flag_ = false;
   bool flush_flag_ = false;
   double wakeup_at_ = 0;
 
+  ConcurrentBinlog::SyncOptions sync_options_;
+  ConcurrentBinlog::SyncStats sync_stats_;
+
   static constexpr double FLUSH_TIMEOUT = 0.001;  // 1ms
 
   void wakeup_after(double after) {
@@ -137,9 +149,16 @@ class BinlogActor final : public Actor {
     if (promise) {
       sync_promises_.emplace_back(std::move(promise));
     }
+    force_sync_request_count_++;
+    if (sync_options_.max_force_sync_batch_size != 0 &&
+        force_sync_request_count_ >= sync_options_.max_force_sync_batch_size) {
+      // the batch is full; there is no reason to wait for more requests
+      do_sync();
+      return;
+    }
     if (!force_sync_flag_) {
       force_sync_flag_ = true;
-      wakeup_after(0.003);
+      wakeup_after(sync_options_.max_force_sync_delay);
     }
   }
 
@@ -149,7 +168,7 @@ class BinlogActor final : public Actor {
     }
     sync_promises_.emplace_back(std::move(promise));
     if (!lazy_sync_flag_ && !force_sync_flag_) {
-      wakeup_after(30);
+      wakeup_after(sync_options_.lazy_sync_delay);
       lazy_sync_flag_ = true;
     }
   }
@@ -162,17 +181,37 @@ class BinlogActor final : public Actor {
     flush_flag_ = false;
     wakeup_at_ = 0;
     if (need_sync) {
-      binlog_->sync("timeout_expired");
-      // LOG(ERROR) << "BINLOG SYNC";
-      set_promises(sync_promises_);
+      do_sync();
     } else if (need_flush) {
       try_flush();
-      // LOG(ERROR) << "BINLOG FLUSH";
     }
   }
+
+  void do_sync() {
+    // the pending timeout may still expire, but it will be a no-op
+    lazy_sync_flag_ = false;
+    force_sync_flag_ = false;
+
+    auto start_time = Time::now();
+    binlog_->sync("do_sync");
+    auto sync_time = Time::now() - start_time;
+
+    auto batch_size = max(force_sync_request_count_, sync_promises_.size());
+    sync_stats_.sync_count++;
+    sync_stats_.force_sync_request_count += force_sync_request_count_;
+    sync_stats_.synced_promise_count += sync_promises_.size();
+    sync_stats_.max_batch_size = max(sync_stats_.max_batch_size, batch_size);
+    sync_stats_.total_sync_time += sync_time;
+    sync_stats_.max_sync_time = max(sync_stats_.max_sync_time, sync_time);
+    force_sync_request_count_ = 0;
+
+    set_promises(sync_promises_);
+  }
 };
 }  // namespace detail
 
+constexpr double ConcurrentBinlog::MAX_SYNC_DELAY;
+
 ConcurrentBinlog::ConcurrentBinlog() = default;
 ConcurrentBinlog::~ConcurrentBinlog() = default;
 ConcurrentBinlog::ConcurrentBinlog(unique_ptr<Binlog> binlog, int scheduler_id) {
@@ -218,6 +257,20 @@ void ConcurrentBinlog::change_key(DbKey db_key, Promise<> promise) {
   send_closure(binlog_actor_, &detail::BinlogActor::change_key, std::move(db_key), std::move(promise));
 }
 
+void ConcurrentBinlog::set_sync_options(SyncOptions options) {
+  auto clamp_delay = [](double delay) {
+    // NaN is also replaced with 0
+    return delay > 0.0 ? min(delay, MAX_SYNC_DELAY) : 0.0;
+  };
+  options.max_force_sync_delay = clamp_delay(options.max_force_sync_delay);
+  options.lazy_sync_delay = max(clamp_delay(options.lazy_sync_delay), options.max_force_sync_delay);
+  send_closure(binlog_actor_, &detail::BinlogActor::set_sync_options, options);
+}
+
+void ConcurrentBinlog::get_sync_stats(Promise<SyncStats> promise) {
+  send_closure(binlog_actor_, &detail::BinlogActor::get_sync_stats, std::move(promise));
+}
+
 uint64 ConcurrentBinlog::erase_batch(vector<uint64> event_ids) {
   auto shift = narrow_cast<int32>(event_ids.size());
   if (shift == 0) {
@@ -228,4 +281,14 @@ uint64 ConcurrentBinlog::erase_batch(vector<uint64> event_ids) {
   return seq_no;
 }
 
+StringBuilder &operator<<(StringBuilder &string_builder, const ConcurrentBinlog::SyncStats &stats) {
+  string_builder << "[syncs:" << stats.sync_count << " force_sync_requests:" << stats.force_sync_request_count
+                 << " promises:" << stats.synced_promise_count << " max_batch:" << stats.max_batch_size;
+  if (stats.sync_count != 0) {
+    string_builder << " average_sync_time:" << stats.total_sync_time / static_cast<double>(stats.sync_count)
+                   << " max_sync_time:" << stats.max_sync_time;
+  }
+  return string_builder << ']';
+}
+
 }  // namespace td
@@ -17,6 +17,7 @@
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
+#include "td/utils/StringBuilder.h"
 
 #include <atomic>
 #include <functional>
@@ -30,6 +31,26 @@ class BinlogActor;
 class ConcurrentBinlog final : public BinlogInterface {
  public:
   using Callback = std::function<void(const BinlogEvent &)>;
+
+  // all force_sync requests received within max_force_sync_delay are committed by one fdatasync;
+  // the sync is done immediately after max_force_sync_batch_size requests are accumulated, if it is non-zero
+  struct SyncOptions {
+    double max_force_sync_delay = 0.003;
+    size_t max_force_sync_batch_size = 0;
+    double lazy_sync_delay = 30.0;
+  };
+
+  static constexpr double MAX_SYNC_DELAY = 3600.0;
+
+  struct SyncStats {
+    uint64 sync_count = 0;
+    uint64 force_sync_request_count = 0;
+    uint64 synced_promise_count = 0;
+    size_t max_batch_size = 0;
+    double total_sync_time = 0.0;
+    double max_sync_time = 0.0;
+  };
+
   Result<BinlogInfo> init(string path, const Callback &callback, DbKey db_key = DbKey::empty(),
                           DbKey old_db_key = DbKey::empty(), int scheduler_id = -1) TD_WARN_UNUSED_RESULT;
 
@@ -45,6 +66,10 @@ class ConcurrentBinlog final : public BinlogInterface {
   void force_flush() final;
   void change_key(DbKey db_key, Promise<> promise) final;
 
+  // out-of-range delays are clamped to [0, MAX_SYNC_DELAY] and lazy_sync_delay is increased to max_force_sync_delay
+  void set_sync_options(SyncOptions options);
+  void get_sync_stats(Promise<SyncStats> promise);
+
   uint64 next_event_id() final {
     return last_event_id_.fetch_add(1, std::memory_order_relaxed);
   }
@@ -69,4 +94,6 @@ class ConcurrentBinlog final : public BinlogInterface {
   std::atomic<uint64> last_event_id_{0};
 };
 
+StringBuilder &operator<<(StringBuilder &string_builder, const ConcurrentBinlog::SyncStats &stats);
+
 }  // namespace td
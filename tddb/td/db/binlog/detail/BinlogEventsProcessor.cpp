@@ -23,15 +23,14 @@ Status BinlogEventsProcessor::do_event(BinlogEvent &&event) {
       return Status::Error(PSLICE() << "Ignore rewrite log event " << event.public_to_string());
     }
     auto pos = it - event_ids_.begin();
-    total_raw_events_size_ -= static_cast<int64>(events_[pos].raw_event_.size());
+    total_raw_events_size_ -= static_cast<int64>(events_[pos].size_);
     if (event.type_ == BinlogEvent::ServiceTypes::Empty) {
       *it += 1;
       empty_events_++;
       events_[pos] = {};
     } else {
-      event.flags_ &= ~BinlogEvent::Flags::Rewrite;
-      total_raw_events_size_ += static_cast<int64>(event.raw_event_.size());
-      events_[pos] = std::move(event);
+      total_raw_events_size_ += static_cast<int64>(event.size_);
+      events_[pos] = {event.offset_, event.size_};
     }
   } else if (event.type_ < 0) {
     // just skip service events
@@ -42,10 +41,10 @@ Status BinlogEventsProcessor::do_event(BinlogEvent &&event) {
                                     << total_raw_events_size_);
     }
     last_event_id_ = event.id_;
-    total_raw_events_size_ += static_cast<int64>(event.raw_event_.size());
+    total_raw_events_size_ += static_cast<int64>(event.size_);
     total_events_++;
     event_ids_.push_back(fixed_event_id);
-    events_.emplace_back(std::move(event));
+    events_.push_back({event.offset_, event.size_});
   }
 
   if (total_events_ > 10 && empty_events_ * 4 > total_events_ * 3) {
@@ -17,6 +17,12 @@ namespace detail {
 
 class BinlogEventsProcessor {
  public:
+  // event payloads aren't kept in memory and must be reread from the binlog file when needed
+  struct EventInfo {
+    int64 offset_{0};  // offset of the end of the event in the binlog file
+    uint32 size_{0};
+  };
+
   Status add_event(BinlogEvent &&event) TD_WARN_UNUSED_RESULT {
     return do_event(std::move(event));
   }
@@ -25,8 +31,7 @@ class BinlogEventsProcessor {
   void for_each(CallbackT &&callback) {
     for (size_t i = 0; i < event_ids_.size(); i++) {
       LOG_CHECK(i == 0 || event_ids_[i - 1] < event_ids_[i])
-          << event_ids_[i - 1] << " " << events_[i - 1].public_to_string() << " " << event_ids_[i] << " "
-          << events_[i].public_to_string();
+          << event_ids_[i - 1] << " " << events_[i - 1].offset_ << " " << event_ids_[i] << " " << events_[i].offset_;
       if ((event_ids_[i] & 1) == 0) {
         callback(events_[i]);
       }
@@ -46,7 +51,7 @@ class BinlogEventsProcessor {
  private:
   // holds (event_id * 2 + was_deleted)
   std::vector<uint64> event_ids_;
-  std::vector<BinlogEvent> events_;
+  std::vector<EventInfo> events_;
   size_t total_events_{0};
   size_t empty_events_{0};
   uint64 last_event_id_{0};
@@ -101,11 +101,21 @@ Result<size_t> BufferedFdBase<FdT>::flush_read(size_t max_read) {
   CHECK(read_);
   size_t result = 0;
   while (::td::can_read_local(*this) && max_read) {
-    MutableSlice slice = read_->prepare_append();
-    slice.truncate(max_read);
-    TRY_RESULT(x, FdT::read(slice));
-    slice.truncate(x);
-    read_->confirm_append(x);
+    // read into the rest of the current buffer and into the next buffer at once to save a system call
+    auto slices = read_->prepare_append_with_next();
+    slices.first.truncate(max_read);
+    slices.second.truncate(max_read - slices.first.size());
+
+    MutableIoSlice buf[2];
+    size_t buf_i = 0;
+    if (!slices.first.empty()) {
+      buf[buf_i++] = as_mutable_io_slice(slices.first);
+    }
+    if (!slices.second.empty()) {
+      buf[buf_i++] = as_mutable_io_slice(slices.second);
+    }
+    TRY_RESULT(x, FdT::readv(Span<MutableIoSlice>(buf, buf_i)));
+    read_->confirm_append_with_next(x);
     result += x;
     max_read -= x;
   }
@@ -118,7 +128,7 @@ Result<size_t> BufferedFdBase<FdT>::flush_write() {
   write_->sync_with_writer();
   size_t result = 0;
   while (!write_->empty() && ::td::can_write_local(*this)) {
-    constexpr size_t BUF_SIZE = 20;
+    constexpr size_t BUF_SIZE = 64;
     IoSlice buf[BUF_SIZE];
 
     auto it = write_->clone();
@@ -63,6 +63,19 @@ class MpscPollableQueue {
       event_fd_.release();
     }
   }
+  // puts all values with one lock acquisition and at most one wakeup; values are left empty
+  void writer_put_batch(std::vector<ValueType> &values) {
+    auto guard = lock_.lock();
+    for (auto &value : values) {
+      writer_vector_.push_back(std::move(value));
+    }
+    values.clear();
+    if (wait_event_fd_) {
+      wait_event_fd_ = false;
+      guard.reset();
+      event_fd_.release();
+    }
+  }
   EventFd &reader_get_event_fd() {
     return event_fd_;
   }
@@ -128,6 +141,10 @@ class MpscPollableQueue {
     UNREACHABLE();
   }
 
+  void writer_put_batch(std::vector<ValueType> &values) {
+    UNREACHABLE();
+  }
+
   void writer_flush() {
     UNREACHABLE();
   }
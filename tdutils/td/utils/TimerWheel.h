@@ -0,0 +1,243 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/bits.h"
+#include "td/utils/common.h"
+#include "td/utils/Heap.h"
+#include "td/utils/logging.h"
+
+#include <array>
+#include <utility>
+
+namespace td {
+
+// Hierarchical timing wheel, which uses the same intrusive HeapNode as KHeap.
+// Time is split into ticks of 1/TICKS_PER_SECOND seconds. Nodes, which expire during the same tick, are stored in the
+// same slot and are returned together after the tick ends, so they can be returned up to one tick later than requested.
+// Insertion, update and removal of a node take O(1) time; each node is moved between slots at most LEVEL_COUNT times.
+class TimerWheel {
+ public:
+  // a power of 2, so conversion between ticks and seconds is exact
+  static constexpr int64 TICKS_PER_SECOND = 1024;
+
+  TimerWheel() = default;
+  TimerWheel(const TimerWheel &) = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+  TimerWheel(TimerWheel &&) = delete;
+  TimerWheel &operator=(TimerWheel &&) = delete;
+  ~TimerWheel() = default;
+
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_t size() const {
+    return size_;
+  }
+
+  double get_key(const HeapNode *node) const {
+    auto slot = get_slot(node);
+    auto index = get_index(node);
+    CHECK(index < slots_[slot].size());
+    return slots_[slot][index].key_;
+  }
+
+  void insert(double key, HeapNode *node) {
+    CHECK(!node->in_heap());
+    do_insert(key, node);
+    size_++;
+  }
+
+  void fix(double key, HeapNode *node) {
+    CHECK(node->in_heap());
+    do_erase(node);
+    do_insert(key, node);
+  }
+
+  void erase(HeapNode *node) {
+    CHECK(node->in_heap());
+    do_erase(node);
+    node->remove();
+    size_--;
+  }
+
+  // returns time, before which no node can expire; the wheel must be non-empty
+  double get_wakeup_time() const {
+    CHECK(!empty());
+    if (!slots_[READY_SLOT].empty()) {
+      return static_cast<double>(current_tick_) / static_cast<double>(TICKS_PER_SECOND);
+    }
+    int64 slot_tick = 0;
+    auto slot = find_next_slot(slot_tick);
+    CHECK(slot != INVALID_SLOT);
+    return static_cast<double>(slot_tick) / static_cast<double>(TICKS_PER_SECOND);
+  }
+
+  // returns a node, which expired before now, or nullptr if there are no such nodes
+  HeapNode *pop_expired(double now) {
+    if (slots_[READY_SLOT].empty()) {
+      advance(static_cast<int64>(clamp_ticks(now * static_cast<double>(TICKS_PER_SECOND))));
+      if (slots_[READY_SLOT].empty()) {
+        return nullptr;
+      }
+    }
+    return pop_from_slot(READY_SLOT);
+  }
+
+  // returns a node from the earliest non-empty slot without advancing current time; the wheel must be non-empty
+  HeapNode *pop() {
+    CHECK(!empty());
+    if (!slots_[READY_SLOT].empty()) {
+      return pop_from_slot(READY_SLOT);
+    }
+    int64 slot_tick = 0;
+    auto slot = find_next_slot(slot_tick);
+    CHECK(slot != INVALID_SLOT);
+    return pop_from_slot(slot);
+  }
+
+  template <class F>
+  void for_each(F &&f) const {
+    for (auto &entries : slots_) {
+      for (auto &entry : entries) {
+        f(entry.key_, entry.node_);
+      }
+    }
+  }
+
+ private:
+  struct Entry {
+    double key_;
+    HeapNode *node_;
+  };
+
+  static constexpr int32 LEVEL_BITS = 6;
+  static constexpr int32 SLOTS_PER_LEVEL = 1 << LEVEL_BITS;
+  static constexpr int32 LEVEL_COUNT = 7;  // 2^42 ticks, i.e. more than 100 years
+  static constexpr int64 MAX_TICK = (static_cast<int64>(1) << (LEVEL_BITS * LEVEL_COUNT)) - 1;
+  static constexpr int32 READY_SLOT = LEVEL_COUNT * SLOTS_PER_LEVEL;
+  static constexpr int32 INVALID_SLOT = -1;
+
+  // HeapNode::pos_ contains slot in the high bits and index in the slot in the low bits
+  static constexpr int32 INDEX_BITS = 22;
+  static constexpr size_t MAX_SLOT_SIZE = static_cast<size_t>(1) << INDEX_BITS;
+
+  std::array<vector<Entry>, READY_SLOT + 1> slots_;
+  std::array<uint64, LEVEL_COUNT> non_empty_slot_masks_{};
+  vector<Entry> cascaded_entries_;
+  int64 current_tick_ = 0;  // all nodes, which expire not later than the current tick, are in READY_SLOT
+  size_t size_ = 0;
+
+  static double clamp_ticks(double ticks) {
+    if (!(ticks > 0.0)) {
+      return 0.0;
+    }
+    if (ticks >= static_cast<double>(MAX_TICK)) {
+      return static_cast<double>(MAX_TICK);
+    }
+    return ticks;
+  }
+
+  static int64 get_expiration_tick(double key) {
+    // the node expires after the end of the tick, containing the key
+    auto tick = static_cast<int64>(clamp_ticks(key * static_cast<double>(TICKS_PER_SECOND))) + 1;
+    return tick > MAX_TICK ? MAX_TICK : tick;
+  }
+
+  static size_t get_slot(const HeapNode *node) {
+    return static_cast<size_t>(node->pos_) >> INDEX_BITS;
+  }
+
+  static size_t get_index(const HeapNode *node) {
+    return static_cast<size_t>(node->pos_) & (MAX_SLOT_SIZE - 1);
+  }
+
+  static void set_position(HeapNode *node, size_t slot, size_t index) {
+    node->pos_ = static_cast<int32>((slot << INDEX_BITS) | index);
+  }
+
+  int32 get_slot_for_tick(int64 tick) const {
+    if (tick <= current_tick_) {
+      return READY_SLOT;
+    }
+    // the level is chosen by the highest differing digit of the expiration tick and the current tick
+    auto level = (63 - count_leading_zeroes64(static_cast<uint64>(tick ^ current_tick_))) / LEVEL_BITS;
+    auto digit = static_cast<int32>((tick >> (level * LEVEL_BITS)) & (SLOTS_PER_LEVEL - 1));
+    return level * SLOTS_PER_LEVEL + digit;
+  }
+
+  void do_insert(double key, HeapNode *node) {
+    auto slot = get_slot_for_tick(get_expiration_tick(key));
+    auto &entries = slots_[slot];
+    CHECK(entries.size() < MAX_SLOT_SIZE);
+    set_position(node, static_cast<size_t>(slot), entries.size());
+    entries.push_back({key, node});
+    if (slot != READY_SLOT) {
+      non_empty_slot_masks_[slot / SLOTS_PER_LEVEL] |= static_cast<uint64>(1) << (slot % SLOTS_PER_LEVEL);
+    }
+  }
+
+  void do_erase(HeapNode *node) {
+    auto slot = get_slot(node);
+    auto index = get_index(node);
+    auto &entries = slots_[slot];
+    CHECK(index < entries.size());
+    if (index + 1 != entries.size()) {
+      entries[index] = entries.back();
+      set_position(entries[index].node_, slot, index);
+    }
+    entries.pop_back();
+    if (entries.empty() && slot != READY_SLOT) {
+      non_empty_slot_masks_[slot / SLOTS_PER_LEVEL] &= ~(static_cast<uint64>(1) << (slot % SLOTS_PER_LEVEL));
+    }
+  }
+
+  HeapNode *pop_from_slot(int32 slot) {
+    auto *node = slots_[slot].back().node_;
+    erase(node);
+    return node;
+  }
+
+  // finds the earliest non-empty slot and the tick, at which it must be processed
+  int32 find_next_slot(int64 &slot_tick) const {
+    for (int32 level = 0; level < LEVEL_COUNT; level++) {
+      auto shift = level * LEVEL_BITS;
+      auto digit = static_cast<int32>((current_tick_ >> shift) & (SLOTS_PER_LEVEL - 1));
+      // all non-empty slots of the level are after the current digit
+      auto mask = (non_empty_slot_masks_[level] >> digit) >> 1;
+      if (mask != 0) {
+        auto next_digit = digit + 1 + count_trailing_zeroes64(mask);
+        slot_tick = ((current_tick_ >> (shift + LEVEL_BITS)) << (shift + LEVEL_BITS)) +
+                    (static_cast<int64>(next_digit) << shift);
+        return level * SLOTS_PER_LEVEL + next_digit;
+      }
+    }
+    return INVALID_SLOT;
+  }
+
+  void advance(int64 tick) {
+    while (current_tick_ < tick) {
+      int64 slot_tick = 0;
+      auto slot = find_next_slot(slot_tick);
+      if (slot == INVALID_SLOT || slot_tick > tick) {
+        current_tick_ = tick;
+        return;
+      }
+      current_tick_ = slot_tick;
+
+      // nodes from the slot are moved to lower levels or to READY_SLOT all at once
+      std::swap(cascaded_entries_, slots_[slot]);
+      non_empty_slot_masks_[slot / SLOTS_PER_LEVEL] &= ~(static_cast<uint64>(1) << (slot % SLOTS_PER_LEVEL));
+      for (auto &entry : cascaded_entries_) {
+        do_insert(entry.key_, entry.node_);
+      }
+      cascaded_entries_.clear();
+    }
+  }
+};
+
+}  // namespace td
@@ -13,6 +13,7 @@
 #include <atomic>
 #include <limits>
 #include <memory>
+#include <utility>
 
 namespace td {
 
@@ -709,11 +710,10 @@ class ChainBufferWriter {
     if (hint < (1 << 10)) {
       hint = 1 << 12;
     }
-    BufferWriter new_writer(hint);
-    auto new_tail = ChainBufferNodeAllocator::create(new_writer.as_buffer_slice(), true);
-    tail_->next_ = ChainBufferNodeAllocator::clone(new_tail);
-    writer_ = std::move(new_writer);
-    tail_ = std::move(new_tail);  // release tail_
+    if (next_writer_.prepare_append().size() < hint) {
+      next_writer_ = BufferWriter(hint);
+    }
+    switch_to_next_writer();
     return writer_.prepare_append();
   }
   void confirm_append(size_t size) {
@@ -721,6 +721,34 @@ class ChainBufferWriter {
     writer_.confirm_append(size);
   }
 
+  // returns free space in the current buffer and in the next buffer, which can be filled consecutively by one readv
+  // the next buffer is allocated only if little space is left in the current buffer and is kept until it is used
+  std::pair<MutableSlice, MutableSlice> prepare_append_with_next(size_t hint = 0) {
+    CHECK(!empty());
+    auto current = writer_.prepare_append();
+    if (next_writer_.is_null()) {
+      if (current.size() >= (1 << 10)) {
+        return {current, MutableSlice()};
+      }
+      if (hint < (1 << 10)) {
+        hint = 1 << 12;
+      }
+      next_writer_ = BufferWriter(hint);
+    }
+    return {current, next_writer_.prepare_append()};
+  }
+  void confirm_append_with_next(size_t size) {
+    CHECK(!empty());
+    auto current_size = min(size, writer_.prepare_append().size());
+    writer_.confirm_append(current_size);
+    size -= current_size;
+    if (size != 0) {
+      CHECK(!next_writer_.is_null());
+      switch_to_next_writer();
+      writer_.confirm_append(size);
+    }
+  }
+
   void append(Slice slice, size_t hint = 0) {
     while (!slice.empty()) {
       auto ready = prepare_append(td::max(slice.size(), hint));
@@ -767,8 +795,17 @@ class ChainBufferWriter {
   }
 
   BufferWriter writer_;
+  BufferWriter next_writer_;
   ChainBufferNodeWriterPtr tail_;
   ChainBufferNodeReaderPtr head_;
+
+  void switch_to_next_writer() {
+    auto new_tail = ChainBufferNodeAllocator::create(next_writer_.as_buffer_slice(), true);
+    tail_->next_ = ChainBufferNodeAllocator::clone(new_tail);
+    writer_ = std::move(next_writer_);
+    next_writer_ = BufferWriter();
+    tail_ = std::move(new_tail);  // release tail_
+  }
 };
 
 class BufferBuilder {
@@ -48,6 +48,12 @@
 #include "crc32c/crc32c.h"
 #endif
 
+#if TD_HAVE_OPENSSL && (TD_GCC || TD_CLANG) && (defined(__x86_64__) || defined(__i386__))
+#define TD_HAVE_AES_NI_BATCH 1
+#include <cpuid.h>
+#include <wmmintrin.h>
+#endif
+
 #include <algorithm>
 #include <cerrno>
 #include <cstring>
@@ -589,6 +595,197 @@ void aes_ige_decrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlic
   state.get_iv(aes_iv);
 }
 
+#if TD_HAVE_AES_NI_BATCH
+#define TD_AES_NI_TARGET __attribute__((target("aes,sse2")))
+
+static bool has_aes_ni() {
+  static const bool result = [] {
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0 && (ecx & bit_AES) != 0;
+  }();
+  return result;
+}
+
+static TD_AES_NI_TARGET __m128i aes_ni_xor_shifted_words(__m128i key) {
+  __m128i shifted = _mm_slli_si128(key, 4);
+  key = _mm_xor_si128(key, shifted);
+  shifted = _mm_slli_si128(shifted, 4);
+  key = _mm_xor_si128(key, shifted);
+  shifted = _mm_slli_si128(shifted, 4);
+  return _mm_xor_si128(key, shifted);
+}
+
+template <int rcon>
+static TD_AES_NI_TARGET void aes_ni_expand_key_pair(__m128i &first, __m128i &second) {
+  first = _mm_xor_si128(aes_ni_xor_shifted_words(first),
+                        _mm_shuffle_epi32(_mm_aeskeygenassist_si128(second, rcon), 0xff));
+  second = _mm_xor_si128(aes_ni_xor_shifted_words(second),
+                         _mm_shuffle_epi32(_mm_aeskeygenassist_si128(first, 0), 0xaa));
+}
+
+static TD_AES_NI_TARGET void aes_ni_expand_key(const uint8 *key, bool encrypt, __m128i *round_keys) {
+  auto first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key));
+  auto second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key + AES_BLOCK_SIZE));
+  round_keys[0] = first;
+  round_keys[1] = second;
+  aes_ni_expand_key_pair<0x01>(first, second);
+  round_keys[2] = first;
+  round_keys[3] = second;
+  aes_ni_expand_key_pair<0x02>(first, second);
+  round_keys[4] = first;
+  round_keys[5] = second;
+  aes_ni_expand_key_pair<0x04>(first, second);
+  round_keys[6] = first;
+  round_keys[7] = second;
+  aes_ni_expand_key_pair<0x08>(first, second);
+  round_keys[8] = first;
+  round_keys[9] = second;
+  aes_ni_expand_key_pair<0x10>(first, second);
+  round_keys[10] = first;
+  round_keys[11] = second;
+  aes_ni_expand_key_pair<0x20>(first, second);
+  round_keys[12] = first;
+  round_keys[13] = second;
+  round_keys[14] = _mm_xor_si128(aes_ni_xor_shifted_words(first),
+                                 _mm_shuffle_epi32(_mm_aeskeygenassist_si128(second, 0x40), 0xff));
+
+  if (!encrypt) {
+    // the Equivalent Inverse Cipher uses the reversed key schedule with InvMixColumns applied to inner round keys
+    __m128i decryption_round_keys[15];
+    decryption_round_keys[0] = round_keys[14];
+    for (int i = 1; i < 14; i++) {
+      decryption_round_keys[i] = _mm_aesimc_si128(round_keys[14 - i]);
+    }
+    decryption_round_keys[14] = round_keys[0];
+    for (int i = 0; i < 15; i++) {
+      round_keys[i] = decryption_round_keys[i];
+    }
+  }
+}
+
+// IGE encryption and decryption are the same up to the block cipher direction:
+// output[i] = cipher(input[i] ^ output[i - 1]) ^ input[i - 1]
+// each message is chained, so throughput is gained by interleaving blocks of different messages,
+// which makes independent AES rounds of all lanes to be pipelined by the CPU
+template <bool encrypt>
+static TD_AES_NI_TARGET void aes_ni_ige_batch(Span<AesIgeBatchItem> items) {
+  static constexpr size_t MAX_LANES = 8;
+  static constexpr int ROUND_COUNT = 14;
+  struct Lane {
+    __m128i round_keys[ROUND_COUNT + 1];
+    __m128i input_iv;
+    __m128i output_iv;
+    const uint8 *in;
+    uint8 *out;
+    size_t left_blocks;
+    MutableSlice iv;
+  };
+  Lane lanes[MAX_LANES];
+  size_t lane_count = 0;
+  size_t next_item = 0;
+
+  while (true) {
+    while (lane_count < MAX_LANES && next_item < items.size()) {
+      const auto &item = items[next_item++];
+      CHECK(item.key.size() == 32);
+      CHECK(item.iv.size() == 32);
+      CHECK(item.from.size() % AES_BLOCK_SIZE == 0);
+      CHECK(item.to.size() >= item.from.size());
+      if (item.from.empty()) {
+        continue;
+      }
+
+      auto &lane = lanes[lane_count++];
+      aes_ni_expand_key(item.key.ubegin(), encrypt, lane.round_keys);
+      auto encrypted_iv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(item.iv.ubegin()));
+      auto plaintext_iv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(item.iv.ubegin() + AES_BLOCK_SIZE));
+      lane.input_iv = encrypt ? plaintext_iv : encrypted_iv;
+      lane.output_iv = encrypt ? encrypted_iv : plaintext_iv;
+      lane.in = item.from.ubegin();
+      lane.out = item.to.ubegin();
+      lane.left_blocks = item.from.size() / AES_BLOCK_SIZE;
+      lane.iv = item.iv;
+    }
+    if (lane_count == 0) {
+      break;
+    }
+
+    size_t step_count = lanes[0].left_blocks;
+    for (size_t i = 1; i < lane_count; i++) {
+      step_count = td::min(step_count, lanes[i].left_blocks);
+    }
+    for (size_t step = 0; step < step_count; step++) {
+      __m128i input[MAX_LANES];
+      __m128i state[MAX_LANES];
+      for (size_t i = 0; i < lane_count; i++) {
+        input[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lanes[i].in));
+        state[i] = _mm_xor_si128(_mm_xor_si128(input[i], lanes[i].output_iv), lanes[i].round_keys[0]);
+      }
+      for (int round = 1; round < ROUND_COUNT; round++) {
+        for (size_t i = 0; i < lane_count; i++) {
+          state[i] = encrypt ? _mm_aesenc_si128(state[i], lanes[i].round_keys[round])
+                             : _mm_aesdec_si128(state[i], lanes[i].round_keys[round]);
+        }
+      }
+      for (size_t i = 0; i < lane_count; i++) {
+        auto &lane = lanes[i];
+        state[i] = encrypt ? _mm_aesenclast_si128(state[i], lane.round_keys[ROUND_COUNT])
+                           : _mm_aesdeclast_si128(state[i], lane.round_keys[ROUND_COUNT]);
+        lane.output_iv = _mm_xor_si128(state[i], lane.input_iv);
+        lane.input_iv = input[i];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lane.out), lane.output_iv);
+        lane.in += AES_BLOCK_SIZE;
+        lane.out += AES_BLOCK_SIZE;
+      }
+    }
+
+    for (size_t i = 0; i < lane_count;) {
+      auto &lane = lanes[i];
+      lane.left_blocks -= step_count;
+      if (lane.left_blocks != 0) {
+        i++;
+        continue;
+      }
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(lane.iv.ubegin()), encrypt ? lane.output_iv : lane.input_iv);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(lane.iv.ubegin() + AES_BLOCK_SIZE),
+                       encrypt ? lane.input_iv : lane.output_iv);
+      if (i + 1 != lane_count) {
+        lane = lanes[lane_count - 1];
+      }
+      lane_count--;
+    }
+  }
+}
+#endif
+
+void aes_ige_encrypt_batch(Span<AesIgeBatchItem> items) {
+#if TD_HAVE_AES_NI_BATCH
+  if (has_aes_ni()) {
+    aes_ni_ige_batch<true>(items);
+    return;
+  }
+#endif
+  for (const auto &item : items) {
+    aes_ige_encrypt(item.key, item.iv, item.from, item.to.substr(0, item.from.size()));
+  }
+}
+
+void aes_ige_decrypt_batch(Span<AesIgeBatchItem> items) {
+#if TD_HAVE_AES_NI_BATCH
+  if (has_aes_ni()) {
+    aes_ni_ige_batch<false>(items);
+    return;
+  }
+#endif
+  for (const auto &item : items) {
+    aes_ige_decrypt(item.key, item.iv, item.from, item.to.substr(0, item.from.size()));
+  }
+}
+
 void aes_cbc_encrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to) {
   CHECK(from.size() <= to.size());
   CHECK(from.size() % 16 == 0);
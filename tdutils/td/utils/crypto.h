@@ -10,6 +10,7 @@
 #include "td/utils/common.h"
 #include "td/utils/SharedSlice.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 
 namespace td {
@@ -65,6 +66,18 @@ class AesIgeState {
   unique_ptr<AesIgeStateImpl> impl_;
 };
 
+struct AesIgeBatchItem {
+  Slice key;
+  MutableSlice iv;
+  Slice from;
+  MutableSlice to;
+};
+
+// encrypts or decrypts independent messages, which can use different keys, as aes_ige_encrypt/aes_ige_decrypt do
+// with each of them; if AES-NI is available, blocks of several messages are processed simultaneously
+void aes_ige_encrypt_batch(Span<AesIgeBatchItem> items);
+void aes_ige_decrypt_batch(Span<AesIgeBatchItem> items);
+
 void aes_cbc_encrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to);
 void aes_cbc_decrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to);
 
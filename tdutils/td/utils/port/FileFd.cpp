@@ -350,6 +350,50 @@ Result<size_t> FileFd::read(MutableSlice slice) {
   return OS_ERROR(PSLICE() << "Read from " << get_native_fd() << " has failed");
 }
 
+Result<size_t> FileFd::readv(Span<MutableIoSlice> slices) {
+#if TD_PORT_POSIX
+  auto native_fd = get_native_fd().fd();
+  TRY_RESULT(slices_size, narrow_cast_safe<int>(slices.size()));
+  size_t total_size = 0;
+  for (const auto &slice : slices) {
+    total_size += slice.iov_len;
+  }
+  auto bytes_read = detail::skip_eintr([&] { return ::readv(native_fd, slices.begin(), slices_size); });
+  bool success = bytes_read >= 0;
+  if (!success) {
+    auto read_errno = errno;
+    if (read_errno == EAGAIN
+#if EAGAIN != EWOULDBLOCK
+        || read_errno == EWOULDBLOCK
+#endif
+    ) {
+      success = true;
+      bytes_read = 0;
+    }
+  }
+  if (success) {
+    auto result = narrow_cast<size_t>(bytes_read);
+    CHECK(result <= total_size);
+    if (result < total_size) {
+      get_poll_info().clear_flags(PollFlags::Read());
+    }
+    return result;
+  }
+  return OS_ERROR(PSLICE() << "Readv from " << get_native_fd() << " has failed");
+#else
+  size_t res = 0;
+  for (auto slice : slices) {
+    TRY_RESULT(size, read(slice));
+    res += size;
+    if (size != slice.size()) {
+      CHECK(size < slice.size());
+      break;
+    }
+  }
+  return res;
+#endif
+}
+
 Result<size_t> FileFd::pwrite(Slice slice, int64 offset) {
   if (offset < 0) {
     return Status::Error("Offset must be non-negative");
@@ -659,6 +703,18 @@ Status FileFd::sync_barrier() {
   return sync();
 }
 
+Status FileFd::sync_data() {
+  CHECK(!empty());
+#if TD_LINUX || TD_ANDROID || TD_FREEBSD
+  if (detail::skip_eintr([&] { return fdatasync(get_native_fd().fd()); }) != 0) {
+    return OS_ERROR("Data sync failed");
+  }
+  return Status::OK();
+#else
+  return sync();
+#endif
+}
+
 Status FileFd::seek(int64 position) {
   CHECK(!empty());
 #if TD_PORT_POSIX
@@ -40,6 +40,7 @@ class FileFd {
   Result<size_t> write(Slice slice) TD_WARN_UNUSED_RESULT;
   Result<size_t> writev(Span<IoSlice> slices) TD_WARN_UNUSED_RESULT;
   Result<size_t> read(MutableSlice slice) TD_WARN_UNUSED_RESULT;
+  Result<size_t> readv(Span<MutableIoSlice> slices) TD_WARN_UNUSED_RESULT;
 
   Result<size_t> pwrite(Slice slice, int64 offset) TD_WARN_UNUSED_RESULT;
   Result<size_t> pread(MutableSlice slice, int64 offset) const TD_WARN_UNUSED_RESULT;
@@ -63,6 +64,8 @@ class FileFd {
 
   Status sync() TD_WARN_UNUSED_RESULT;
   Status sync_barrier() TD_WARN_UNUSED_RESULT;
+  // syncs file data and only the metadata needed to read it back, i.e. skips modification time update
+  Status sync_data() TD_WARN_UNUSED_RESULT;
 
   Status seek(int64 position) TD_WARN_UNUSED_RESULT;
 
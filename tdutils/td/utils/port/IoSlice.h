@@ -29,6 +29,15 @@ inline Slice as_slice(const IoSlice &io_slice) {
   return Slice(static_cast<const char *>(io_slice.iov_base), io_slice.iov_len);
 }
 
+using MutableIoSlice = struct iovec;
+
+inline MutableIoSlice as_mutable_io_slice(MutableSlice slice) {
+  MutableIoSlice res;
+  res.iov_len = slice.size();
+  res.iov_base = slice.data();
+  return res;
+}
+
 #else
 
 using IoSlice = Slice;
@@ -37,6 +46,12 @@ inline IoSlice as_io_slice(Slice slice) {
   return slice;
 }
 
+using MutableIoSlice = MutableSlice;
+
+inline MutableIoSlice as_mutable_io_slice(MutableSlice slice) {
+  return slice;
+}
+
 #endif
 
 }  // namespace td
@@ -148,6 +148,18 @@ class SocketFdImpl final : private Iocp::Callback {
     return res;
   }
 
+  Result<size_t> readv(Span<MutableIoSlice> slices) {
+    size_t result = 0;
+    for (auto slice : slices) {
+      TRY_RESULT(size, read(slice));
+      result += size;
+      if (size != slice.size()) {
+        break;
+      }
+    }
+    return result;
+  }
+
   Status get_pending_error() {
     Status res;
     {
@@ -498,6 +510,25 @@ class SocketFdImpl {
     int native_fd = get_native_fd().socket();
     CHECK(!slice.empty());
     auto read_res = detail::skip_eintr([&] { return ::read(native_fd, slice.begin(), slice.size()); });
+    return read_finish(read_res, slice.size());
+  }
+
+  Result<size_t> readv(Span<MutableIoSlice> slices) {
+    if (get_poll_info().get_flags_local().has_pending_error()) {
+      TRY_STATUS(get_pending_error());
+    }
+    int native_fd = get_native_fd().socket();
+    TRY_RESULT(slices_size, narrow_cast_safe<int>(slices.size()));
+    size_t total_size = 0;
+    for (const auto &slice : slices) {
+      total_size += slice.iov_len;
+    }
+    CHECK(total_size != 0);
+    auto read_res = detail::skip_eintr([&] { return ::readv(native_fd, slices.begin(), slices_size); });
+    return read_finish(read_res, total_size);
+  }
+
+  Result<size_t> read_finish(ssize_t read_res, size_t max_size) {
     auto read_errno = errno;
     if (read_res >= 0) {
       if (read_res == 0) {
@@ -506,7 +537,7 @@ class SocketFdImpl {
         get_poll_info().add_flags(PollFlags::Close());
       }
       auto result = narrow_cast<size_t>(read_res);
-      CHECK(result <= slice.size());
+      CHECK(result <= max_size);
       return result;
     }
     if (read_errno == EAGAIN
@@ -717,6 +748,11 @@ Result<size_t> SocketFd::read(MutableSlice slice) {
   return impl_->read(slice);
 }
 
+Result<size_t> SocketFd::readv(Span<MutableIoSlice> slices) {
+  CHECK(!empty());
+  return impl_->readv(slices);
+}
+
 Result<uint32> SocketFd::maximize_snd_buffer(uint32 max_size) {
   return get_native_fd().maximize_snd_buffer(max_size);
 }
@@ -0,0 +1,117 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/Heap.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+#include "td/utils/TimerWheel.h"
+
+#include <cmath>
+#include <set>
+#include <utility>
+
+namespace {
+
+struct TimerNode final : public td::HeapNode {
+  double key = 0.0;
+  int id = 0;
+};
+
+double get_tick_end(double now) {
+  auto ticks_per_second = static_cast<double>(td::TimerWheel::TICKS_PER_SECOND);
+  return std::floor(now * ticks_per_second) / ticks_per_second;
+}
+
+}  // namespace
+
+TEST(TimerWheel, pop_expired) {
+  td::TimerWheel timer_wheel;
+  td::vector<TimerNode> nodes(5);
+  double keys[] = {1000.5, 1000.0001, 1000.0002, 1001.5, 100000.0};
+  for (size_t i = 0; i < nodes.size(); i++) {
+    nodes[i].id = static_cast<int>(i);
+    nodes[i].key = keys[i];
+    timer_wheel.insert(keys[i], &nodes[i]);
+    ASSERT_TRUE(nodes[i].in_heap());
+    ASSERT_EQ(keys[i], timer_wheel.get_key(&nodes[i]));
+  }
+  ASSERT_EQ(5u, timer_wheel.size());
+  ASSERT_TRUE(timer_wheel.pop_expired(1000.0) == nullptr);
+  ASSERT_TRUE(timer_wheel.get_wakeup_time() > 1000.0);
+  ASSERT_TRUE(timer_wheel.get_wakeup_time() <= 1000.0001 + 1.0 / td::TimerWheel::TICKS_PER_SECOND);
+
+  std::set<int> expired_ids;
+  while (auto node = timer_wheel.pop_expired(1000.01)) {
+    ASSERT_TRUE(!node->in_heap());
+    expired_ids.insert(static_cast<TimerNode *>(node)->id);
+  }
+  ASSERT_EQ(2u, expired_ids.size());
+  ASSERT_EQ(1, *expired_ids.begin());
+  ASSERT_EQ(2, *expired_ids.rbegin());
+
+  timer_wheel.fix(999.0, &nodes[3]);
+  ASSERT_TRUE(timer_wheel.pop_expired(1000.01) == &nodes[3]);
+  timer_wheel.erase(&nodes[0]);
+  ASSERT_TRUE(!nodes[0].in_heap());
+  ASSERT_TRUE(timer_wheel.pop_expired(1e6) == &nodes[4]);
+  ASSERT_TRUE(timer_wheel.empty());
+}
+
+TEST(TimerWheel, random_events) {
+  td::TimerWheel timer_wheel;
+  td::Random::Xorshift128plus rnd(123);
+  int n = 10000;
+  td::vector<TimerNode> nodes(n);
+  std::set<std::pair<double, int>> timeouts;
+  for (int i = 0; i < n; i++) {
+    nodes[i].id = i;
+  }
+
+  double now = 12345.678;
+  for (int i = 0; i < 300000; i++) {
+    auto &node = nodes[rnd.fast(0, n - 1)];
+    int type = rnd.fast(0, 9);
+    if (type < 6) {
+      // timeouts from 0 to 100 seconds with both short and long delays
+      double delay = type < 3 ? rnd.fast(0, 1000) * 0.0001 : rnd.fast(0, 100000) * 0.001;
+      double key = now + delay;
+      if (node.in_heap()) {
+        timeouts.erase(std::make_pair(node.key, node.id));
+        timer_wheel.fix(key, &node);
+      } else {
+        timer_wheel.insert(key, &node);
+      }
+      node.key = key;
+      timeouts.emplace(key, node.id);
+    } else if (type < 7) {
+      if (node.in_heap()) {
+        timeouts.erase(std::make_pair(node.key, node.id));
+        timer_wheel.erase(&node);
+      }
+    } else {
+      now += rnd.fast(0, 100) * 0.001;
+      while (auto expired_node = timer_wheel.pop_expired(now)) {
+        auto timer_node = static_cast<TimerNode *>(expired_node);
+        ASSERT_TRUE(timer_node->key < now);
+        ASSERT_EQ(1u, timeouts.erase(std::make_pair(timer_node->key, timer_node->id)));
+      }
+      // all timeouts from finished ticks must be returned
+      ASSERT_TRUE(timeouts.empty() || timeouts.begin()->first >= get_tick_end(now));
+      if (!timeouts.empty()) {
+        ASSERT_TRUE(timer_wheel.get_wakeup_time() <= timeouts.begin()->first + 1.0 / td::TimerWheel::TICKS_PER_SECOND);
+      }
+    }
+    ASSERT_EQ(timeouts.size(), timer_wheel.size());
+  }
+
+  while (!timer_wheel.empty()) {
+    auto timer_node = static_cast<TimerNode *>(timer_wheel.pop());
+    ASSERT_TRUE(!timer_node->in_heap());
+    ASSERT_EQ(1u, timeouts.erase(std::make_pair(timer_node->key, timer_node->id)));
+  }
+  ASSERT_TRUE(timeouts.empty());
+}
@@ -54,3 +54,29 @@ TEST(Buffer, buffer_builder) {
     ASSERT_EQ(builder.extract().as_slice(), str);
   }
 }
+
+TEST(Buffer, chain_buffer_append_with_next) {
+  auto str = td::rand_string('a', 'z', 100000);
+  td::ChainBufferWriter writer;
+  auto reader = writer.extract_reader();
+  td::Slice left = str;
+  while (!left.empty()) {
+    if (td::Random::fast_bool()) {
+      auto size = td::min(left.size(), static_cast<size_t>(td::Random::fast(1, 1000)));
+      writer.append(left.substr(0, size));
+      left.remove_prefix(size);
+      continue;
+    }
+    auto slices = writer.prepare_append_with_next();
+    ASSERT_TRUE(slices.first.size() >= (1 << 10) || !slices.second.empty());
+    auto size = td::min(left.size(), slices.first.size() + slices.second.size());
+    size = td::min(size, static_cast<size_t>(td::Random::fast(0, 10000)));
+    auto first_size = td::min(size, slices.first.size());
+    slices.first.copy_from(left.substr(0, first_size));
+    slices.second.copy_from(left.substr(first_size, size - first_size));
+    writer.confirm_append_with_next(size);
+    left.remove_prefix(size);
+  }
+  reader.sync_with_writer();
+  ASSERT_EQ(str, reader.move_as_buffer_slice().as_slice());
+}
@@ -160,6 +160,54 @@ TEST(Crypto, AesIgeState) {
   }
 }
 
+TEST(Crypto, AesIgeBatch) {
+  td::Random::Xorshift128plus rnd(123);
+  for (int test = 0; test < 20; test++) {
+    auto item_count = rnd.fast(0, 20);
+    td::vector<td::string> keys(item_count, td::string(32, '\0'));
+    td::vector<td::string> ivs(item_count, td::string(32, '\0'));
+    td::vector<td::string> plaintexts(item_count);
+    for (int i = 0; i < item_count; i++) {
+      rnd.bytes(keys[i]);
+      rnd.bytes(ivs[i]);
+      plaintexts[i] = td::string(16 * rnd.fast(0, rnd.fast(0, 1) == 0 ? 4 : 300), '\0');
+      rnd.bytes(plaintexts[i]);
+    }
+
+    auto encrypted = plaintexts;
+    auto encrypted_ivs = ivs;
+    td::vector<td::AesIgeBatchItem> items;
+    for (int i = 0; i < item_count; i++) {
+      items.push_back({keys[i], encrypted_ivs[i], encrypted[i], encrypted[i]});
+    }
+    td::aes_ige_encrypt_batch(items);
+
+    for (int i = 0; i < item_count; i++) {
+      td::string expected(plaintexts[i].size(), '\0');
+      auto iv = ivs[i];
+      td::aes_ige_encrypt(keys[i], iv, plaintexts[i], expected);
+      ASSERT_EQ(expected, encrypted[i]);
+      ASSERT_EQ(iv, encrypted_ivs[i]);
+    }
+
+    td::vector<td::string> decrypted(item_count);
+    auto decrypted_ivs = ivs;
+    items.clear();
+    for (int i = 0; i < item_count; i++) {
+      decrypted[i] = td::string(encrypted[i].size(), '\0');
+      items.push_back({keys[i], decrypted_ivs[i], encrypted[i], decrypted[i]});
+    }
+    td::aes_ige_decrypt_batch(items);
+
+    for (int i = 0; i < item_count; i++) {
+      ASSERT_EQ(plaintexts[i], decrypted[i]);
+      auto iv = ivs[i];
+      td::aes_ige_decrypt(keys[i], iv, encrypted[i], encrypted[i]);
+      ASSERT_EQ(iv, decrypted_ivs[i]);
+    }
+  }
+}
+
 TEST(Crypto, AesCbcState) {
   td::vector<td::uint32> answers1{0u, 3617355989u, 3449188102u, 186999968u, 4244808847u, 2626031206u};
 
@@ -5,6 +5,7 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 #include "td/utils/algorithm.h"
+#include "td/utils/BufferedFd.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
@@ -12,6 +13,7 @@
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/IoSlice.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/PollFlags.h"
 #include "td/utils/port/signals.h"
 #include "td/utils/port/sleep.h"
 #include "td/utils/port/Stat.h"
@@ -179,6 +181,43 @@ TEST(Port, Writev) {
   td::unlink(test_file_path).ignore();
 }
 
+TEST(Port, Readv) {
+  td::CSlice test_file_path = "test.txt";
+  td::unlink(test_file_path).ignore();
+  auto fd = td::FileFd::open(test_file_path, td::FileFd::Write | td::FileFd::CreateNew).move_as_ok();
+  auto expected_content = td::rand_string('a', 'z', 100000);
+  ASSERT_EQ(expected_content.size(), fd.write(expected_content).move_as_ok());
+  fd.close();
+
+  fd = td::FileFd::open(test_file_path, td::FileFd::Read).move_as_ok();
+  td::string a(1, '\0');
+  td::string b(2, '\0');
+  td::string c(3, '\0');
+  td::vector<td::MutableIoSlice> vec;
+  vec.push_back(td::as_mutable_io_slice(a));
+  vec.push_back(td::as_mutable_io_slice(b));
+  vec.push_back(td::as_mutable_io_slice(c));
+  ASSERT_EQ(6u, fd.readv(vec).move_as_ok());
+  ASSERT_EQ(expected_content.substr(0, 6), a + b + c);
+  fd.close();
+
+  auto buffered_fd = td::BufferedFd<td::FileFd>(td::FileFd::open(test_file_path, td::FileFd::Read).move_as_ok());
+  buffered_fd.get_poll_info().add_flags(td::PollFlags::Read());
+  td::string content;
+  while (true) {
+    auto size = buffered_fd.flush_read(td::Random::fast(1, 10000)).move_as_ok();
+    if (size == 0) {
+      break;
+    }
+    auto &input = buffered_fd.input_buffer();
+    content += input.cut_head(input.size()).move_as_buffer_slice().as_slice().str();
+  }
+  ASSERT_EQ(expected_content, content);
+  buffered_fd.close();
+
+  td::unlink(test_file_path).ignore();
+}
+
 #if TD_PORT_POSIX && !TD_THREAD_UNSUPPORTED
 
 static std::mutex m;
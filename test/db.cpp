@@ -6,14 +6,23 @@
 //
 #include "data.h"
 
+#include "td/telegram/DialogId.h"
+#include "td/telegram/MessageDb.h"
+#include "td/telegram/MessageId.h"
+#include "td/telegram/NotificationId.h"
+#include "td/telegram/ServerMessageId.h"
+#include "td/telegram/UserId.h"
+
 #include "td/db/binlog/BinlogHelper.h"
 #include "td/db/binlog/ConcurrentBinlog.h"
 #include "td/db/BinlogKeyValue.h"
 #include "td/db/DbKey.h"
 #include "td/db/SeqKeyValue.h"
+#include "td/db/SqliteCheckpointer.h"
 #include "td/db/SqliteConnectionSafe.h"
 #include "td/db/SqliteDb.h"
 #include "td/db/SqliteKeyValue.h"
+#include "td/db/SqliteKeyValueAsync.h"
 #include "td/db/SqliteKeyValueSafe.h"
 #include "td/db/TsSeqKeyValue.h"
 
@@ -26,16 +35,21 @@
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/FileFd.h"
+#include "td/utils/port/Stat.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
 #include "td/utils/tests.h"
 
 #include <limits>
 #include <map>
 #include <memory>
+#include <utility>
 
 template <class ContainerT>
 static typename ContainerT::value_type &rand_elem(ContainerT &cont) {
@@ -138,6 +152,231 @@ TEST(DB, binlog_encryption) {
   td::Binlog::destroy(binlog_name).ignore();
 }
 
+TEST(DB, binlog_background_reindex) {
+  td::CSlice binlog_name = "test_binlog";
+  for (auto db_key : {td::DbKey::empty(), td::DbKey::raw_key(td::string(32, 'A'))}) {
+    td::Binlog::destroy(binlog_name).ignore();
+
+    td::FlatHashMap<td::uint64, td::string> values;
+    td::int64 total_size = 0;
+    {
+      td::Binlog binlog;
+      binlog.init(binlog_name.str(), [](const td::BinlogEvent &x) {}, db_key).ensure();
+      td::vector<td::uint64> event_ids;
+      for (int i = 0; i < 100; i++) {
+        auto value = td::string(4, 'A');
+        auto event_id = binlog.add(1, td::create_storer(value));
+        event_ids.push_back(event_id);
+        values[event_id] = std::move(value);
+      }
+      for (int i = 0; i < 30000; i++) {
+        auto event_id = rand_elem(event_ids);
+        auto value = td::string(td::Random::fast(1, 250) * 4, static_cast<char>('a' + i % 26));
+        auto raw_event = td::BinlogEvent::create_raw(event_id, 1, td::BinlogEvent::Flags::Rewrite,
+                                                     td::create_storer(value));
+        total_size += static_cast<td::int64>(raw_event.size());
+        binlog.add_raw_event(std::move(raw_event), td::BinlogDebugInfo{__FILE__, __LINE__});
+        values[event_id] = std::move(value);
+      }
+      binlog.close().ensure();
+    }
+    auto r_stat = td::stat(binlog_name);
+    r_stat.ensure();
+    ASSERT_TRUE(r_stat.ok().size_ < total_size);
+
+    td::FlatHashMap<td::uint64, td::string> loaded_values;
+    td::Binlog binlog;
+    binlog.init(binlog_name.str(), [&](const td::BinlogEvent &x) { loaded_values[x.id_] = x.get_data().str(); },
+                db_key)
+        .ensure();
+    ASSERT_EQ(values.size(), loaded_values.size());
+    for (auto &it : values) {
+      ASSERT_EQ(it.second, loaded_values[it.first]);
+    }
+    binlog.close().ensure();
+  }
+  td::Binlog::destroy(binlog_name).ignore();
+}
+
+TEST(DB, binlog_append_after_replay) {
+  td::CSlice binlog_name = "test_binlog";
+  for (auto db_key : {td::DbKey::empty(), td::DbKey::raw_key(td::string(32, 'A'))}) {
+    td::Binlog::destroy(binlog_name).ignore();
+
+    td::FlatHashMap<td::uint64, td::string> values;
+    auto add_events = [&](td::Binlog &binlog, int count) {
+      for (int i = 0; i < count; i++) {
+        auto value = td::string(td::Random::fast(1, 1000) * 4, static_cast<char>('a' + i % 26));
+        auto event_id = binlog.add(1, td::create_storer(value));
+        values[event_id] = std::move(value);
+      }
+    };
+    auto load_binlog = [&](td::Binlog &binlog) {
+      td::FlatHashMap<td::uint64, td::string> loaded_values;
+      binlog.init(binlog_name.str(), [&](const td::BinlogEvent &x) { loaded_values[x.id_] = x.get_data().str(); },
+                  db_key)
+          .ensure();
+      ASSERT_EQ(values.size(), loaded_values.size());
+      for (auto &it : values) {
+        ASSERT_EQ(it.second, loaded_values[it.first]);
+      }
+    };
+
+    {
+      td::Binlog binlog;
+      load_binlog(binlog);
+      add_events(binlog, 1000);
+      binlog.close().ensure();
+    }
+    for (int i = 0; i < 3; i++) {
+      // events are reread from the file during replay and new events must be appended after them
+      td::Binlog binlog;
+      load_binlog(binlog);
+      add_events(binlog, 100);
+      binlog.close().ensure();
+    }
+    td::Binlog binlog;
+    load_binlog(binlog);
+    binlog.close().ensure();
+  }
+  td::Binlog::destroy(binlog_name).ignore();
+}
+
+TEST(DB, concurrent_binlog_group_sync) {
+  td::CSlice binlog_name = "test_binlog";
+  td::Binlog::destroy(binlog_name).ignore();
+
+  class Main final : public td::Actor {
+   public:
+    Main(td::string path, td::ConcurrentBinlog::SyncStats *stats) : path_(std::move(path)), stats_(stats) {
+    }
+
+    void start_up() final {
+      binlog_ = std::make_shared<td::ConcurrentBinlog>();
+      binlog_->init(path_, [](const td::BinlogEvent &x) {}).ensure();
+      td::ConcurrentBinlog::SyncOptions options;
+      options.max_force_sync_delay = 0.05;
+      options.max_force_sync_batch_size = 10;
+      binlog_->set_sync_options(options);
+
+      for (int i = 0; i < request_count_; i++) {
+        binlog_->add(1, td::create_storer(td::string(4, 'A')));
+        binlog_->force_sync(td::PromiseCreator::lambda([actor_id = actor_id(this)](td::Unit) {
+                              send_closure(actor_id, &Main::on_synced);
+                            }),
+                            "test");
+      }
+    }
+
+    void on_synced() {
+      if (++synced_count_ < request_count_) {
+        return;
+      }
+      binlog_->get_sync_stats(
+          td::PromiseCreator::lambda([actor_id = actor_id(this)](td::ConcurrentBinlog::SyncStats stats) {
+            send_closure(actor_id, &Main::on_sync_stats, stats);
+          }));
+    }
+
+    void on_sync_stats(td::ConcurrentBinlog::SyncStats stats) {
+      *stats_ = stats;
+      binlog_->close(td::PromiseCreator::lambda([](td::Unit) { td::Scheduler::instance()->finish(); }));
+      stop();
+    }
+
+   private:
+    td::string path_;
+    td::ConcurrentBinlog::SyncStats *stats_;
+    std::shared_ptr<td::ConcurrentBinlog> binlog_;
+    int request_count_ = 35;
+    int synced_count_ = 0;
+  };
+
+  td::ConcurrentBinlog::SyncStats stats;
+  td::ConcurrentScheduler sched(0, 0);
+  sched.create_actor_unsafe<Main>(0, "Main", binlog_name.str(), &stats).release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+
+  // three full batches are synced immediately and the remaining requests are synced together after the delay
+  ASSERT_EQ(4u, stats.sync_count);
+  ASSERT_EQ(35u, stats.force_sync_request_count);
+  ASSERT_EQ(35u, stats.synced_promise_count);
+  ASSERT_EQ(10u, stats.max_batch_size);
+  td::Binlog::destroy(binlog_name).ignore();
+}
+
+TEST(DB, concurrent_binlog_invalid_sync_options) {
+  td::CSlice binlog_name = "test_binlog";
+  td::Binlog::destroy(binlog_name).ignore();
+
+  class Main final : public td::Actor {
+   public:
+    Main(td::string path, td::ConcurrentBinlog::SyncStats *stats) : path_(std::move(path)), stats_(stats) {
+    }
+
+    void start_up() final {
+      binlog_ = std::make_shared<td::ConcurrentBinlog>();
+      binlog_->init(path_, [](const td::BinlogEvent &x) {}).ensure();
+      // invalid delays are clamped instead of failing
+      td::ConcurrentBinlog::SyncOptions options;
+      options.max_force_sync_delay = std::numeric_limits<double>::quiet_NaN();
+      options.lazy_sync_delay = -1.0;
+      binlog_->set_sync_options(options);
+
+      binlog_->add(1, td::create_storer(td::string(4, 'A')),
+                   td::PromiseCreator::lambda([actor_id = actor_id(this)](td::Unit) {
+                     send_closure(actor_id, &Main::on_synced);
+                   }));
+      binlog_->force_sync(td::PromiseCreator::lambda([actor_id = actor_id(this)](td::Unit) {
+                            send_closure(actor_id, &Main::on_synced);
+                          }),
+                          "test");
+    }
+
+    void on_synced() {
+      if (++synced_count_ < 2) {
+        return;
+      }
+      binlog_->get_sync_stats(
+          td::PromiseCreator::lambda([actor_id = actor_id(this)](td::ConcurrentBinlog::SyncStats stats) {
+            send_closure(actor_id, &Main::on_sync_stats, stats);
+          }));
+    }
+
+    void on_sync_stats(td::ConcurrentBinlog::SyncStats stats) {
+      *stats_ = stats;
+      binlog_->close(td::PromiseCreator::lambda([](td::Unit) { td::Scheduler::instance()->finish(); }));
+      stop();
+    }
+
+   private:
+    td::string path_;
+    td::ConcurrentBinlog::SyncStats *stats_;
+    std::shared_ptr<td::ConcurrentBinlog> binlog_;
+    int synced_count_ = 0;
+  };
+
+  td::ConcurrentBinlog::SyncStats stats;
+  td::ConcurrentScheduler sched(0, 0);
+  sched.create_actor_unsafe<Main>(0, "Main", binlog_name.str(), &stats).release();
+  sched.start();
+  auto start_time = td::Time::now();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+
+  // both the lazy and the forced sync are done without waiting for the default lazy sync delay
+  ASSERT_TRUE(td::Time::now() - start_time < 10.0);
+  ASSERT_EQ(1u, stats.force_sync_request_count);
+  ASSERT_TRUE(stats.sync_count >= 1u);
+  td::Binlog::destroy(binlog_name).ignore();
+}
+
 TEST(DB, sqlite_lfs) {
   td::string path = "test_sqlite_db";
   td::SqliteDb::destroy(path).ignore();
@@ -147,6 +386,184 @@ TEST(DB, sqlite_lfs) {
   td::SqliteDb::destroy(path).ignore();
 }
 
+TEST(DB, sqlite_statement_cache) {
+  td::string path = "test_sqlite_db";
+  td::SqliteDb::destroy(path).ignore();
+  auto db = td::SqliteDb::open_with_key(path, true, td::DbKey::empty()).move_as_ok();
+  db.exec("CREATE TABLE kv (k INT PRIMARY KEY, v BLOB)").ensure();
+  ASSERT_TRUE(db.has_table("kv").move_as_ok());
+  ASSERT_TRUE(!db.has_table("vk").move_as_ok());
+
+  td::vector<std::pair<int, td::string>> rows;
+  for (int i = 0; i < 100; i++) {
+    rows.emplace_back(i, td::to_string(i));
+  }
+  db.begin_write_transaction().ensure();
+  auto insert_stmt = db.get_cached_statement("INSERT INTO kv (k, v) VALUES (?1, ?2)").move_as_ok();
+  insert_stmt
+      ->execute_batch(td::as_span(rows),
+                      [](td::SqliteStatement &stmt, const std::pair<int, td::string> &row) {
+                        TRY_STATUS(stmt.bind_int32(1, row.first));
+                        return stmt.bind_blob(2, row.second);
+                      })
+      .ensure();
+  // the second insertion of the same keys must fail
+  auto status = insert_stmt->execute_batch(rows, [](td::SqliteStatement &stmt, const std::pair<int, td::string> &row) {
+    TRY_STATUS(stmt.bind_int32(1, row.first));
+    return stmt.bind_blob(2, row.second);
+  });
+  ASSERT_TRUE(status.is_error());
+  db.commit_transaction().ensure();
+
+  // the statement must stay valid while other statements are added to the cache
+  auto select_stmt = db.get_cached_statement("SELECT v FROM kv WHERE k = ?1").move_as_ok();
+  for (int i = 0; i < 10; i++) {
+    db.get_cached_statement(PSLICE() << "SELECT " << i << " FROM kv").ensure();
+  }
+  {
+    auto guard = select_stmt->guard();
+    select_stmt->bind_int32(1, 7).ensure();
+    select_stmt->step().ensure();
+    ASSERT_TRUE(select_stmt->has_row());
+    ASSERT_STREQ("7", select_stmt->view_blob(0));
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    auto key = td::Random::fast(0, 99);
+    // use more different statements than fit in the cache
+    auto stmt = db.get_cached_statement(PSLICE() << "SELECT v, " << i % 20 << " FROM kv WHERE k = ?1").move_as_ok();
+    auto guard = stmt->guard();
+    stmt->bind_int32(1, key).ensure();
+    stmt->step().ensure();
+    ASSERT_TRUE(stmt->has_row());
+    ASSERT_STREQ(td::to_string(key), stmt->view_blob(0));
+    ASSERT_EQ(i % 20, stmt->view_int32(1));
+  }
+  ASSERT_EQ(0, db.user_version().move_as_ok());
+  db.set_user_version(123).ensure();
+  ASSERT_EQ(123, db.user_version().move_as_ok());
+  db.close();
+  td::SqliteDb::destroy(path).ignore();
+}
+
+TEST(DB, sqlite_checkpointer) {
+  static constexpr td::int64 ROW_SIZE = 4000;
+
+  class Main final : public td::Actor {
+   public:
+    Main(td::string path, td::SqliteConnectionSettings settings) : path_(std::move(path)), settings_(settings) {
+    }
+
+    void start_up() final {
+      connection_ = std::make_shared<td::SqliteConnectionSafe>(path_, td::DbKey::empty(), td::optional<td::int32>(),
+                                                               settings_);
+      auto db = td::SqliteDb::open_with_key(path_, true, td::DbKey::empty()).move_as_ok();
+      connection_->init_connection(db).ensure();
+      connection_->set(std::move(db));
+
+      ASSERT_EQ(settings_.cache_size, get_pragma_value("cache_size"));
+      ASSERT_EQ(settings_.mmap_size, get_pragma_value("mmap_size"));
+      connection_->get().exec("CREATE TABLE kv (k INT PRIMARY KEY, v BLOB)").ensure();
+
+      // a big transaction is checkpointed inline only if the WAL file exceeds the profile's limit
+      auto database_size = get_database_size();
+      insert_rows(300);
+      if (settings_.max_wal_page_count <= 300) {
+        ASSERT_TRUE(get_database_size() >= database_size + 300 * ROW_SIZE);
+      } else {
+        ASSERT_EQ(database_size, get_database_size());
+      }
+
+      // a small transaction is checkpointed only after the database becomes idle
+      database_size = get_database_size();
+      insert_rows(100);
+      ASSERT_EQ(database_size, get_database_size());
+
+      checkpointer_ = td::create_sqlite_checkpointer(connection_, 0);
+      expected_database_size_ = database_size + 100 * ROW_SIZE;
+      deadline_ = td::Time::now() + 10;
+      set_timeout_in(0.1);
+    }
+
+    void timeout_expired() final {
+      if (get_database_size() < expected_database_size_) {
+        ASSERT_TRUE(td::Time::now() < deadline_);
+        set_timeout_in(0.1);
+        return;
+      }
+
+      // the checkpointer sleeps after the checkpoint and is woken up by the next commit
+      ASSERT_TRUE(!connection_->is_checkpointer_armed());
+      if (!is_changed_again_) {
+        is_changed_again_ = true;
+        auto database_size = get_database_size();
+        insert_rows(10);
+        ASSERT_TRUE(connection_->is_checkpointer_armed());
+        expected_database_size_ = database_size + 10 * ROW_SIZE;
+        deadline_ = td::Time::now() + 10;
+        set_timeout_in(0.1);
+        return;
+      }
+
+      checkpointer_->close(td::PromiseCreator::lambda([connection = connection_](td::Unit) {
+        connection->close();
+        td::Scheduler::instance()->finish();
+      }));
+      connection_.reset();
+      stop();
+    }
+
+   private:
+    td::string path_;
+    td::SqliteConnectionSettings settings_;
+    std::shared_ptr<td::SqliteConnectionSafe> connection_;
+    td::unique_ptr<td::SqliteCheckpointerInterface> checkpointer_;
+    td::int64 expected_database_size_ = 0;
+    double deadline_ = 0;
+    bool is_changed_again_ = false;
+    int next_key_ = 0;
+
+    td::int64 get_pragma_value(td::Slice name) {
+      auto stmt = connection_->get().get_statement(PSLICE() << "PRAGMA " << name).move_as_ok();
+      stmt.step().ensure();
+      CHECK(stmt.has_row());
+      return stmt.view_int64(0);
+    }
+
+    td::int64 get_database_size() const {
+      return td::stat(path_).move_as_ok().size_;
+    }
+
+    void insert_rows(int count) {
+      auto &db = connection_->get();
+      db.begin_write_transaction().ensure();
+      auto stmt = db.get_statement("INSERT INTO kv (k, v) VALUES (?1, ?2)").move_as_ok();
+      td::string value(static_cast<size_t>(ROW_SIZE), 'a');
+      for (int i = 0; i < count; i++) {
+        stmt.bind_int32(1, next_key_++).ensure();
+        stmt.bind_blob(2, value).ensure();
+        stmt.step().ensure();
+        stmt.reset();
+      }
+      db.commit_transaction().ensure();
+    }
+  };
+
+  td::string path = "test_sqlite_db";
+  for (auto settings :
+       {td::SqliteConnectionSettings::low_memory(), td::SqliteConnectionSettings::high_performance()}) {
+    td::SqliteDb::destroy(path).ignore();
+    td::ConcurrentScheduler sched(0, 0);
+    sched.create_actor_unsafe<Main>(0, "Main", path, settings).release();
+    sched.start();
+    while (sched.run_main(10)) {
+      // empty
+    }
+    sched.finish();
+  }
+  td::SqliteDb::destroy(path).ignore();
+}
+
 TEST(DB, sqlite_encryption) {
   td::string path = "test_sqlite_db";
   td::SqliteDb::destroy(path).ignore();
@@ -524,6 +941,135 @@ TEST(DB, key_value_set_all) {
   td::SqliteDb::destroy(sqlite_kv_name).ignore();
 }
 
+TEST(DB, key_value_async) {
+  td::string path = "test_sqlite_kv_async";
+  td::SqliteDb::destroy(path).ignore();
+
+  class Main final : public td::Actor {
+   public:
+    explicit Main(td::string path) : path_(std::move(path)) {
+    }
+
+   private:
+    td::string path_;
+    std::shared_ptr<td::SqliteConnectionSafe> sql_connection_;
+    td::unique_ptr<td::SqliteKeyValueAsyncInterface> kv_;
+    td::SqliteKeyValueAsyncInterface::Stats stats_;
+
+    void get_stats(td::Promise<td::Unit> promise) {
+      kv_->get_stats(td::PromiseCreator::lambda(
+          [actor_id = actor_id(this), promise = std::move(promise)](td::SqliteKeyValueAsyncInterface::Stats stats) mutable {
+            send_closure(actor_id, &Main::on_get_stats, std::move(stats), std::move(promise));
+          }));
+    }
+
+    void on_get_stats(td::SqliteKeyValueAsyncInterface::Stats stats, td::Promise<td::Unit> promise) {
+      stats_ = stats;
+      promise.set_value(td::Unit());
+    }
+
+    void check_get(const td::string &key, td::string expected_value) {
+      kv_->get(key, td::PromiseCreator::lambda([key, expected_value = std::move(expected_value)](td::string value) {
+                 LOG_CHECK(value == expected_value) << key;
+               }));
+    }
+
+    void start_up() final {
+      sql_connection_ = std::make_shared<td::SqliteConnectionSafe>(path_, td::DbKey::empty());
+      auto db = td::SqliteDb::open_with_key(path_, true, td::DbKey::empty()).move_as_ok();
+      sql_connection_->init_connection(db).ensure();
+      sql_connection_->set(std::move(db));
+      kv_ = td::create_sqlite_key_value_async(std::make_shared<td::SqliteKeyValueSafe>("kv", sql_connection_), 0);
+
+      // the first 100 writes are committed together as soon as the last of them is received
+      for (int i = 0; i < 100; i++) {
+        kv_->set(PSTRING() << "key" << i, PSTRING() << "value" << i, td::Promise<td::Unit>());
+      }
+      kv_->set("key0", "first", td::Promise<td::Unit>());
+      kv_->set("key0", "second", td::PromiseCreator::lambda([actor_id = actor_id(this)](td::Unit) {
+                 send_closure(actor_id, &Main::on_flushed);
+               }));
+      kv_->erase("key1", td::Promise<td::Unit>());
+
+      // values are returned from the pending writes, from the cache or from the database
+      check_get("key0", "second");
+      check_get("key1", "");
+      check_get("key2", "value2");
+      check_get("absent", "");
+      check_get("absent", "");
+      get_stats(td::PromiseCreator::lambda([this](td::Unit) {
+        ASSERT_EQ(103u, stats_.write_count);
+        ASSERT_EQ(1u, stats_.coalesced_write_count);
+        ASSERT_EQ(1u, stats_.commit_count);
+        ASSERT_EQ(5u, stats_.get_count);
+        ASSERT_EQ(4u, stats_.cache_hit_count);
+        ASSERT_TRUE(stats_.max_pending_write_count >= 100u);
+      }));
+    }
+
+    void on_flushed() {
+      // the remaining writes are committed after a delay
+      get_stats(td::PromiseCreator::lambda([this](td::Unit) {
+        ASSERT_EQ(2u, stats_.commit_count);
+        check_get("key0", "second");
+        check_get("key1", "");
+        check_big_values();
+      }));
+    }
+
+    void check_big_values() {
+      // the values don't fit in the cache together
+      td::FlatHashMap<td::string, td::string> key_values;
+      for (int i = 0; i < 100; i++) {
+        key_values[PSTRING() << "big" << i] = td::string(1 << 16, static_cast<char>('a' + i % 26));
+      }
+      td::vector<std::pair<td::string, td::string>> sorted_key_values;
+      for (auto &it : key_values) {
+        sorted_key_values.emplace_back(it.first, it.second);
+      }
+      kv_->set_all(std::move(key_values), td::Promise<td::Unit>());
+      get_stats(td::PromiseCreator::lambda([this, sorted_key_values = std::move(sorted_key_values)](td::Unit) {
+        auto old_stats = stats_;
+        // the most recently written values are read first while they are still cached
+        for (auto it = sorted_key_values.rbegin(); it != sorted_key_values.rend(); ++it) {
+          check_get(it->first, it->second);
+        }
+        check_get(sorted_key_values[0].first, sorted_key_values[0].second);
+        get_stats(td::PromiseCreator::lambda([this, old_stats](td::Unit) {
+          ASSERT_EQ(old_stats.get_count + 101, stats_.get_count);
+          auto cache_hit_count = stats_.cache_hit_count - old_stats.cache_hit_count;
+          // some values were evicted from the cache, but the value, which was just read, is cached
+          ASSERT_TRUE(cache_hit_count > 1u);
+          ASSERT_TRUE(cache_hit_count < 100u);
+          close();
+        }));
+      }));
+    }
+
+    void close() {
+      kv_->close(td::PromiseCreator::lambda([actor_id = actor_id(this)](td::Unit) {
+        send_closure(actor_id, &Main::on_closed);
+      }));
+    }
+
+    void on_closed() {
+      kv_.reset();
+      sql_connection_->close();
+      td::Scheduler::instance()->finish();
+      stop();
+    }
+  };
+
+  td::ConcurrentScheduler sched(0, 0);
+  sched.create_actor_unsafe<Main>(0, "Main", path).release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+  td::SqliteDb::destroy(path).ignore();
+}
+
 #if !TD_THREAD_UNSUPPORTED
 TEST(DB, thread_key_value) {
   td::vector<td::string> keys;
@@ -807,3 +1353,109 @@ TEST(DB, persistent_key_value) {
   }
   td::SqliteDb::destroy(path).ignore();
 }
+
+TEST(DB, message_db_concurrent_read_write) {
+  td::string path = "test_message_db";
+  td::SqliteDb::destroy(path).ignore();
+
+  constexpr int DIALOG_COUNT = 10;
+  constexpr int MESSAGE_COUNT = 3000;
+  constexpr int READ_LIMIT = 5;
+
+  class Main final : public td::Actor {
+   public:
+    explicit Main(td::string path) : path_(std::move(path)) {
+    }
+
+   private:
+    td::string path_;
+    std::shared_ptr<td::SqliteConnectionSafe> sql_connection_;
+    std::shared_ptr<td::MessageDbAsyncInterface> message_db_async_;
+    td::FlatHashMap<td::int64, int> last_read_message_;
+    int pending_read_count_ = 0;
+
+    static td::DialogId get_dialog_id(int i) {
+      return td::DialogId(td::UserId(static_cast<td::int64>(i % DIALOG_COUNT + 1)));
+    }
+
+    static td::MessageId get_message_id(int i) {
+      return td::MessageId(td::ServerMessageId(i + 1));
+    }
+
+    void start_up() final {
+      sql_connection_ = std::make_shared<td::SqliteConnectionSafe>(path_, td::DbKey::empty());
+      auto new_db = td::SqliteDb::open_with_key(path_, true, td::DbKey::empty()).move_as_ok();
+      sql_connection_->init_connection(new_db).ensure();
+      sql_connection_->set(std::move(new_db));
+      auto &db = sql_connection_->get();
+      db.exec("BEGIN TRANSACTION").ensure();
+      td::init_message_db(db, 0).ensure();
+      db.exec("COMMIT TRANSACTION").ensure();
+
+      // messages are written on the scheduler 1 and read on the scheduler 2
+      message_db_async_ = td::create_message_db_async(td::create_message_db_sync(sql_connection_), 1, {2});
+      for (int i = 0; i < MESSAGE_COUNT; i++) {
+        auto dialog_id = get_dialog_id(i);
+        auto server_message_id = td::ServerMessageId(i + 1);
+        message_db_async_->add_message({dialog_id, get_message_id(i)}, server_message_id, td::DialogId(), i + 1, 0, 0,
+                                       0, "", td::NotificationId(), td::MessageId(),
+                                       td::BufferSlice(PSLICE() << "message " << i), td::Promise<td::Unit>());
+        if (i % 3 != 0) {
+          continue;
+        }
+
+        td::MessageDbMessagesQuery query;
+        query.dialog_id = dialog_id;
+        // the next message from the chat may be added concurrently, so it is excluded
+        query.from_message_id = get_message_id(i + DIALOG_COUNT);
+        query.limit = READ_LIMIT;
+        pending_read_count_++;
+        message_db_async_->get_messages(
+            std::move(query), td::PromiseCreator::lambda([actor_id = actor_id(this), i](
+                                                             td::vector<td::MessageDbDialogMessage> messages) {
+              send_closure(actor_id, &Main::on_get_messages, i, std::move(messages));
+            }));
+      }
+    }
+
+    void on_get_messages(int i, td::vector<td::MessageDbDialogMessage> messages) {
+      // the read must see all messages from the chat added before it
+      int expected_count = i / DIALOG_COUNT + 1;
+      if (expected_count > READ_LIMIT) {
+        expected_count = READ_LIMIT;
+      }
+      ASSERT_EQ(static_cast<size_t>(expected_count), messages.size());
+      for (int j = 0; j < expected_count; j++) {
+        auto message_i = i - j * DIALOG_COUNT;
+        ASSERT_EQ(get_message_id(message_i), messages[j].message_id);
+        ASSERT_EQ(PSTRING() << "message " << message_i, messages[j].data.as_slice());
+      }
+
+      // results of reads from the same chat must be returned in order
+      auto &last_read_message = last_read_message_[get_dialog_id(i).get()];
+      ASSERT_TRUE(last_read_message < i + 1);
+      last_read_message = i + 1;
+
+      if (--pending_read_count_ == 0) {
+        message_db_async_->close(td::PromiseCreator::lambda(
+            [actor_id = actor_id(this)](td::Unit) { send_closure(actor_id, &Main::on_closed); }));
+      }
+    }
+
+    void on_closed() {
+      message_db_async_.reset();
+      sql_connection_->close();
+      td::Scheduler::instance()->finish();
+      stop();
+    }
+  };
+
+  td::ConcurrentScheduler sched(2, 0);
+  sched.create_actor_unsafe<Main>(0, "Main", path).release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+  td::SqliteDb::destroy(path).ignore();
+}
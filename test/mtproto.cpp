@@ -5,15 +5,21 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 #include "td/telegram/ConfigManager.h"
+#include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryCreator.h"
 #include "td/telegram/net/PublicRsaKeySharedMain.h"
+#include "td/telegram/net/SessionLoadBalancer.h"
+#include "td/telegram/net/WarmConnectionPool.h"
 #include "td/telegram/NotificationManager.h"
 #include "td/telegram/telegram_api.h"
 
 #include "td/mtproto/AuthData.h"
+#include "td/mtproto/ContainerPacker.h"
 #include "td/mtproto/DhCallback.h"
 #include "td/mtproto/DhHandshake.h"
 #include "td/mtproto/Handshake.h"
 #include "td/mtproto/HandshakeActor.h"
+#include "td/mtproto/MessageId.h"
 #include "td/mtproto/Ping.h"
 #include "td/mtproto/PingConnection.h"
 #include "td/mtproto/ProxySecret.h"
@@ -35,6 +41,7 @@
 #include "td/utils/crypto.h"
 #include "td/utils/HttpDate.h"
 #include "td/utils/logging.h"
+#include "td/utils/ObjectPool.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/IPAddress.h"
 #include "td/utils/port/SocketFd.h"
@@ -46,6 +53,7 @@
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
 
+#include <cmath>
 #include <memory>
 
 TEST(Mtproto, GetHostByNameActor) {
@@ -722,6 +730,219 @@ TEST(Mtproto, TlsTransport) {
   sched.finish();
 }
 
+TEST(Mtproto, ContainerPacker) {
+  auto is_close = [](double lhs, double rhs) {
+    return std::abs(lhs - rhs) < 1e-9;
+  };
+
+  td::mtproto::ContainerPacker fixed_packer(false);
+  fixed_packer.on_packet_sent({td::mtproto::MessageId(static_cast<td::uint64>(1))}, 10000, 9000, 5, false, 0.0);
+  fixed_packer.on_message_ack(td::mtproto::MessageId(static_cast<td::uint64>(1)), 0.1);
+  ASSERT_EQ(static_cast<size_t>(1 << 15), fixed_packer.get_max_container_size());
+  ASSERT_TRUE(is_close(0.001, fixed_packer.get_flush_delay(1 << 20, 0.1)));
+
+  td::mtproto::ContainerPacker packer;
+  ASSERT_EQ(static_cast<size_t>(1 << 15), packer.get_max_container_size());
+  ASSERT_TRUE(is_close(0.001, packer.get_flush_delay(100, 0.0)));
+
+  // RTT is 0.1 and bandwidth is 100000 bytes per second, so the bandwidth-delay product is 10000 bytes
+  packer.on_packet_sent({td::mtproto::MessageId(static_cast<td::uint64>(1)),
+                         td::mtproto::MessageId(static_cast<td::uint64>(2))},
+                        10000, 9000, 5, false, 0.0);
+  ASSERT_EQ(10000u, packer.get_outstanding_bytes());
+  packer.on_message_ack(td::mtproto::MessageId(static_cast<td::uint64>(2)), 0.1);
+  packer.on_message_ack(td::mtproto::MessageId(static_cast<td::uint64>(1)), 0.2);
+  packer.on_message_ack(td::mtproto::MessageId(static_cast<td::uint64>(3)), 0.2);
+  ASSERT_EQ(0u, packer.get_outstanding_bytes());
+  ASSERT_EQ(static_cast<size_t>(1 << 13), packer.get_max_container_size());
+  ASSERT_TRUE(is_close(0.001, packer.get_flush_delay(100, 0.1)));
+
+  // the network is saturated, so queries are held to be sent together
+  packer.on_packet_sent({td::mtproto::MessageId(static_cast<td::uint64>(4))}, 20000, 20000, 10, false, 0.1);
+  ASSERT_EQ(20000u, packer.get_outstanding_bytes());
+  ASSERT_TRUE(is_close(0.0125, packer.get_flush_delay(100, 0.1)));
+  ASSERT_TRUE(is_close(0.0, packer.get_flush_delay(1 << 13, 0.1)));
+
+  packer.on_message_ack(td::mtproto::MessageId(static_cast<td::uint64>(4)), 0.3);
+  ASSERT_EQ(0u, packer.get_outstanding_bytes());
+  auto stats = packer.get_stats();
+  ASSERT_EQ(2u, stats.packet_count);
+  ASSERT_EQ(15u, stats.query_count);
+  ASSERT_EQ(30000u, stats.sent_bytes);
+  ASSERT_EQ(30000u, stats.acked_bytes);
+  ASSERT_TRUE(is_close(0.1125, stats.rtt));
+  ASSERT_TRUE(is_close(0.1, stats.min_rtt));
+
+  // unacknowledged packets are forgotten after a timeout
+  packer.on_packet_sent({td::mtproto::MessageId(static_cast<td::uint64>(5))}, 5000, 5000, 1, false, 1.0);
+  packer.on_packet_sent({td::mtproto::MessageId(static_cast<td::uint64>(6))}, 1000, 1000, 1, false, 10.0);
+  ASSERT_EQ(1000u, packer.get_outstanding_bytes());
+  packer.on_message_ack(td::mtproto::MessageId(static_cast<td::uint64>(5)), 10.0);
+  ASSERT_EQ(1000u, packer.get_outstanding_bytes());
+}
+
+TEST(Mtproto, SessionLoadBalancer) {
+  auto is_close = [](double lhs, double rhs) {
+    return std::abs(lhs - rhs) < 1e-9;
+  };
+
+  td::SessionLoadBalancer balancer(3);
+  for (size_t i = 0; i < 3; i++) {
+    balancer.on_connection_state_changed(i, true);
+  }
+  balancer.on_query_sent(1, 1, 0, 100, 0.0);
+  balancer.on_query_sent(2, 2, 1, 100, 0.0);
+  balancer.on_query_sent(3, 3, 2, 100, 0.0);
+  ASSERT_EQ(0u, balancer.on_query_finished(1, 1, true, 0.05));
+  ASSERT_EQ(1u, balancer.on_query_finished(2, 2, true, 1.0));
+  ASSERT_EQ(2u, balancer.on_query_finished(3, 3, true, 0.1));
+  ASSERT_EQ(td::SessionLoadBalancer::NO_SESSION, balancer.on_query_finished(3, 3, true, 0.1));
+  ASSERT_EQ(0u, balancer.choose_session(100, 1.0));
+  ASSERT_EQ(2u, balancer.choose_session(100, 1.0, 0));
+
+  // a big query occupies the fastest session
+  balancer.on_query_sent(4, 4, 0, 1 << 20, 1.0);
+  ASSERT_EQ(2u, balancer.choose_session(100, 1.0));
+
+  // a stalled session isn't chosen
+  balancer.on_query_sent(5, 5, 2, 100, 1.0);
+  ASSERT_EQ(2u, balancer.get_query_session_id(5));
+  ASSERT_EQ(1u, balancer.choose_session(100, 3.0));
+
+  // a new connection must be established before a query can be sent
+  balancer.on_connection_state_changed(1, false);
+  ASSERT_EQ(0u, balancer.choose_session(100, 3.0));
+
+  ASSERT_TRUE(is_close(1.3, balancer.get_hedge_at(5)));
+  ASSERT_TRUE(is_close(0.0, balancer.get_hedge_at(1)));
+  ASSERT_TRUE(!balancer.can_hedge());
+  for (td::uint64 query_id = 100; query_id < 120; query_id++) {
+    balancer.on_query_sent(query_id, query_id, 0, 100, 3.0);
+    balancer.on_query_finished(query_id, query_id, false, 3.0);
+  }
+  ASSERT_TRUE(balancer.can_hedge());
+  balancer.on_query_hedged(1);
+  balancer.on_hedged_query_won(1);
+  ASSERT_TRUE(!balancer.can_hedge());
+
+  auto stats = balancer.get_stats(0);
+  ASSERT_EQ(1, stats.query_count);
+  ASSERT_EQ(static_cast<td::uint64>(1 << 20), stats.outstanding_bytes);
+  ASSERT_EQ(22u, stats.sent_query_count);
+  ASSERT_TRUE(stats.is_connected);
+  stats = balancer.get_stats(1);
+  ASSERT_EQ(0, stats.query_count);
+  ASSERT_EQ(1u, stats.hedged_query_count);
+  ASSERT_EQ(1u, stats.won_hedged_query_count);
+  ASSERT_TRUE(!stats.is_connected);
+
+  // a late notification about a previous sending of a query doesn't finish the query sent again
+  balancer.on_query_sent(200, 1, 2, 100, 4.0);
+  balancer.on_query_sent(200, 2, 2, 100, 4.0);
+  ASSERT_EQ(td::SessionLoadBalancer::NO_SESSION, balancer.on_query_finished(200, 1, true, 4.1));
+  ASSERT_EQ(2u, balancer.get_query_session_id(200));
+  ASSERT_EQ(2, balancer.get_stats(2).query_count);
+  ASSERT_EQ(2u, balancer.on_query_finished(200, 2, true, 4.1));
+  ASSERT_EQ(1, balancer.get_stats(2).query_count);
+}
+
+TEST(Mtproto, NetQueryCopyCancellation) {
+  // creation of queries needs Global, so only copies are linked by NetQueryCreator in the same way as in create_copy
+  td::ObjectPool<td::NetQuery> object_pool;
+  auto create_query = [&object_pool] {
+    auto query = object_pool.create();
+    query->resend();
+    query->set_cancellation_token(query.generation());
+    return query;
+  };
+  auto create_copy = [&object_pool](td::NetQueryPtr &query) {
+    auto copy = object_pool.create();
+    copy->resend();
+    td::NetQueryCreator::init_copy(copy, query);
+    return copy;
+  };
+
+  auto query = create_query();
+  query->file_type_ = 5;
+  auto query_ref = query.get_weak();
+  auto copy = create_copy(query);
+  auto other_copy = create_copy(query);
+  ASSERT_TRUE(!copy->update_is_ready());
+  ASSERT_EQ(5, copy->file_type_);
+
+  // copies are canceled together with the original query
+  td::cancel_query(query_ref);
+  ASSERT_TRUE(copy->update_is_ready());
+  ASSERT_EQ(td::NetQuery::Error::Canceled, copy->error().code());
+  ASSERT_TRUE(other_copy->update_is_ready());
+  ASSERT_TRUE(query->update_is_ready());
+
+  // a copy isn't canceled after the original query is destroyed, even if the memory of the query is reused
+  auto destroyed_query = create_query();
+  auto orphan_copy = create_copy(destroyed_query);
+  destroyed_query->set_error_canceled();
+  destroyed_query.reset();
+  auto new_query = create_query();
+  auto new_query_ref = new_query.get_weak();
+  td::cancel_query(new_query_ref);
+  ASSERT_TRUE(new_query->update_is_ready());
+  ASSERT_TRUE(!orphan_copy->update_is_ready());
+  orphan_copy->set_error_canceled();
+}
+
+TEST(Mtproto, WarmConnectionPool) {
+  td::WarmConnectionPool pool;
+  ASSERT_EQ(0u, pool.get_warm_connection_count(0.0, 2));
+
+  // a single request keeps a connection warm for DEMAND_DECAY_TIME * ln(2) seconds
+  pool.on_request(0.0);
+  ASSERT_EQ(0u, pool.get_warm_connection_count(0.0, 0));
+  ASSERT_EQ(1u, pool.get_warm_connection_count(0.0, 2));
+  ASSERT_EQ(1u, pool.get_warm_connection_count(41.0, 2));
+  ASSERT_EQ(0u, pool.get_warm_connection_count(42.0, 2));
+
+  // demand is decayed before new requests are added
+  pool.on_request(100.0);
+  pool.on_request(100.0);
+  pool.on_request(100.0);
+  ASSERT_EQ(2u, pool.get_warm_connection_count(100.0, 2));
+  ASSERT_EQ(3u, pool.get_warm_connection_count(100.0, 8));
+  ASSERT_EQ(1u, pool.get_warm_connection_count(160.0, 8));
+  ASSERT_EQ(3u, pool.get_warm_connection_count(50.0, 8));
+
+  // expired connections are dropped only above the warm connection count
+  ASSERT_TRUE(!pool.can_drop_expired_connection(2, 2));
+  ASSERT_TRUE(pool.can_drop_expired_connection(3, 2));
+  ASSERT_EQ(1u, pool.get_preconnect_count(1, 2));
+  ASSERT_EQ(0u, pool.get_preconnect_count(3, 2));
+
+  // connections being checked are counted as spare
+  ASSERT_TRUE(!pool.need_health_check(0.0, td::WarmConnectionPool::HEALTH_CHECK_PERIOD));
+  ASSERT_TRUE(pool.need_health_check(0.0, td::WarmConnectionPool::HEALTH_CHECK_PERIOD + 0.1));
+  pool.on_health_check_started();
+  pool.on_health_check_started();
+  ASSERT_EQ(2u, pool.get_health_checking_connection_count());
+  ASSERT_EQ(0u, pool.get_preconnect_count(0, 2));
+  ASSERT_TRUE(pool.can_drop_expired_connection(1, 2));
+
+  // a dead connection is dropped and replaced, an alive connection is kept
+  ASSERT_TRUE(!pool.on_health_check_finished(false));
+  ASSERT_EQ(1u, pool.get_preconnect_count(0, 2));
+  ASSERT_TRUE(pool.on_health_check_finished(true));
+  ASSERT_EQ(0u, pool.get_health_checking_connection_count());
+  ASSERT_EQ(0u, pool.get_preconnect_count(2, 2));
+  ASSERT_EQ(2u, pool.get_stats().health_check_count);
+  ASSERT_EQ(1u, pool.get_stats().failed_health_check_count);
+
+  pool.on_connection_created(0.5);
+  pool.on_connection_returned(true, 0.5, 0.1);
+  pool.on_connection_returned(false, 0.5, 1.0);
+  ASSERT_EQ(1u, pool.get_stats().created_connection_count);
+  ASSERT_EQ(2u, pool.get_stats().returned_connection_count);
+  ASSERT_EQ(1u, pool.get_stats().warm_connection_count);
+  ASSERT_TRUE(std::abs(pool.get_stats().saved_handshake_time - 0.4) < 1e-9);
+}
+
 TEST(Mtproto, RSA) {
   auto pem = td::Slice(
       "-----BEGIN RSA PUBLIC KEY-----\n"
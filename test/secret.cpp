@@ -400,8 +400,9 @@ class FakeBinlog final
   template <class F>
   void for_each(const F &f) {
     events_processor_.for_each([&](auto &x) {
-      LOG(INFO) << "REPLAY: " << x.id_;
-      f(x);
+      auto &event = events_[x.offset_];
+      LOG(INFO) << "REPLAY: " << event.id_;
+      f(event);
     });
   }
 
@@ -446,7 +447,9 @@ class FakeBinlog final
       auto event = std::move(pending.event);
       if (!event.is_empty()) {
         LOG(INFO) << "SAVE EVENT: " << event.id_ << " " << event;
-        events_processor_.add_event(std::move(event)).ensure();
+        event.offset_ = ++last_offset_;
+        events_processor_.add_event(event.clone()).ensure();
+        events_.emplace(event.offset_, std::move(event));
       }
       append(promises, std::move(pending.promises_));
     }
@@ -471,6 +474,9 @@ class FakeBinlog final
   bool has_request_sync = false;
   uint64 last_event_id_ = 1;
   detail::BinlogEventsProcessor events_processor_;
+  // the processor keeps only offsets of the events, so the events themselves are kept by their fake offset
+  int64 last_offset_ = 0;
+  std::map<int64, BinlogEvent> events_;
 
   struct PendingEvent {
     BinlogEvent event;
@@ -11,6 +11,8 @@
 #include "td/telegram/files/PartsManager.h"
 #include "td/telegram/td_api.h"
 
+#include "td/tl/tl_object_store.h"
+
 #include "td/actor/actor.h"
 #include "td/actor/ConcurrentScheduler.h"
 #include "td/actor/PromiseFuture.h"
@@ -28,11 +30,16 @@
 #include "td/utils/port/thread.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Random.h"
+#include "td/utils/ScopeGuard.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/tests.h"
+#include "td/utils/Time.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdio>
 #include <functional>
@@ -970,6 +977,113 @@ TEST(Client, Manager) {
   }
 }
 
+TEST(Client, ManagerReceiveBatch) {
+  td::ClientManager client;
+
+  // nothing is received before the timeout expires
+  auto start_time = td::Time::now();
+  auto responses = client.receive_batch(100, 0.1);
+  ASSERT_TRUE(responses.empty());
+  ASSERT_TRUE(td::Time::now() < start_time + 5);
+
+  for (int i = 0; i < 10; i++) {
+    client.send(0, i + 1, td::make_tl_object<td::td_api::testSquareInt>(3));
+  }
+  td::vector<td::ClientManager::Response> received;
+  while (received.size() < 10u) {
+    responses = client.receive_batch(3, 10);
+    ASSERT_TRUE(responses.size() <= 3u);
+    for (auto &response : responses) {
+      received.push_back(std::move(response));
+    }
+  }
+  for (size_t i = 0; i < received.size(); i++) {
+    ASSERT_EQ(i + 1, received[i].request_id);
+    ASSERT_TRUE(received[i].object != nullptr);
+  }
+
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  // a waiting receive_batch is woken up by a response before the timeout expires
+  start_time = td::Time::now();
+  td::thread thread([&client] {
+    td::usleep_for(100000);
+    client.send(0, 11, td::make_tl_object<td::td_api::testSquareInt>(3));
+  });
+  responses.clear();
+  while (responses.empty()) {
+    responses = client.receive_batch(100, 100);
+  }
+  thread.join();
+  ASSERT_EQ(1u, responses.size());
+  ASSERT_EQ(11u, responses[0].request_id);
+  ASSERT_TRUE(td::Time::now() < start_time + 50);
+#endif
+}
+
+#if !TD_ENABLE_JNI  // JNI-compatible TDLib API can't be serialized in binary form
+TEST(Client, TlBinary) {
+  td::vector<td::td_api::object_ptr<td::td_api::textEntity>> entities;
+  entities.push_back(
+      td::td_api::make_object<td::td_api::textEntity>(0, 1, td::td_api::make_object<td::td_api::textEntityTypeBold>()));
+  entities.push_back(td::td_api::make_object<td::td_api::textEntity>(1, 2, nullptr));
+  auto text = td::td_api::make_object<td::td_api::formattedText>("text", std::move(entities));
+
+  td::TlStorerCalcLength calc_length;
+  td::TlStoreNullableBoxedUnknown<td::TlStoreObject>::store(text, calc_length);
+  td::vector<td::int32> buf(calc_length.get_length() / 4);
+  td::TlStorerUnsafe storer(reinterpret_cast<unsigned char *>(buf.data()));
+  td::TlStoreNullableBoxedUnknown<td::TlStoreObject>::store(text, storer);
+
+  td::TlParser parser(td::Slice(reinterpret_cast<const char *>(buf.data()), buf.size() * 4));
+  auto object = td::td_api::Object::fetch(parser);
+  parser.fetch_end();
+  ASSERT_TRUE(parser.get_error() == nullptr);
+  ASSERT_EQ(to_string(text), to_string(object));
+
+  // setOption name:string value:OptionValue with null value
+  td::int32 request[] = {td::td_api::setOption::ID, 0x63626103, 0};
+  td::TlParser request_parser(td::Slice(reinterpret_cast<const char *>(request), sizeof(request)));
+  auto function = td::td_api::Function::fetch(request_parser);
+  request_parser.fetch_end();
+  ASSERT_TRUE(request_parser.get_error() == nullptr);
+  ASSERT_EQ(td::td_api::setOption::ID, function->get_id());
+  auto set_option = td::move_tl_object_as<td::td_api::setOption>(function);
+  ASSERT_EQ("abc", set_option->name_);
+  ASSERT_TRUE(set_option->value_ == nullptr);
+}
+
+TEST(Client, TlBinaryVector) {
+  // formattedText text:string entities:vector<textEntity> with a bare vector of two entities, the second of which is null
+  td::int32 payload[] = {td::td_api::formattedText::ID,
+                         0x00626102,
+                         2,
+                         td::td_api::textEntity::ID,
+                         0,
+                         1,
+                         td::td_api::textEntityTypeBold::ID,
+                         0};
+  td::TlParser parser(td::Slice(reinterpret_cast<const char *>(payload), sizeof(payload)));
+  auto object = td::td_api::Object::fetch(parser);
+  parser.fetch_end();
+  ASSERT_TRUE(parser.get_error() == nullptr);
+  ASSERT_EQ(td::td_api::formattedText::ID, object->get_id());
+  auto &text = static_cast<const td::td_api::formattedText &>(*object);
+  ASSERT_EQ("ab", text.text_);
+  ASSERT_EQ(2u, text.entities_.size());
+  ASSERT_EQ(1, text.entities_[0]->length_);
+  ASSERT_EQ(td::td_api::textEntityTypeBold::ID, text.entities_[0]->type_->get_id());
+  ASSERT_TRUE(text.entities_[1] == nullptr);
+
+  td::TlStorerCalcLength calc_length;
+  td::TlStoreNullableBoxedUnknown<td::TlStoreObject>::store(object, calc_length);
+  ASSERT_EQ(sizeof(payload), calc_length.get_length());
+  td::int32 buf[sizeof(payload) / 4];
+  td::TlStorerUnsafe storer(reinterpret_cast<unsigned char *>(buf));
+  td::TlStoreNullableBoxedUnknown<td::TlStoreObject>::store(object, storer);
+  ASSERT_TRUE(std::equal(buf, buf + sizeof(payload) / 4, payload));
+}
+#endif
+
 #if !TD_EVENTFD_UNSUPPORTED  // Client must be used from a single thread if there is no EventFd
 TEST(Client, Close) {
   std::atomic<bool> stop_send{false};
@@ -1179,6 +1293,70 @@ TEST(Client, ManagerCloseOneThread) {
   ASSERT_TRUE(sent_requests.empty());
 }
 
+TEST(Client, ManagerDatabaseWithoutAdditionalThreads) {
+  td::ClientManager::ThreadOptions thread_options;
+  thread_options.instance_count = 1;
+  thread_options.additional_thread_count = 0;
+  td::ClientManager::set_thread_options(thread_options);
+  SCOPE_EXIT {
+    td::ClientManager::set_thread_options(td::ClientManager::ThreadOptions());
+  };
+
+  td::string database_directory = "tdclient_no_threads";
+  td::rmrf(database_directory).ignore();
+
+  td::ClientManager client_manager;
+  auto client_id = client_manager.create_client_id();
+  client_manager.send(client_id, 1, td::make_tl_object<td::td_api::getOption>("version"));
+
+  bool is_closed = false;
+  bool was_database_opened = false;
+  while (!is_closed) {
+    auto response = client_manager.receive(10.0);
+    if (response.object == nullptr) {
+      continue;
+    }
+    if (response.request_id != 0) {
+      LOG_CHECK(response.object->get_id() != td::td_api::error::ID) << to_string(response.object);
+      continue;
+    }
+    if (response.object->get_id() != td::td_api::updateAuthorizationState::ID) {
+      continue;
+    }
+    auto &update = static_cast<td::td_api::updateAuthorizationState &>(*response.object);
+    switch (update.authorization_state_->get_id()) {
+      case td::td_api::authorizationStateWaitTdlibParameters::ID: {
+        auto request = td::td_api::make_object<td::td_api::setTdlibParameters>();
+        request->use_test_dc_ = true;
+        request->database_directory_ = database_directory + TD_DIR_SLASH;
+        request->use_file_database_ = true;
+        request->use_chat_info_database_ = true;
+        request->use_message_database_ = true;
+        request->api_id_ = 94575;
+        request->api_hash_ = "a3406de8d171bb422bb6ddf3bbd800e2";
+        request->system_language_code_ = "en";
+        request->device_model_ = "Desktop";
+        request->application_version_ = "tdclient-test";
+        client_manager.send(client_id, 2, std::move(request));
+        break;
+      }
+      case td::td_api::authorizationStateWaitPhoneNumber::ID:
+        // all database actors have been created on the only available scheduler
+        was_database_opened = true;
+        client_manager.send(client_id, 3, td::make_tl_object<td::td_api::close>());
+        break;
+      case td::td_api::authorizationStateClosed::ID:
+        is_closed = true;
+        break;
+      default:
+        break;
+    }
+  }
+  ASSERT_TRUE(was_database_opened);
+
+  td::rmrf(database_directory).ignore();
+}
+
 TEST(PartsManager, hands) {
   {
     td::PartsManager pm;
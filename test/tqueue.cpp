@@ -13,6 +13,8 @@
 #include "td/utils/common.h"
 #include "td/utils/int_types.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/sleep.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
@@ -20,6 +22,7 @@
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
 
+#include <atomic>
 #include <memory>
 #include <utility>
 
@@ -258,3 +261,82 @@ TEST(TQueue, clear) {
   CHECK(tqueue->get_tail(1) == tail_id);
   CHECK(deleted_events.size() == 100000 - keep_count);
 }
+
+TEST(TQueue, sharded_stress) {
+  constexpr int THREAD_COUNT = 4;
+  constexpr int QUEUES_PER_THREAD = 50;
+  constexpr int OPERATIONS_PER_THREAD = 50000;
+
+  for (size_t shard_count : {static_cast<size_t>(1), static_cast<size_t>(8)}) {
+    td::ShardedTQueue tqueue(shard_count);
+    for (size_t i = 0; i < shard_count; i++) {
+      tqueue.set_shard_callback(i, td::make_unique<td::TQueueMemoryStorage>());
+    }
+
+    td::int32 now = 1000;
+    std::atomic<bool> is_finished{false};
+    td::thread gc_thread([&] {
+      while (!is_finished) {
+        tqueue.run_gc(now);
+        td::usleep_for(100);
+      }
+    });
+
+    auto start_time = td::Time::now();
+    td::vector<td::thread> threads;
+    for (int thread_id = 0; thread_id < THREAD_COUNT; thread_id++) {
+      threads.emplace_back([&, thread_id] {
+        td::Random::Xorshift128plus rnd(thread_id);
+        td::TQueue::Event events[10];
+        td::vector<int> pushed_count(QUEUES_PER_THREAD);
+        td::vector<int> received_count(QUEUES_PER_THREAD);
+        for (int i = 0; i < OPERATIONS_PER_THREAD; i++) {
+          auto queue_index = rnd.fast(0, QUEUES_PER_THREAD - 1);
+          td::TQueue::QueueId queue_id = thread_id * QUEUES_PER_THREAD + queue_index + 1;
+          if (rnd.fast(0, 2) != 0) {
+            auto data = PSTRING() << queue_id << ' ' << pushed_count[queue_index]++;
+            tqueue.push(queue_id, data, now + 1000, 0, td::TQueue::EventId()).ensure();
+          } else {
+            // receive events and acknowledge them like a bot does
+            td::MutableSpan<td::TQueue::Event> events_span(events, 10);
+            tqueue.get(queue_id, tqueue.get_head(queue_id), false, now, events_span).ensure();
+            for (auto &event : events_span) {
+              ASSERT_STREQ(PSLICE() << queue_id << ' ' << received_count[queue_index]++, event.data);
+            }
+            if (!events_span.empty()) {
+              tqueue.forget(queue_id, events_span.back().id);
+              tqueue.get(queue_id, events_span.back().id.next().move_as_ok(), true, now, events_span).ensure();
+            }
+          }
+        }
+        for (int queue_index = 0; queue_index < QUEUES_PER_THREAD; queue_index++) {
+          td::TQueue::QueueId queue_id = thread_id * QUEUES_PER_THREAD + queue_index + 1;
+          ASSERT_EQ(static_cast<size_t>(pushed_count[queue_index] - received_count[queue_index]),
+                    tqueue.get_size(queue_id));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto run_time = td::Time::now() - start_time;
+    is_finished = true;
+    gc_thread.join();
+    LOG(INFO) << "Processed " << THREAD_COUNT * OPERATIONS_PER_THREAD << " operations with " << shard_count
+              << " shards and " << THREAD_COUNT << " threads in " << run_time << " seconds: "
+              << THREAD_COUNT * OPERATIONS_PER_THREAD / run_time << " operations per second";
+
+    // shard storages must restore the same queues
+    td::ShardedTQueue restored_tqueue(shard_count);
+    for (size_t i = 0; i < shard_count; i++) {
+      auto storage = td::unique_ptr<td::TQueueMemoryStorage>(
+          static_cast<td::TQueueMemoryStorage *>(tqueue.extract_shard_callback(i).release()));
+      storage->replay(restored_tqueue);
+      restored_tqueue.set_shard_callback(i, std::move(storage));
+    }
+    for (td::TQueue::QueueId queue_id = 1; queue_id <= THREAD_COUNT * QUEUES_PER_THREAD; queue_id++) {
+      ASSERT_EQ(tqueue.get_size(queue_id), restored_tqueue.get_size(queue_id));
+      ASSERT_EQ(tqueue.get_tail(queue_id), restored_tqueue.get_tail(queue_id));
+    }
+  }
+}